@@ -0,0 +1,305 @@
+//=============================================================================
+// oneka_batch.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+// A command-line batch driver for Engine.
+//
+// usage:
+//    oneka_batch [-t threads] [-b batch] [-s seed] [-r realizations] [-T trace] scenario [results]
+//
+// Reads the sites of a scenario file (see scenario.h), runs Engine for 
+// each, and writes one result line per site, in file order, to results 
+// (default: standard output).  With -r, the realizations are written too.
+// A scenario or results name of "-" means standard input or output.
+//
+// The work is a three stage pipeline.  A reader thread parses batches of
+// sites, the main thread runs each batch on a team of "threads" OpenMP 
+// threads (EngineLanes), and a writer thread formats and writes the 
+// finished batches.  While batch i is computed, batch i+1 is parsed and 
+// batch i-1 is written, so the compute threads do not wait on the disk.
+// At most two batches are queued between stages, bounding the memory.
+//
+// With -T, a Chrome trace of the run is written at the end; it holds 
+// events only if the program was built with ONEKA_TRACING (make TRACE=1).
+//-----------------------------------------------------------------------------
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../Engine/lane_engine.h"
+#include "../Engine/trace.h"
+#include "scenario.h"
+
+using namespace oneka;
+
+namespace{
+
+   //--------------------------------------------------------------------------
+   // A bounded queue between two pipeline stages.  Pop returns false once
+   // the queue is closed and empty.
+   //--------------------------------------------------------------------------
+   template <typename T>
+   class Channel
+   {
+   public:
+      explicit Channel( std::size_t Capacity ) : m_Capacity( Capacity ), m_Closed( false ) {}
+
+      void Push( T&& x )
+      {
+         std::unique_lock<std::mutex> lock( m_Mutex );
+         m_NotFull.wait( lock, [this]{ return m_Queue.size() < m_Capacity || m_Closed; } );
+         m_Queue.push_back( std::move( x ) );
+         m_NotEmpty.notify_one();
+      }
+
+      bool Pop( T& x )
+      {
+         std::unique_lock<std::mutex> lock( m_Mutex );
+         m_NotEmpty.wait( lock, [this]{ return !m_Queue.empty() || m_Closed; } );
+         if (m_Queue.empty()) return false;
+
+         x = std::move( m_Queue.front() );
+         m_Queue.pop_front();
+         m_NotFull.notify_one();
+         return true;
+      }
+
+      void Close()
+      {
+         std::lock_guard<std::mutex> lock( m_Mutex );
+         m_Closed = true;
+         m_NotEmpty.notify_all();
+         m_NotFull.notify_all();
+      }
+
+   private:
+      std::size_t m_Capacity;
+      bool m_Closed;
+      std::deque<T> m_Queue;
+      std::mutex m_Mutex;
+      std::condition_variable m_NotEmpty;
+      std::condition_variable m_NotFull;
+   };
+
+   struct Batch
+   {
+      std::vector<Site> Sites;
+      std::vector<EngineReturn> Results;
+      std::vector<int> Status;
+   };
+
+   typedef std::unique_ptr<Batch> BatchPtr;
+
+   struct BatchOptions
+   {
+      BatchOptions() : nThreads( 0 ), BatchSize( 256 ), Seed( 0 ) {}
+
+      int nThreads;
+      int BatchSize;
+      unsigned long long Seed;
+      std::string Scenario;
+      std::string Results;
+      std::string Realizations;
+      std::string Trace;
+   };
+
+   //--------------------------------------------------------------------------
+   // The stages.
+   //--------------------------------------------------------------------------
+   void ReadStage( ScenarioReader& Reader, const BatchOptions& Options, Channel<BatchPtr>& Out, std::string& Error )
+   {
+      ONEKA_TRACE_THREAD( "reader" );
+
+      while (!Reader.AtEnd())
+      {
+         ONEKA_TRACE_SCOPE( "read batch" );
+         BatchPtr B( new Batch );
+         if( !Reader.Read( Options.BatchSize, B->Sites ) )
+         {
+            Error = Reader.Error();
+            break;
+         }
+         if (B->Sites.empty()) break;
+
+         for (std::size_t i=0; i<B->Sites.size(); ++i)
+            B->Sites[i].Request.Seed = Options.Seed;
+         Out.Push( std::move( B ) );
+      }
+      Out.Close();
+   }
+
+   void ComputeStage( const BatchOptions& Options, Channel<BatchPtr>& In, Channel<BatchPtr>& Out )
+   {
+      BatchPtr B;
+      std::vector<EngineInput> Inputs;
+
+      ONEKA_TRACE_THREAD( "compute" );
+
+      while( In.Pop( B ) )
+      {
+         ONEKA_TRACE_SCOPE( "compute batch" );
+         const std::size_t n = B->Sites.size();
+         Inputs.resize( n );
+         for (std::size_t i=0; i<n; ++i)
+            Inputs[i] = B->Sites[i].Request.Input();
+
+         EngineLanes( Inputs, B->Results, B->Status, Options.nThreads );
+         Out.Push( std::move( B ) );
+      }
+      Out.Close();
+   }
+
+   void WriteStage( std::FILE* Results, std::FILE* Realizations, Channel<BatchPtr>& In, long& nSites )
+   {
+      ONEKA_TRACE_THREAD( "writer" );
+
+      BatchPtr B;
+      while( In.Pop( B ) )
+      {
+         ONEKA_TRACE_SCOPE( "write batch" );
+         for (std::size_t i=0; i<B->Sites.size(); ++i)
+         {
+            EngineReturn& R = B->Results[i];
+            WriteResult( Results, B->Sites[i], B->Status[i], R );
+            if (Realizations != NULL)
+               WriteRealizations( Realizations, B->Sites[i], R );
+
+            if (R.a != NULL)
+            {
+               for (int j=0; j<R.nSims; ++j)
+                  delete [] R.a[j];
+               delete [] R.a;
+               R.a = NULL;
+            }
+         }
+         nSites += long( B->Sites.size() );
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   bool ParseOptions( int argc, char* argv[], BatchOptions& Options )
+   {
+      int c;
+      while ((c = ::getopt( argc, argv, "t:b:s:r:T:" )) != -1)
+      {
+         switch (c)
+         {
+         case 't': Options.nThreads = std::atoi( optarg ); break;
+         case 'b': Options.BatchSize = std::atoi( optarg ); break;
+         case 's': Options.Seed = std::strtoull( optarg, NULL, 10 ); break;
+         case 'r': Options.Realizations = optarg; break;
+         case 'T': Options.Trace = optarg; break;
+         default:  return false;
+         }
+      }
+      if (optind == argc || argc - optind > 2) return false;
+
+      Options.Scenario = argv[optind];
+      Options.Results = (argc - optind == 2) ? argv[optind+1] : "-";
+      return Options.BatchSize > 0;
+   }
+
+   std::FILE* Open( const std::string& Name, const char* Mode, std::FILE* Default )
+   {
+      if (Name == "-") return Default;
+
+      std::FILE* fp = std::fopen( Name.c_str(), Mode );
+      if (fp == NULL) std::perror( Name.c_str() );
+      return fp;
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+   BatchOptions Options;
+   if( !ParseOptions( argc, argv, Options ) )
+   {
+      std::fprintf( stderr, "usage: %s [-t threads] [-b batch] [-s seed] [-r realizations] [-T trace] scenario [results]\n", argv[0] );
+      return 2;
+   }
+
+   std::FILE* Scenario = Open( Options.Scenario, "r", stdin );
+   std::FILE* Results = Open( Options.Results, "w", stdout );
+   std::FILE* Realizations = Options.Realizations.empty() ? NULL : Open( Options.Realizations, "w", stdout );
+   if (Scenario == NULL || Results == NULL || (!Options.Realizations.empty() && Realizations == NULL)) 
+      return 1;
+
+   // Large stdio buffers keep the writer's system calls few.
+   std::setvbuf( Results, NULL, _IOFBF, 1 << 20 );
+   if (Realizations != NULL)
+      std::setvbuf( Realizations, NULL, _IOFBF, 1 << 22 );
+
+   ScenarioReader Reader( Scenario );
+   Channel<BatchPtr> Parsed( 2 );
+   Channel<BatchPtr> Computed( 2 );
+   std::string Error;
+   long nSites = 0;
+
+   std::thread reader( ReadStage, std::ref( Reader ), std::cref( Options ), std::ref( Parsed ), std::ref( Error ) );
+   std::thread writer( WriteStage, Results, Realizations, std::ref( Computed ), std::ref( nSites ) );
+
+   ComputeStage( Options, Parsed, Computed );
+
+   reader.join();
+   writer.join();
+
+   bool ok = Error.empty();
+   if (!ok)
+      std::fprintf( stderr, "%s: %s\n", Options.Scenario.c_str(), Error.c_str() );
+
+   if (Scenario != stdin) std::fclose( Scenario );
+   if (Realizations != NULL && Realizations != stdout && std::fclose( Realizations ) != 0) ok = false;
+   if (Results != stdout ? std::fclose( Results ) != 0 : std::fflush( Results ) != 0) ok = false;
+
+   if( !Options.Trace.empty() && !TraceWriteChrome( Options.Trace ) )
+   {
+      std::perror( Options.Trace.c_str() );
+      ok = false;
+   }
+
+   std::fprintf( stderr, "oneka_batch: %ld sites\n", nSites );
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+//=============================================================================
+// scenario.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "scenario.h"
+
+#include <cstdlib>
+#include <sstream>
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+ScenarioReader::ScenarioReader( std::FILE* fp )
+:  m_fp( fp ), m_Line( 0 ), m_nSites( 0 ), m_AtEnd( false )
+{
+}
+
+//-----------------------------------------------------------------------------
+// ScenarioReader::NextLine
+//
+//    Read the next line that is neither blank nor a comment.
+//-----------------------------------------------------------------------------
+bool ScenarioReader::NextLine( std::string& Line )
+{
+   char buffer[4096];
+
+   while( std::fgets( buffer, sizeof(buffer), m_fp ) != NULL )
+   {
+      ++m_Line;
+      Line = buffer;
+
+      std::string::size_type i = Line.find_first_not_of( " \t\r\n" );
+      if (i != std::string::npos && Line[i] != '#') 
+         return true;
+   }
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+bool ScenarioReader::Fail( const std::string& Message )
+{
+   std::ostringstream os;
+   os << "line " << m_Line << ": " << Message;
+   m_Error = os.str();
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+// ScenarioReader::Read
+//
+//    Read up to n sites, appending them to Sites.
+//-----------------------------------------------------------------------------
+bool ScenarioReader::Read( int n, std::vector<Site>& Sites )
+{
+   std::string Line;
+
+   for (int count=0; count<n; ++count)
+   {
+      if( !NextLine( Line ) )
+      {
+         m_AtEnd = true;
+         return true;
+      }
+
+      Sites.push_back( Site() );
+      Site& S = Sites.back();
+      EngineRequest& Q = S.Request;
+      S.Number = m_nSites++;
+
+      std::istringstream is( Line );
+      std::string key;
+      if( !(is >> key >> S.Name >> Q.k >> Q.H >> Q.Base >> Q.Xo >> Q.Yo >> Q.nSims) || key != "site" )
+         return Fail( "expected: site <name> <k> <H> <Base> <Xo> <Yo> <nSims>" );
+      if( Q.nSims <= 0 || Q.nSims > PROTOCOL_MAX_SIMS ) 
+         return Fail( "site " + S.Name + " has nSims out of range" );
+      Q.Stream = S.Number;
+
+      for(;;)
+      {
+         if( !NextLine( Line ) ) return Fail( "missing end of site " + S.Name );
+
+         std::istringstream is( Line );
+         is >> key;
+
+         double x, y, z, s;
+         if (key == "end")
+            break;
+         else if (key == "well")
+         {
+            if( !(is >> x >> y >> z) ) return Fail( "expected: well <X> <Y> <Q>" );
+            Q.Xw.push_back( x );
+            Q.Yw.push_back( y );
+            Q.Qw.push_back( z );
+         }
+         else if (key == "piezometer")
+         {
+            if( !(is >> x >> y >> z >> s) || s <= 0 ) return Fail( "expected: piezometer <X> <Y> <E> <S>, S > 0" );
+            Q.Xp.push_back( x );
+            Q.Yp.push_back( y );
+            Q.Ep.push_back( z );
+            Q.Sp.push_back( s );
+         }
+         else
+            return Fail( "unknown keyword: " + key );
+      }
+
+      if (Q.Xp.empty()) return Fail( "site " + S.Name + " has no piezometers" );
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// WriteResult
+//-----------------------------------------------------------------------------
+void WriteResult( std::FILE* fp, const Site& S, int Status, const EngineReturn& R )
+{
+   std::fprintf( fp, "%s %llu %llu %s", S.Name.c_str(), S.Request.Seed, S.Request.Stream, 
+      StatusName( Status ) );
+
+   if (Status == ENGINE_OK)
+   {
+      for (int i=0; i<6; ++i)
+         std::fprintf( fp, " %.17g", R.Mu[i] );
+      for (int i=0; i<6; ++i)
+         for (int j=i; j<6; ++j)
+            std::fprintf( fp, " %.17g", R.Cov[i][j] );
+   }
+   std::fputc( '\n', fp );
+}
+
+//-----------------------------------------------------------------------------
+// WriteRealizations
+//-----------------------------------------------------------------------------
+void WriteRealizations( std::FILE* fp, const Site& S, const EngineReturn& R )
+{
+   for (int i=0; i<R.nSims; ++i)
+   {
+      const double* a = R.a[i];
+      std::fprintf( fp, "%s %.17g %.17g %.17g %.17g %.17g %.17g\n", 
+         S.Name.c_str(), a[0], a[1], a[2], a[3], a[4], a[5] );
+   }
+}
+
+
+} // namespace oneka
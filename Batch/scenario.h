@@ -0,0 +1,109 @@
+//=============================================================================
+// scenario.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../Engine/engine_protocol.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Scenario files
+//
+//    A scenario is a text file of sites.  Each site is a block:
+//
+//       site <name> <k> <H> <Base> <Xo> <Yo> <nSims>
+//       well <X> <Y> <Q>                  (zero or more)
+//       piezometer <X> <Y> <E> <S>        (one or more)
+//       end
+//
+//    Blank lines and lines starting with '#' are ignored.  The sites are
+//    numbered from 0 in file order; a site's random number stream is its
+//    number, so its realizations do not depend on how the file is batched.
+//-----------------------------------------------------------------------------
+struct Site
+{
+   std::string Name;
+   long Number;
+   EngineRequest Request;
+};
+
+class ScenarioReader
+{
+public:
+   explicit ScenarioReader( std::FILE* fp );
+
+   // Read up to n sites; returns false on a syntax error (see Error).
+   bool Read( int n, std::vector<Site>& Sites );
+
+   bool AtEnd() const { return m_AtEnd; }
+   const std::string& Error() const { return m_Error; }
+
+private:
+   bool NextLine( std::string& Line );
+   bool Fail( const std::string& Message );
+
+   std::FILE* m_fp;
+   long m_Line;
+   long m_nSites;
+   bool m_AtEnd;
+   std::string m_Error;
+};
+
+//-----------------------------------------------------------------------------
+// Results
+//
+//    One line per site: the name, the random number seed and stream, the
+//    status (see StatusName), and if it is ok, the mean vector and the 
+//    upper triangle of the covariance matrix, by rows.  The seed and stream reproduce the 
+//    site's realizations, so they need not be archived.  
+//    If requested, the realizations are written to a second file, one 
+//    line per realization: the site name followed by the six coefficients.
+//-----------------------------------------------------------------------------
+void WriteResult( std::FILE* fp, const Site& S, int Status, const EngineReturn& R );
+void WriteRealizations( std::FILE* fp, const Site& S, const EngineReturn& R );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // SCENARIO_H
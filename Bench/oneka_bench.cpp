@@ -0,0 +1,414 @@
+//=============================================================================
+// oneka_bench.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+// Microbenchmarks for the Engine kernels.
+//
+// usage:
+//    oneka_bench [-m min_seconds] [-f filter] [-c]
+//
+// Each kernel is timed over a sweep of sizes.  A measurement repeats the 
+// kernel until it has run for at least min_seconds (default 0.2), and the
+// best of three measurements is reported as:
+//
+//    ns/op    wall time per call.
+//    GFLOP/s  floating point operations per second, from the nominal 
+//             operation count of the algorithm ("-" where not meaningful).
+//    GB/s     compulsory memory traffic per second: each operand read once
+//             and each result written once.
+//
+// Only kernels whose name contains the filter are run.  With -c the 
+// results are written as CSV.
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../Engine/engine_batch.h"
+#include "../Engine/gaussian.h"
+#include "../Engine/lane_engine.h"
+#include "../Engine/linear_systems.h"
+#include "../Engine/matrix.h"
+#include "../Engine/now.h"
+#include "../Engine/oneka_engine.h"
+#include "../Engine/sum_product-inl.h"
+
+using namespace oneka;
+
+namespace{
+
+   double g_MinSeconds = 0.2;
+   std::string g_Filter;
+   bool g_Csv = false;
+
+   // Results are accumulated here so the compiler cannot discard the work.
+   volatile double g_Sink = 0;
+
+   //--------------------------------------------------------------------------
+   // Time reps calls of f.
+   //--------------------------------------------------------------------------
+   template <typename F>
+   double Time( F& f, long reps )
+   {
+      double t = WallClock();
+      for (long r=0; r<reps; ++r)
+         f();
+      return WallClock() - t;
+   }
+
+   //--------------------------------------------------------------------------
+   // Measure and report one kernel at one size.
+   //
+   //    flops    operations per call (0 if not meaningful).
+   //    bytes    compulsory memory traffic per call.
+   //--------------------------------------------------------------------------
+   template <typename F>
+   void Run( const char* kernel, const std::string& size, double flops, double bytes, F f )
+   {
+      if (!g_Filter.empty() && std::string( kernel ).find( g_Filter ) == std::string::npos) return;
+
+      // Warm up, and find a repetition count that fills the minimum time.
+      long reps = 1;
+      double t = Time( f, reps );
+      while (t < 0.01*g_MinSeconds)
+      {
+         reps *= 2;
+         t = Time( f, reps );
+      }
+      reps = std::max( 1L, long( reps * g_MinSeconds / t ) );
+
+      double best = 1e300;
+      for (int trial=0; trial<3; ++trial)
+         best = std::min( best, Time( f, reps ) / reps );
+
+      const double ns = 1e9*best;
+      char gflops[32] = "-";
+      char gbytes[32] = "-";
+      if (flops > 0) std::snprintf( gflops, sizeof(gflops), "%.3f", flops/best*1e-9 );
+      if (bytes > 0) std::snprintf( gbytes, sizeof(gbytes), "%.3f", bytes/best*1e-9 );
+
+      if (g_Csv)
+         std::printf( "%s,%s,%.1f,%s,%s\n", kernel, size.c_str(), ns, gflops, gbytes );
+      else
+         std::printf( "%-26s %-18s %14.1f %10s %10s\n", kernel, size.c_str(), ns, gflops, gbytes );
+      std::fflush( stdout );
+   }
+
+   std::string Size( int m, int n = 0, int k = 0 )
+   {
+      char s[64];
+      if (k > 0)      std::snprintf( s, sizeof(s), "%dx%dx%d", m, n, k );
+      else if (n > 0) std::snprintf( s, sizeof(s), "%dx%d", m, n );
+      else            std::snprintf( s, sizeof(s), "%d", m );
+      return s;
+   }
+
+   //--------------------------------------------------------------------------
+   // Test data.
+   //--------------------------------------------------------------------------
+   RandomStream g_Random( 20110718 );
+
+   void Fill( Matrix& A, int m, int n )
+   {
+      GaussianRNG( g_Random, m, n, A );
+   }
+
+   // A well conditioned symmetric positive definite matrix.
+   void FillSPD( Matrix& A, int n )
+   {
+      Matrix M;
+      Fill( M, n, n );
+      Multiply_MtM( M, M, A );
+      for (int i=0; i<n; ++i)
+         A(i,i) += n;
+   }
+
+   //--------------------------------------------------------------------------
+   // A synthetic site: W wells near the origin, P piezometers on a ring,
+   // and heads from a uniform flow plus the wells.
+   //--------------------------------------------------------------------------
+   struct Site
+   {
+      Site( int W, int P, int nSims, int id ) 
+      :  Xw( W ), Yw( W ), Qw( W ), Xp( P ), Yp( P ), Ep( P ), Sp( P, 0.5 )
+      {
+         for (int w=0; w<W; ++w)
+         {
+            Xw[w] = 20.0*w;
+            Yw[w] = -10.0*w;
+            Qw[w] = 30.0/(w+1);
+         }
+         for (int p=0; p<P; ++p)
+         {
+            double theta = 6.283185307179586*p/P;
+            double r = 100 + 50*(p % 3);
+            Xp[p] = r*std::cos( theta );
+            Yp[p] = r*std::sin( theta );
+            Ep[p] = 50 - 0.01*Xp[p] + 0.005*Yp[p] + 0.1*g_Random.Gaussian();
+         }
+
+         In.k = 1.0;
+         In.H = 50;
+         In.Base = 0;
+         In.Xo = 0;
+         In.Yo = 0;
+         In.W = W;
+         In.Xw = W > 0 ? &Xw[0] : NULL;
+         In.Yw = W > 0 ? &Yw[0] : NULL;
+         In.Qw = W > 0 ? &Qw[0] : NULL;
+         In.P = P;
+         In.Xp = &Xp[0];
+         In.Yp = &Yp[0];
+         In.Ep = &Ep[0];
+         In.Sp = &Sp[0];
+         In.nSims = nSims;
+         In.Seed = 1;
+         In.Stream = id;
+      }
+
+      std::vector<double> Xw, Yw, Qw, Xp, Yp, Ep, Sp;
+      EngineInput In;
+   };
+
+   void Free( EngineReturn& S )
+   {
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+
+   //--------------------------------------------------------------------------
+   // The suites.
+   //--------------------------------------------------------------------------
+   void SumProducts()
+   {
+      const int sizes[] = { 6, 64, 1024, 65536 };
+      const int strides[] = { 1, 2, 8 };
+
+      for (int s=0; s<4; ++s)
+      {
+         const int n = sizes[s];
+         std::vector<double> x( 8*n ), y( 8*n );
+         for (int i=0; i<8*n; ++i)
+         {
+            x[i] = g_Random.Gaussian();
+            y[i] = g_Random.Gaussian();
+         }
+         const double* px = &x[0];
+         const double* py = &y[0];
+
+         Run( "SumProduct(x,y)", Size( n ), 2.0*n, 16.0*n, [=]{ g_Sink += SumProduct( n, px, py ); } );
+         Run( "SumProduct(x)", Size( n ), 2.0*n, 8.0*n, [=]{ g_Sink += SumProduct( n, px ); } );
+
+         for (int d=0; d<3; ++d)
+         {
+            const int k = strides[d];
+            const std::string size = Size( n ) + " stride " + Size( k );
+            Run( "SumProduct(x,dx,y,dy)", size, 2.0*n, 16.0*n, [=]{ g_Sink += SumProduct( n, px, k, py, k ); } );
+            Run( "SumProduct(x,y,dy)", size, 2.0*n, 16.0*n, [=]{ g_Sink += SumProduct( n, px, py, k ); } );
+            Run( "SumProduct(x,dx,y)", size, 2.0*n, 16.0*n, [=]{ g_Sink += SumProduct( n, px, k, py ); } );
+            Run( "SumProduct(x,dx)", size, 2.0*n, 8.0*n, [=]{ g_Sink += SumProduct( n, px, k ); } );
+         }
+      }
+   }
+
+   void Multiplies()
+   {
+      // Square, and the tall-skinny shapes of the Oneka normal equations.
+      const int shapes[][2] = { {6,6}, {32,32}, {128,128}, {256,256}, {10,6}, {100,6}, {1000,6}, {10000,6} };
+
+      for (int s=0; s<8; ++s)
+      {
+         const int m = shapes[s][0];
+         const int n = shapes[s][1];
+         Matrix A, B, C;
+
+         // C(n x n) = A'B with A, B (m x n).
+         Fill( A, m, n );
+         Fill( B, m, n );
+         Run( "Multiply_MtM", Size( m, n ), 2.0*m*n*n, 8.0*(2*m*n + n*n), [&]{ Multiply_MtM( A, B, C ); } );
+
+         // C(m x m) = AB' with A, B (m x n), for small m only.
+         if (m <= 1000)
+            Run( "Multiply_MMt", Size( m, n ), 2.0*m*m*n, 8.0*(2*m*n + m*m), [&]{ Multiply_MMt( A, B, C ); } );
+
+         // C(m x n) = AB with A (m x n), B (n x n).
+         Matrix Bs;
+         Fill( Bs, n, n );
+         Run( "Multiply_MM", Size( m, n, n ), 2.0*m*n*n, 8.0*(m*n + n*n + m*n), [&]{ Multiply_MM( A, Bs, C ); } );
+
+         // C(n x m) = A'B' with A (m x n), B (m x m), for square shapes.
+         if (m == n)
+            Run( "Multiply_MtMt", Size( m, n ), 2.0*m*n*n, 8.0*3*m*n, [&]{ Multiply_MtMt( A, Bs, C ); } );
+
+         Run( "Transpose", Size( m, n ), 0, 16.0*m*n, [&]{ Transpose( A, C ); } );
+      }
+   }
+
+   void LinearSystems()
+   {
+      const int sizes[] = { 6, 16, 64, 256 };
+      for (int s=0; s<4; ++s)
+      {
+         const int n = sizes[s];
+         Matrix A, L, Ainv;
+         FillSPD( A, n );
+
+         Run( "CholeskyDecomposition", Size( n ), n*double(n)*n/3, 16.0*n*n, [&]{ g_Sink += CholeskyDecomposition( A, L ); } );
+         Run( "RSPDInv", Size( n ), double(n)*n*n, 16.0*n*n, [&]{ g_Sink += RSPDInv( A, Ainv ); } );
+      }
+
+      const int shapes[][2] = { {10,6}, {100,6}, {1000,6}, {10000,6}, {256,64} };
+      for (int s=0; s<5; ++s)
+      {
+         const int m = shapes[s][0];
+         const int n = shapes[s][1];
+         Matrix A, b, X;
+         Fill( A, m, n );
+         Fill( b, m, 1 );
+
+         Run( "LeastSquaresSolve", Size( m, n ), 2.0*m*n*n, 8.0*(m*n + m + n), [&]{ g_Sink += LeastSquaresSolve( A, b, X ); } );
+      }
+
+      const int rows[] = { 100, 4096, 100000 };
+      for (int s=0; s<3; ++s)
+      {
+         const int m = rows[s];
+         Matrix Z, U, Mu, X;
+         Fill( Z, m, 6 );
+         Fill( U, 6, 6 );
+         Fill( Mu, 1, 6 );
+
+         Run( "AffineTransformation", Size( m, 6 ), 2.0*m*36, 8.0*2*m*6, [&]{ AffineTransformation( Z, U, Mu, X ); } );
+      }
+   }
+
+   void Gaussians()
+   {
+      const int rows[] = { 100, 4096, 100000 };
+      for (int s=0; s<3; ++s)
+      {
+         const int m = rows[s];
+         Matrix Z, X, Mu( 1, 6 ), Sigma;
+         FillSPD( Sigma, 6 );
+         RandomStream R( 7 );
+
+         Run( "GaussianRNG (global)", Size( m, 6 ), 0, 8.0*m*6, [&]{ GaussianRNG( m, 6, Z ); } );
+         Run( "GaussianRNG (stream)", Size( m, 6 ), 0, 8.0*m*6, [&]{ GaussianRNG( R, m, 6, Z ); } );
+         Run( "MVNormalRNG (global)", Size( m, 6 ), 2.0*m*36, 8.0*m*6, [&]{ MVNormalRNG( m, Mu, Sigma, X ); } );
+         Run( "MVNormalRNG (stream)", Size( m, 6 ), 2.0*m*36, 8.0*m*6, [&]{ MVNormalRNG( R, m, Mu, Sigma, X ); } );
+      }
+
+      double x = -4;
+      Run( "GaussianCDF", "1", 0, 0, [&]{ g_Sink += GaussianCDF( x ); x = (x > 4) ? -4 : x + 0.001; } );
+   }
+
+   void Engines()
+   {
+      const int shapes[][3] = { {1,8,1000}, {1,100,1000}, {2,1000,1000}, {1,8,100000}, {2,100,100000} };
+      for (int s=0; s<5; ++s)
+      {
+         Site S( shapes[s][0], shapes[s][1], shapes[s][2], s );
+         EngineWorkspace Work;
+
+         Run( "Engine", Size( shapes[s][0], shapes[s][1], shapes[s][2] ) + " WxPxN", 0, 48.0*shapes[s][2], 
+            [&]{ EngineReturn R = Engine( S.In, &Work ); g_Sink += R.Mu[0]; Free( R ); } );
+      }
+
+      // Many small sites.
+      const int nSites = 256;
+      std::vector<Site*> Sites;
+      std::vector<EngineInput> Inputs;
+      for (int i=0; i<nSites; ++i)
+      {
+         Sites.push_back( new Site( 1, 8 + (i % 8), 100, i ) );
+         Inputs.push_back( Sites.back()->In );
+      }
+
+      std::vector<EngineReturn> Results;
+      std::vector<int> Status;
+      const std::string size = Size( nSites ) + " sites";
+
+      Run( "EngineBatch", size, 0, 48.0*100*nSites, [&]{ 
+         EngineBatch( Inputs, Results, Status ); 
+         for (int i=0; i<nSites; ++i) Free( Results[i] ); } );
+      Run( "EngineLanes", size, 0, 48.0*100*nSites, [&]{ 
+         EngineLanes( Inputs, Results, Status ); 
+         for (int i=0; i<nSites; ++i) Free( Results[i] ); } );
+
+      for (int i=0; i<nSites; ++i)
+         delete Sites[i];
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+   int c;
+   while ((c = ::getopt( argc, argv, "m:f:c" )) != -1)
+   {
+      switch (c)
+      {
+      case 'm': g_MinSeconds = std::atof( optarg ); break;
+      case 'f': g_Filter = optarg; break;
+      case 'c': g_Csv = true; break;
+      default:
+         std::fprintf( stderr, "usage: %s [-m min_seconds] [-f filter] [-c]\n", argv[0] );
+         return 2;
+      }
+   }
+
+   if (g_Csv)
+      std::printf( "kernel,size,ns_per_op,gflops,gbytes_per_s\n" );
+   else
+      std::printf( "%-26s %-18s %14s %10s %10s\n", "kernel", "size", "ns/op", "GFLOP/s", "GB/s" );
+
+   InitializeRNG( 1 );
+   SumProducts();
+   Multiplies();
+   LinearSystems();
+   Gaussians();
+   Engines();
+
+   return 0;
+}
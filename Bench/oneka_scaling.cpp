@@ -0,0 +1,349 @@
+//=============================================================================
+// oneka_scaling.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+// Scaling benchmark for Engine on synthetic sites.
+//
+// usage:
+//    oneka_scaling [-P max_piezometers] [-W max_wells] [-N max_sims] 
+//                  [-s sites] [-t max_threads] [-r repetitions] 
+//                  [-k sweeps] [-o output.json]
+//
+// The sweeps (-k, any of "pwnsk", default all) are:
+//
+//    p  piezometers:   P = 10, 100, ... max_piezometers (1 well, 1000 sims).
+//    w  wells:         W = 0, 1, 10, ... max_wells (1000 piezometers, 1000 sims).
+//    n  realizations:  nSims = 1, 10, ... max_sims (100 piezometers, 1 well).
+//    s  strong:        EngineBatch on a fixed set of sites, on 1, 2, 4, ... 
+//                      max_threads threads.
+//    k  weak:          as strong, with the number of sites proportional to
+//                      the number of threads.
+//
+// Every run reports the best wall time 
+// of the repetitions, the Matrix memory allocated by Engine, the size of 
+// the realizations, the peak resident set of the process so far, and the 
+// accuracy of the fit against the true coefficients (see synthetic_site.h).
+// The report is JSON, to stdout or to the output file.
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../Engine/engine_batch.h"
+#include "../Engine/now.h"
+#include "../Engine/synthetic_site.h"
+#include "../Engine/version.h"
+
+using namespace oneka;
+
+namespace{
+
+   struct Options
+   {
+      Options() : MaxP( 1000000 ), MaxW( 10000 ), MaxN( 1000000 ), nSites( 64 ), MaxThreads( omp_get_max_threads() ), Reps( 3 ), Sweeps( "pwnsk" ) {}
+
+      long MaxP;
+      long MaxW;
+      long MaxN;
+      int nSites;
+      int MaxThreads;
+      int Reps;
+      std::string Sweeps;
+   };
+
+   //--------------------------------------------------------------------------
+   // One measurement.
+   //--------------------------------------------------------------------------
+   struct Run
+   {
+      Run() : P( 0 ), W( 0 ), nSims( 0 ), Sites( 1 ), Threads( 1 ), Seconds( 0 ), GenerateSeconds( 0 ), 
+              AllocatedBytes( 0 ), OutputBytes( 0 ), PeakRSS( 0 ), Failed( 0 ), 
+              Mahalanobis( 0 ), MaxZ( 0 ), SampleZ( 0 ), MaxAbsError( 0 ) {}
+
+      std::string Sweep;
+      long P, W, nSims;
+      int Sites, Threads;
+
+      double Seconds;            // best wall time of the repetitions [s].
+      double GenerateSeconds;    // time to build the synthetic sites [s].
+
+      long long AllocatedBytes;  // Matrix memory allocated by Engine, over all sites.
+      long long OutputBytes;     // size of the realizations, over all sites.
+      long PeakRSS;              // peak resident set of the process [kB].
+
+      int Failed;                // sites for which Engine threw.
+      double Mahalanobis;        // mean over the sites.
+      double MaxZ;               // max over the sites.
+      double SampleZ;            // max over the sites.
+      double MaxAbsError;        // max over the sites.
+   };
+
+   long PeakRSS()
+   {
+      struct rusage u;
+      ::getrusage( RUSAGE_SELF, &u );
+      return u.ru_maxrss;
+   }
+
+   void Free( EngineReturn& S )
+   {
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+
+   //--------------------------------------------------------------------------
+   // Measure Engine on nSites sites built from Spec, each with its own 
+   // seed, with EngineBatch on nThreads threads.
+   //--------------------------------------------------------------------------
+   Run Measure( const char* sweep, const SyntheticSpec& Spec, int nSites, int nThreads, int Reps )
+   {
+      Run R;
+      R.Sweep = sweep;
+      R.P = Spec.P;
+      R.W = Spec.W;
+      R.nSims = Spec.nSims;
+      R.Sites = nSites;
+      R.Threads = nThreads;
+
+      double t = WallClock();
+      std::vector<SyntheticSpec> Specs( nSites, Spec );
+      std::vector<EngineRequest> Requests( nSites );
+      std::vector<EngineInput> Inputs( nSites );
+      for (int i=0; i<nSites; ++i)
+      {
+         Specs[i].Seed = Spec.Seed + i;
+         SyntheticSite( Specs[i], Requests[i] );
+         Inputs[i] = Requests[i].Input();
+         Inputs[i].Options.Instrument = true;
+      }
+      R.GenerateSeconds = WallClock() - t;
+
+      R.Seconds = 1e300;
+      for (int rep=0; rep<Reps; ++rep)
+      {
+         std::vector<EngineReturn> Results;
+         std::vector<int> Status;
+
+         t = WallClock();
+         if (nSites == 1 && nThreads == 1)
+         {
+            // A single site is run directly, without the batch machinery.
+            Results.resize( 1 );
+            Status.assign( 1, ENGINE_OK );
+            try
+            {
+               Results[0] = Engine( Inputs[0] );
+            }
+            catch( Exception_SingularSystem& )
+            {
+               Status[0] = ENGINE_SINGULAR;
+            }
+         }
+         else
+            EngineBatch( Inputs, Results, Status, nThreads );
+         R.Seconds = std::min( R.Seconds, WallClock() - t );
+
+         // The results are identical on every repetition; score the last.
+         const bool last = ( rep == Reps-1 );
+         if (last)
+         {
+            R.Failed = 0;
+            int nOk = 0;
+            for (int i=0; i<nSites; ++i)
+            {
+               if (Status[i] != ENGINE_OK) { ++R.Failed; continue; }
+               ++nOk;
+
+               SyntheticAccuracy A = Accuracy( Specs[i], Results[i] );
+               R.Mahalanobis += A.Mahalanobis;
+               R.MaxZ        = std::max( R.MaxZ, A.MaxZ );
+               R.SampleZ     = std::max( R.SampleZ, A.SampleZ );
+               R.MaxAbsError = std::max( R.MaxAbsError, A.MaxAbsError );
+
+               R.AllocatedBytes += Results[i].Instrumentation.AllocatedBytes;
+               R.OutputBytes    += 6LL * sizeof(double) * Results[i].nSims;
+            }
+            if (nOk > 0) R.Mahalanobis /= nOk;
+         }
+
+         for (int i=0; i<nSites; ++i)
+            if (Status[i] == ENGINE_OK) Free( Results[i] );
+      }
+
+      R.PeakRSS = PeakRSS();
+      return R;
+   }
+
+   //--------------------------------------------------------------------------
+   // Reporting.
+   //--------------------------------------------------------------------------
+   void WriteRun( std::FILE* f, const Run& R, double base, bool first )
+   {
+      // Speedup and efficiency against the one thread run of the sweep.
+      double speedup = 0, efficiency = 0;
+      if (base > 0 && R.Seconds > 0)
+      {
+         speedup = base / R.Seconds;
+         if (R.Sweep == "weak") speedup *= R.Threads;
+         efficiency = speedup / R.Threads;
+      }
+
+      std::fprintf( f, "%s\n    {\"sweep\": \"%s\", \"P\": %ld, \"W\": %ld, \"nSims\": %ld, \"sites\": %d, \"threads\": %d,\n", 
+         first ? "" : ",", R.Sweep.c_str(), R.P, R.W, R.nSims, R.Sites, R.Threads );
+      std::fprintf( f, "     \"seconds\": %.6g, \"generate_seconds\": %.6g, \"speedup\": %.4g, \"efficiency\": %.4g,\n", 
+         R.Seconds, R.GenerateSeconds, speedup, efficiency );
+      std::fprintf( f, "     \"allocated_bytes\": %lld, \"output_bytes\": %lld, \"peak_rss_kb\": %ld,\n", 
+         R.AllocatedBytes, R.OutputBytes, R.PeakRSS );
+      std::fprintf( f, "     \"failed\": %d, \"mahalanobis\": %.6g, \"max_z\": %.6g, \"sample_z\": %.6g, \"max_abs_error\": %.6g}", 
+         R.Failed, R.Mahalanobis, R.MaxZ, R.SampleZ, R.MaxAbsError );
+      std::fflush( f );
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+   Options Opt;
+   const char* output = NULL;
+
+   int c;
+   while ((c = ::getopt( argc, argv, "P:W:N:s:t:r:k:o:" )) != -1)
+   {
+      switch (c)
+      {
+      case 'P': Opt.MaxP = long( std::atof( optarg ) ); break;
+      case 'W': Opt.MaxW = long( std::atof( optarg ) ); break;
+      case 'N': Opt.MaxN = long( std::atof( optarg ) ); break;
+      case 's': Opt.nSites = std::atoi( optarg ); break;
+      case 't': Opt.MaxThreads = std::atoi( optarg ); break;
+      case 'r': Opt.Reps = std::max( 1, std::atoi( optarg ) ); break;
+      case 'k': Opt.Sweeps = optarg; break;
+      case 'o': output = optarg; break;
+      default:
+         std::fprintf( stderr, "usage: %s [-P max_piezometers] [-W max_wells] [-N max_sims] [-s sites] "
+                               "[-t max_threads] [-r repetitions] [-k pwnsk] [-o output.json]\n", argv[0] );
+         return 2;
+      }
+   }
+
+   std::FILE* f = stdout;
+   if (output != NULL && (f = std::fopen( output, "w" )) == NULL)
+   {
+      std::fprintf( stderr, "cannot open %s\n", output );
+      return 1;
+   }
+
+   char host[256] = "unknown";
+   ::gethostname( host, sizeof(host) - 1 );
+
+   std::fprintf( f, "{\n  \"engine_version\": \"%s\",\n  \"date\": \"%s\",\n  \"host\": \"%s\",\n", 
+      EngineVersion().c_str(), Now().c_str(), host );
+#ifdef __VERSION__
+   std::fprintf( f, "  \"compiler\": \"%s\",\n", __VERSION__ );
+#endif
+   std::fprintf( f, "  \"max_threads\": %d,\n  \"repetitions\": %d,\n  \"runs\": [", Opt.MaxThreads, Opt.Reps );
+
+   bool first = true;
+   if (Opt.Sweeps.find( 'p' ) != std::string::npos)
+   {
+      for (long P=10; P<=Opt.MaxP; P*=10)
+      {
+         SyntheticSpec Spec;
+         Spec.P = int( P );
+         WriteRun( f, Measure( "piezometers", Spec, 1, 1, Opt.Reps ), 0, first );
+         first = false;
+      }
+   }
+
+   if (Opt.Sweeps.find( 'w' ) != std::string::npos)
+   {
+      for (long W=0; W<=Opt.MaxW; W = (W == 0) ? 1 : 10*W)
+      {
+         SyntheticSpec Spec;
+         Spec.W = int( W );
+         Spec.P = 1000;
+         WriteRun( f, Measure( "wells", Spec, 1, 1, Opt.Reps ), 0, first );
+         first = false;
+      }
+   }
+
+   if (Opt.Sweeps.find( 'n' ) != std::string::npos)
+   {
+      for (long N=1; N<=Opt.MaxN; N*=10)
+      {
+         SyntheticSpec Spec;
+         Spec.nSims = int( N );
+         WriteRun( f, Measure( "realizations", Spec, 1, 1, Opt.Reps ), 0, first );
+         first = false;
+      }
+   }
+
+   // Strong and weak scaling, over EngineBatch.
+   SyntheticSpec Batch;
+   Batch.W = 2;
+   Batch.nSims = 10000;
+
+   for (int k=0; k<2; ++k)
+   {
+      const bool weak = ( k == 1 );
+      if (Opt.Sweeps.find( weak ? 'k' : 's' ) == std::string::npos) continue;
+
+      double base = 0;
+      for (int t=1; ; t = std::min( 2*t, Opt.MaxThreads ))
+      {
+         int nSites = weak ? std::max( 1, Opt.nSites/Opt.MaxThreads ) * t : Opt.nSites;
+         Run R = Measure( weak ? "weak" : "strong", Batch, nSites, t, Opt.Reps );
+         if (t == 1) base = R.Seconds;
+
+         WriteRun( f, R, base, first );
+         first = false;
+         if (t == Opt.MaxThreads) break;
+      }
+   }
+
+   std::fprintf( f, "\n  ]\n}\n" );
+   if (f != stdout) std::fclose( f );
+
+   return 0;
+}
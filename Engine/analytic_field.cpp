@@ -0,0 +1,172 @@
+//=============================================================================
+// analytic_field.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analytic_field.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "gaussian.h"
+#include "oneka_model.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// AnalyticHeads
+//
+// Arguments:
+//    S           the evaluation points.
+//    k           hydraulic conductivity [L/T].
+//    H           aquifer thickness [L].
+//    Base        elevation of the aquifer base [L].
+//    Mu          mean vector of the coefficients, as in EngineReturn.
+//    Cov         covariance matrix of the coefficients, as in EngineReturn.
+//    nThresholds number of head thresholds [#].
+//    Thresholds  (nThresholds x 1) array of head elevation thresholds [L].
+//    F           on exit, the analytic statistics at every point in S.
+//
+// Notes:
+// o  The variance g'Cov g is computed for all points in one pass, using
+//    the symmetry of Cov: 6 squares and 15 doubled cross products.
+//
+// o  The mean and standard deviation of the head are first-order (delta
+//    method) approximations through the Phi-to-head conversion, 
+//
+//       dh/dPhi = 1/(k H)           confined,
+//       dh/dPhi = 1/sqrt(2 k Phi)   unconfined.
+//
+// o  The head is a monotone function of Phi, so the exceedance 
+//    probabilities are exact for Normal Phi:
+//
+//       P( h > t ) = P( Phi > HeadToPhi(t) ).
+//
+//    A threshold below Base is always exceeded.  At Base the head exceeds
+//    it exactly when the aquifer is wet, P( Phi > 0 ).
+//-----------------------------------------------------------------------------
+void AnalyticHeads( 
+   const PointSet& S, double k, double H, double Base,
+   const double Mu[6], const double Cov[6][6],
+   int nThresholds, const double* Thresholds,
+   AnalyticField& F )
+{
+   assert( S.nPoints() > 0 );
+   assert( nThresholds >= 0 );
+
+   const int N = S.nPoints();
+
+   F.MeanPhi.Resize( 1, N );
+   F.StdPhi.Resize( 1, N );
+   F.MeanHead.Resize( 1, N );
+   F.StdHead.Resize( 1, N );
+   F.Exceedance.Resize( nThresholds, N );
+
+   // The symmetric covariance with the off-diagonal terms doubled.
+   double C[6][6];
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         C[i][j] = (i == j) ? Cov[i][i] : Cov[i][j] + Cov[j][i];
+
+   // The potentials corresponding to the thresholds.
+   Matrix PhiT( 1, (nThresholds > 0) ? nThresholds : 1 );
+   for (int t=0; t<nThresholds; ++t)
+      PhiT(0,t) = HeadToPhi( Thresholds[t], k, H, Base );
+
+   const double* g0 = S.Basis(0);
+   const double* g1 = S.Basis(1);
+   const double* g2 = S.Basis(2);
+   const double* g3 = S.Basis(3);
+   const double* g4 = S.Basis(4);
+   const double* w  = S.Phiw();
+
+   double* mean = F.MeanPhi.Base();
+   double* std  = F.StdPhi.Base();
+
+   // The batched mean and quadratic form.
+   #pragma omp parallel for schedule(static)
+   for (int j=0; j<N; ++j)
+   {
+      const double g[6] = { g0[j], g1[j], g2[j], g3[j], g4[j], 1.0 };
+
+      double m = w[j];
+      double v = 0;
+      for (int r=0; r<6; ++r)
+      {
+         m += Mu[r]*g[r];
+
+         double s = 0;
+         for (int c=r; c<6; ++c)
+            s += C[r][c]*g[c];
+         v += g[r]*s;
+      }
+
+      mean[j] = m;
+      std[j]  = (v > 0) ? sqrt(v) : 0;
+   }
+
+   // Heads and exceedance probabilities.
+   #pragma omp parallel for schedule(static)
+   for (int j=0; j<N; ++j)
+   {
+      double h = PhiToHead( mean[j], k, H, Base );
+
+      double dhdPhi;
+      if (h - Base >= H)
+         dhdPhi = 1/(k*H);
+      else if (h > Base)
+         dhdPhi = 1/(k*(h - Base));
+      else
+         dhdPhi = 0;
+
+      F.MeanHead(0,j) = h;
+      F.StdHead(0,j)  = dhdPhi*std[j];
+
+      for (int t=0; t<nThresholds; ++t)
+      {
+         double p;
+         if (Thresholds[t] < Base)
+            p = 1;
+         else if (std[j] > 0)
+            p = 1 - GaussianCDF( (PhiT(0,t) - mean[j])/std[j] );
+         else
+            p = (mean[j] > PhiT(0,t)) ? 1 : 0;
+
+         F.Exceedance(t,j) = p;
+      }
+   }
+}
+
+
+} // namespace oneka
@@ -0,0 +1,75 @@
+//=============================================================================
+// analytic_field.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ANALYTIC_FIELD_H
+#define ANALYTIC_FIELD_H
+
+#include "matrix.h"
+#include "point_set.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The analytic counterpart of the realization-based fields.
+//
+// The discharge potential at a point is linear in the coefficients,
+//
+//    Phi = g'a + Phiw,    g = [dX^2, dY^2, dX dY, dX, dY, 1]
+//
+// so, for a ~ N(Mu, Cov), Phi is Normal with mean g'Mu + Phiw and variance
+// g'Cov g.  No realizations are required.
+//-----------------------------------------------------------------------------
+struct AnalyticField
+{
+   Matrix MeanPhi;         // (1 x N) mean discharge potential [L^3/T].
+   Matrix StdPhi;          // (1 x N) std. deviation of the discharge potential [L^3/T].
+   Matrix MeanHead;        // (1 x N) linearized mean head elevation [L].
+   Matrix StdHead;         // (1 x N) linearized std. deviation of the head [L].
+   Matrix Exceedance;      // (nThresholds x N) probability head > threshold.
+};
+
+void AnalyticHeads( 
+   const PointSet& S, double k, double H, double Base,
+   const double Mu[6], const double Cov[6][6],
+   int nThresholds, const double* Thresholds,
+   AnalyticField& F );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ANALYTIC_FIELD_H
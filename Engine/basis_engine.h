@@ -0,0 +1,280 @@
+//=============================================================================
+// basis_engine.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef BASIS_ENGINE_H
+#define BASIS_ENGINE_H
+
+#include <cmath>
+
+#include "gaussian.h"
+#include "matrix.h"
+#include "oneka_engine.h"
+#include "oneka_model.h"
+#include "triangular_factor.h"
+
+namespace oneka{
+
+//=============================================================================
+// A generic Oneka engine, templated on a compile-time list of basis 
+// functions for the regional field,
+//
+//    Phi(x,y) = sum_j a_j f_j(dX,dY) + sum_w Qw/(4 pi) log( (x-Xw)^2 + (y-Yw)^2 ).
+//
+// A basis list is built from BasisList<Head,Tail> and NullBasis; each basis
+// function is a class with a static member Value(dX,dY).  The number of
+// coefficients, N, is a compile-time constant, so the evaluation of a row,
+// the (N x N) factorization, and the sampling are all fully unrolled and 
+// use fixed-size arrays.
+//
+// The original six-coefficient model is the instantiation OnekaBasis.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Basis functions.
+//-----------------------------------------------------------------------------
+struct BasisXX  { static double Value( double dX, double dY ) { return dX*dX; } };
+struct BasisYY  { static double Value( double dX, double dY ) { return dY*dY; } };
+struct BasisXY  { static double Value( double dX, double dY ) { return dX*dY; } };
+struct BasisX   { static double Value( double dX, double dY ) { return dX; } };
+struct BasisY   { static double Value( double dX, double dY ) { return dY; } };
+struct BasisOne { static double Value( double dX, double dY ) { return 1.0; } };
+
+struct BasisXXX { static double Value( double dX, double dY ) { return dX*dX*dX; } };
+struct BasisXXY { static double Value( double dX, double dY ) { return dX*dX*dY; } };
+struct BasisXYY { static double Value( double dX, double dY ) { return dX*dY*dY; } };
+struct BasisYYY { static double Value( double dX, double dY ) { return dY*dY*dY; } };
+
+//-----------------------------------------------------------------------------
+// Basis lists.
+//-----------------------------------------------------------------------------
+struct NullBasis {};
+
+template< class Head, class Tail >
+struct BasisList {};
+
+// The number of functions in a basis list.
+template< class List > struct BasisSize;
+
+template<> 
+struct BasisSize< NullBasis > 
+{ 
+   enum { value = 0 }; 
+};
+
+template< class Head, class Tail > 
+struct BasisSize< BasisList<Head,Tail> > 
+{ 
+   enum { value = 1 + BasisSize<Tail>::value }; 
+};
+
+// Evaluate all of the functions in a basis list.
+template< class List > struct BasisEvaluator;
+
+template<> 
+struct BasisEvaluator< NullBasis >
+{
+   static void Evaluate( double, double, double* ) {}
+};
+
+template< class Head, class Tail > 
+struct BasisEvaluator< BasisList<Head,Tail> >
+{
+   static void Evaluate( double dX, double dY, double* g )
+   {
+      g[0] = Head::Value( dX, dY );
+      BasisEvaluator<Tail>::Evaluate( dX, dY, g+1 );
+   }
+};
+
+// [dX^2, dY^2, dX dY, dX, dY, 1]: the original Oneka model.
+typedef 
+   BasisList< BasisXX, 
+   BasisList< BasisYY, 
+   BasisList< BasisXY, 
+   BasisList< BasisX, 
+   BasisList< BasisY, 
+   BasisList< BasisOne, NullBasis > > > > > > OnekaBasis;
+
+// [dX, dY, 1]: uniform regional flow, no recharge.
+typedef 
+   BasisList< BasisX, 
+   BasisList< BasisY, 
+   BasisList< BasisOne, NullBasis > > > UniformFlowBasis;
+
+// The full cubic.
+typedef 
+   BasisList< BasisXXX, 
+   BasisList< BasisXXY, 
+   BasisList< BasisXYY, 
+   BasisList< BasisYYY, OnekaBasis > > > > CubicBasis;
+
+
+//-----------------------------------------------------------------------------
+// BasisFit
+//
+//    The fitted mean vector and covariance matrix of the N coefficients.
+//-----------------------------------------------------------------------------
+template< class Basis >
+struct BasisFit
+{
+   enum { N = BasisSize<Basis>::value };
+
+   double Xo;                 // x-coordinate of model origin.
+   double Yo;                 // y-coordinate of model origin.
+   double Mu[N];              // conditional mean vector of the coefficients.
+   double Cov[N][N];          // conditional covariance matrix of the coefficients.
+};
+
+
+//-----------------------------------------------------------------------------
+// FitBasis
+//
+//    Fit the model with the basis list Basis, the counterpart of Engine.
+//
+// Arguments:
+//    k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo  as for Engine.
+//
+// Notes:
+// o  Each weighted equation is computed on the fly and rotated into the
+//    (N x N) triangular factor R with Givens rotations; the (P x N) system
+//    is never formed.  Then R Mu = Q'b, and Cov = inv(R) inv(R)'.
+//
+// o  Throws Exception_SingularSystem if the piezometers do not determine
+//    the N coefficients.
+//-----------------------------------------------------------------------------
+template< class Basis >
+BasisFit<Basis> FitBasis(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   int P, const double* Xp, const double* Yp, const double* Ep, const double* Sp, 
+   double Xo, double Yo )
+{
+   enum { N = BasisSize<Basis>::value };
+
+   BasisFit<Basis> F;
+   F.Xo = Xo;
+   F.Yo = Yo;
+
+   double R[N][N];
+   double z[N];
+   for (int i=0; i<N; ++i)
+   {
+      z[i] = 0;
+      for (int j=0; j<N; ++j)
+         R[i][j] = 0;
+   }
+
+   // Rotate each equation into the factorization.
+   for (int p=0; p<P; ++p)
+   {
+      double Avg, Std;
+      PhiMoments( Ep[p], Sp[p], k, H, Base, Avg, Std );
+
+      double x[N];
+      BasisEvaluator<Basis>::Evaluate( Xp[p]-Xo, Yp[p]-Yo, x );
+      for (int j=0; j<N; ++j)
+         x[j] /= Std;
+
+      double beta = (Avg - WellPotential( Xp[p], Yp[p], W, Xw, Yw, Qw ))/Std;
+
+      GivensInsert<N>( R, z, x, beta );
+   }
+
+   if( !TriangularSolve<N>( R, z, F.Mu, F.Cov ) ) 
+      throw oneka::Exception_SingularSystem();
+
+   return F;
+}
+
+
+//-----------------------------------------------------------------------------
+// SimulateBasis
+//
+//    Generate nSims equi-probable realizations of the N coefficients, one 
+//    per row of X, as Mu + L z, where L L' = Cov and z ~ N(0,I) is drawn 
+//    from the stream R.
+//
+// Notes:
+// o  Throws Exception_SingularSystem if Cov is not positive definite.
+//-----------------------------------------------------------------------------
+template< class Basis >
+void SimulateBasis( const BasisFit<Basis>& F, int nSims, RandomStream& R, Matrix& X )
+{
+   enum { N = BasisSize<Basis>::value };
+
+   // Cholesky decomposition of the (N x N) covariance matrix.
+   double L[N][N];
+   for (int j=0; j<N; ++j)
+   {
+      double d = F.Cov[j][j];
+      for (int l=0; l<j; ++l)
+         d -= L[j][l]*L[j][l];
+      if( !(d > 0) ) throw oneka::Exception_SingularSystem();
+      L[j][j] = sqrt(d);
+
+      for (int i=j+1; i<N; ++i)
+      {
+         double s = F.Cov[i][j];
+         for (int l=0; l<j; ++l)
+            s -= L[i][l]*L[j][l];
+         L[i][j] = s/L[j][j];
+      }
+   }
+
+   X.Resize( nSims, N );
+   for (int s=0; s<nSims; ++s)
+   {
+      double z[N];
+      for (int j=0; j<N; ++j)
+         z[j] = R.Gaussian();
+
+      double* x = X.Base(s,0);
+      for (int i=0; i<N; ++i)
+      {
+         double sum = F.Mu[i];
+         for (int j=0; j<=i; ++j)
+            sum += L[i][j]*z[j];
+         x[i] = sum;
+      }
+   }
+}
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // BASIS_ENGINE_H
@@ -0,0 +1,415 @@
+//=============================================================================
+// capture_zone.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "capture_zone.h"
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace{
+   const double TWO_PI  = 6.283185307179586476925287;
+   const double FOUR_PI = 12.56637061435917295385057;
+
+   // Integration controls.  The error tolerance on each step is a fraction
+   // of the capture radius; no step may cover more than a fraction of the 
+   // distance to the nearest pumping well.
+   const double RELATIVE_TOLERANCE = 0.01;
+   const double WELL_STEP_FRACTION = 0.5;
+   const int    MAX_ITERATIONS     = 100000;
+
+   //--------------------------------------------------------------------------
+   // The aquifer and wells, as given to CaptureProbability.
+   //--------------------------------------------------------------------------
+   struct Aquifer
+   {
+      double k, H, Porosity;
+      int W;
+      const double* Xw;
+      const double* Yw;
+      const double* Qw;
+      double Xo, Yo;
+   };
+
+   //--------------------------------------------------------------------------
+   // Velocity
+   //
+   //    Compute the seepage velocity at n points for the coefficients a.  The 
+   //    well contributions are accumulated well by well, so the inner loops
+   //    run over the contiguous particle arrays.  Where the aquifer is dry 
+   //    the velocity is set to zero and wet[j] = 0.
+   //--------------------------------------------------------------------------
+   void Velocity( 
+      const Aquifer& Q, const double* a, int n, 
+      const double* x, const double* y, 
+      double* vx, double* vy, double* phi, char* wet )
+   {
+      const double A = a[0], B = a[1], C = a[2], D = a[3], E = a[4], F = a[5];
+
+      for (int j=0; j<n; ++j)
+      {
+         double dX = x[j] - Q.Xo;
+         double dY = y[j] - Q.Yo;
+
+         phi[j] = A*dX*dX + B*dY*dY + C*dX*dY + D*dX + E*dY + F;
+         vx[j]  = 2*A*dX + C*dY + D;
+         vy[j]  = 2*B*dY + C*dX + E;
+      }
+
+      for (int w=0; w<Q.W; ++w)
+      {
+         const double xw = Q.Xw[w];
+         const double yw = Q.Yw[w];
+         const double cg = Q.Qw[w]/TWO_PI;
+         const double cp = Q.Qw[w]/FOUR_PI;
+
+         for (int j=0; j<n; ++j)
+         {
+            double dx = x[j] - xw;
+            double dy = y[j] - yw;
+            double r2 = dx*dx + dy*dy;
+
+            vx[j]  += cg*dx/r2;
+            vy[j]  += cg*dy/r2;
+            phi[j] += cp*log(r2);
+         }
+      }
+
+      const double PhiC = 0.5*Q.k*Q.H*Q.H;
+
+      for (int j=0; j<n; ++j)
+      {
+         double b;
+         if (phi[j] >= PhiC)
+            b = Q.H;
+         else if (phi[j] > 0)
+            b = sqrt( 2*phi[j]/Q.k );
+         else
+            b = 0;
+
+         wet[j] = (b > 0) ? 1 : 0;
+
+         double s = (b > 0) ? -1/(Q.Porosity*b) : 0;
+         vx[j] *= s;
+         vy[j] *= s;
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // NearestWell
+   //
+   //    Return the index of the pumping well nearest to (x,y), and its 
+   //    distance in d; -1 if there are no pumping wells.
+   //--------------------------------------------------------------------------
+   int NearestWell( const Aquifer& Q, double x, double y, double& d )
+   {
+      int nearest = -1;
+      double d2 = 0;
+
+      for (int w=0; w<Q.W; ++w)
+      {
+         if (Q.Qw[w] <= 0) continue;
+
+         double dx = x - Q.Xw[w];
+         double dy = y - Q.Yw[w];
+         double r2 = dx*dx + dy*dy;
+
+         if (nearest < 0 || r2 < d2)
+         {
+            nearest = w;
+            d2 = r2;
+         }
+      }
+
+      d = sqrt(d2);
+      return nearest;
+   }
+
+   //--------------------------------------------------------------------------
+   // Swarm
+   //
+   //    The state of the active particles, stored as a structure of arrays.
+   //    Finished particles are removed by moving the last active particle
+   //    into their slot, so the active particles are always [0,n).
+   //--------------------------------------------------------------------------
+   struct Swarm
+   {
+      int n;
+      std::vector<int> id;
+      std::vector<double> x, y, t, dt, k1x, k1y;
+
+      explicit Swarm( int N )
+      :  n( N ), id( N ), x( N ), y( N ), t( N ), dt( N ), k1x( N ), k1y( N )
+      {
+      }
+
+      void Remove( int j )
+      {
+         --n;
+         id[j] = id[n];   x[j] = x[n];     y[j] = y[n];
+         t[j] = t[n];     dt[j] = dt[n];
+         k1x[j] = k1x[n]; k1y[j] = k1y[n];
+      }
+   };
+
+   //--------------------------------------------------------------------------
+   // TrackRealization
+   //
+   //    Track one particle from every point of S for the coefficients a, 
+   //    using the Bogacki-Shampine 3(2) embedded Runge-Kutta pair with a 
+   //    separate adaptive step for each particle.  Each stage is evaluated 
+   //    for all of the active particles at once.  On exit, captured[j] = 1 
+   //    if the particle released at point j reached the target well.
+   //
+   // References:
+   // o  Bogacki, P., and L.F. Shampine, 1989, A 3(2) Pair of Runge-Kutta 
+   //    Formulas, Applied Mathematics Letters, v. 2, n. 4, pp. 321-325.
+   //--------------------------------------------------------------------------
+   void TrackRealization( 
+      const Aquifer& Q, const double* a, const oneka::PointSet& S,
+      int Target, double Radius, double Duration, 
+      std::vector<char>& captured )
+   {
+      const int N = S.nPoints();
+      const double tol = RELATIVE_TOLERANCE*Radius;
+
+      Swarm P( N );
+      std::vector<double> xs( N ), ys( N ), xn( N ), yn( N ), phi( N );
+      std::vector<double> k2x( N ), k2y( N ), k3x( N ), k3y( N ), k4x( N ), k4y( N );
+      std::vector<char> wet( N );
+
+      for (int j=0; j<N; ++j)
+      {
+         P.id[j] = j;
+         P.x[j] = S.X()[j];
+         P.y[j] = S.Y()[j];
+         P.t[j] = 0;
+         captured[j] = 0;
+      }
+
+      Velocity( Q, a, N, &P.x[0], &P.y[0], &P.k1x[0], &P.k1y[0], &phi[0], &wet[0] );
+
+      // Retire the particles that start dry, or within a well's radius.
+      for (int j=P.n-1; j>=0; --j)
+      {
+         double d;
+         int w = NearestWell( Q, P.x[j], P.y[j], d );
+
+         if (w >= 0 && d < Radius)
+         {
+            captured[P.id[j]] = (Target < 0 || w == Target) ? 1 : 0;
+            P.Remove( j );
+         }
+         else if (!wet[j])
+         {
+            P.Remove( j );
+         }
+         else
+         {
+            double v = sqrt( P.k1x[j]*P.k1x[j] + P.k1y[j]*P.k1y[j] );
+            P.dt[j] = (v > 0) ? Radius/v : Duration;
+         }
+      }
+
+      for (int iteration=0; iteration<MAX_ITERATIONS && P.n>0; ++iteration)
+      {
+         const int n = P.n;
+
+         // Limit the steps: stop at the Duration, and do not step over a well.
+         // Without a pumping well there is nothing to step over.
+         for (int j=0; j<n; ++j)
+         {
+            double d;
+            int w = NearestWell( Q, P.x[j], P.y[j], d );
+
+            double v = sqrt( P.k1x[j]*P.k1x[j] + P.k1y[j]*P.k1y[j] );
+            if (w >= 0 && v > 0 && P.dt[j]*v > WELL_STEP_FRACTION*d) P.dt[j] = WELL_STEP_FRACTION*d/v;
+            if (P.t[j] + P.dt[j] > Duration) P.dt[j] = Duration - P.t[j];
+         }
+
+         // Stage 2.
+         for (int j=0; j<n; ++j)
+         {
+            xs[j] = P.x[j] + 0.5*P.dt[j]*P.k1x[j];
+            ys[j] = P.y[j] + 0.5*P.dt[j]*P.k1y[j];
+         }
+         Velocity( Q, a, n, &xs[0], &ys[0], &k2x[0], &k2y[0], &phi[0], &wet[0] );
+
+         // Stage 3.
+         for (int j=0; j<n; ++j)
+         {
+            xs[j] = P.x[j] + 0.75*P.dt[j]*k2x[j];
+            ys[j] = P.y[j] + 0.75*P.dt[j]*k2y[j];
+         }
+         Velocity( Q, a, n, &xs[0], &ys[0], &k3x[0], &k3y[0], &phi[0], &wet[0] );
+
+         // Third order solution, and the first-same-as-last stage 4.
+         for (int j=0; j<n; ++j)
+         {
+            xn[j] = P.x[j] + P.dt[j]*( 2.0/9.0*P.k1x[j] + 1.0/3.0*k2x[j] + 4.0/9.0*k3x[j] );
+            yn[j] = P.y[j] + P.dt[j]*( 2.0/9.0*P.k1y[j] + 1.0/3.0*k2y[j] + 4.0/9.0*k3y[j] );
+         }
+         Velocity( Q, a, n, &xn[0], &yn[0], &k4x[0], &k4y[0], &phi[0], &wet[0] );
+
+         // Accept or reject each step, and adapt the step sizes.
+         for (int j=n-1; j>=0; --j)
+         {
+            double ex = P.dt[j]*( -5.0/72.0*P.k1x[j] + 1.0/12.0*k2x[j] + 1.0/9.0*k3x[j] - 0.125*k4x[j] );
+            double ey = P.dt[j]*( -5.0/72.0*P.k1y[j] + 1.0/12.0*k2y[j] + 1.0/9.0*k3y[j] - 0.125*k4y[j] );
+            double err = sqrt( ex*ex + ey*ey );
+
+            double factor = (err > 0) ? 0.9*pow( tol/err, 1.0/3.0 ) : 5.0;
+            if (factor < 0.2) factor = 0.2;
+            if (factor > 5.0) factor = 5.0;
+
+            if (err > tol)
+            {
+               P.dt[j] *= factor;
+               continue;
+            }
+
+            P.x[j] = xn[j];
+            P.y[j] = yn[j];
+            P.t[j] += P.dt[j];
+            P.k1x[j] = k4x[j];
+            P.k1y[j] = k4y[j];
+            P.dt[j] *= factor;
+
+            double d;
+            int w = NearestWell( Q, P.x[j], P.y[j], d );
+
+            if (w >= 0 && d < Radius)
+            {
+               captured[P.id[j]] = (Target < 0 || w == Target) ? 1 : 0;
+               P.Remove( j );
+            }
+            else if (!wet[j] || P.t[j] >= Duration)
+            {
+               P.Remove( j );
+            }
+         }
+      }
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// CaptureProbability
+//
+// Arguments:
+//    S        the release points.
+//    k        hydraulic conductivity [L/T].
+//    H        aquifer thickness [L].
+//    Porosity effective porosity [-].
+//
+//    W        number of discharge specified wells [#].
+//    Xw       (W x 1) array of well x-coordinates [L].
+//    Yw       (W x 1) array of well y-coordinates [L].
+//    Qw       (W x 1) array of well discharges [L^3/T].
+//
+//    Xo       x-coordinate of model origin [L].
+//    Yo       y-coordinate of model origin [L].
+//
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//
+//    Target   index of the well of interest, or -1 for any pumping well.
+//    Radius   capture radius about each pumping well [L].
+//    Duration time of travel [T].
+//
+//    P        on exit, the (1 x N) capture probabilities.
+//
+// Notes:
+// o  A particle that comes within Radius of a pumping well other than the
+//    Target is captured by that well, and it is not counted.
+//
+// o  The realizations are independent, so they are distributed over the 
+//    available threads.  Each thread tracks all of the particles for one 
+//    realization at a time, and keeps its own capture counts.
+//-----------------------------------------------------------------------------
+void CaptureProbability(
+   const PointSet& S,
+   double k, double H, double Porosity,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo,
+   int nSims, const double* const* a,
+   int Target, double Radius, double Duration,
+   Matrix& P )
+{
+   assert( S.nPoints() > 0 );
+   assert( nSims > 0 );
+   assert( Porosity > 0 );
+   assert( Radius > 0 );
+   assert( Target < W );
+
+   const int N = S.nPoints();
+
+   Aquifer Q;
+   Q.k = k;   Q.H = H;   Q.Porosity = Porosity;
+   Q.W = W;   Q.Xw = Xw;   Q.Yw = Yw;   Q.Qw = Qw;
+   Q.Xo = Xo; Q.Yo = Yo;
+
+   std::vector<int> Count( N, 0 );
+
+   #pragma omp parallel
+   {
+      std::vector<int> count( N, 0 );
+      std::vector<char> captured( N );
+
+      #pragma omp for schedule(dynamic)
+      for (int i=0; i<nSims; ++i)
+      {
+         TrackRealization( Q, a[i], S, Target, Radius, Duration, captured );
+
+         for (int j=0; j<N; ++j)
+            count[j] += captured[j];
+      }
+
+      #pragma omp critical
+      {
+         for (int j=0; j<N; ++j)
+            Count[j] += count[j];
+      }
+   }
+
+   P.Resize( 1, N );
+   for (int j=0; j<N; ++j)
+      P(0,j) = static_cast<double>(Count[j])/nSims;
+}
+
+
+} // namespace oneka
@@ -0,0 +1,70 @@
+//=============================================================================
+// capture_zone.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef CAPTURE_ZONE_H
+#define CAPTURE_ZONE_H
+
+#include "matrix.h"
+#include "point_set.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Probabilistic capture zones by particle tracking.
+//
+// For every realization, a particle is released at each point of S and is
+// tracked along the seepage velocity, -grad(Phi)/(n b), until it comes
+// within Radius of a pumping well, the aquifer goes dry, or the Duration is
+// reached.  P(0,j) is the fraction of realizations in which the particle
+// released at point j is captured by the Target well (or by any pumping 
+// well if Target < 0) within the Duration: i.e. the probability that point
+// j lies within the time-of-travel capture zone.
+//-----------------------------------------------------------------------------
+void CaptureProbability(
+   const PointSet& S,
+   double k, double H, double Porosity,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo,
+   int nSims, const double* const* a,
+   int Target, double Radius, double Duration,
+   Matrix& P );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // CAPTURE_ZONE_H
@@ -0,0 +1,215 @@
+//=============================================================================
+// diagnostics.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "diagnostics.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "oneka_engine.h"
+#include "oneka_model.h"
+
+namespace{
+   const int N = 6;
+
+   // A column is rank deficient if orthogonalization removes all but this
+   // fraction of its norm.
+   const double RANK_TOLERANCE = 1e-10;
+
+   //--------------------------------------------------------------------------
+   // Dot product of two length n rows, summed in order.
+   //--------------------------------------------------------------------------
+   double Dot( int n, const double* x, const double* y )
+   {
+      double sum = 0;
+
+      for (int i=0; i<n; ++i)
+         sum += x[i]*y[i];
+
+      return sum;
+   }
+
+   //--------------------------------------------------------------------------
+   // y = y - a x, for length n rows.
+   //--------------------------------------------------------------------------
+   void Axpy( int n, double a, const double* x, double* y )
+   {
+      for (int i=0; i<n; ++i)
+         y[i] -= a*x[i];
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// LeaveOneOutDiagnostics
+//
+//    Compute, for every piezometer p, the leave-one-out residual, leverage,
+//    and Cook's distance of the weighted Oneka fit, from a single QR 
+//    factorization of the full system.
+//
+// Arguments:
+//    k     hydraulic conductivity [L/T].
+//    H     aquifer thickness [L].
+//    Base  elevation of the aquifer base [L].
+//
+//    W     number of discharge specified wells [#].
+//    Xw    (W x 1) array of well x-coordinates [L].
+//    Yw    (W x 1) array of well y-coordinates [L].
+//    Qw    (W x 1) array of well discharges [L^3/T].
+//
+//    P     number of piezometrers [#].
+//    Xp    (P x 1) array of piezometer x-coordinates [L].
+//    Yp    (P x 1) array of piezometer y-coordinates [L].
+//    Ep    (P x 1) array of Expected Values of heads [L].
+//    Sp    (P x 1) array of Standard Deviations of heads [L].
+//
+//    Xo    x-coordinate of model origin [L].
+//    Yo    y-coordinate of model origin [L].
+//
+//    D     the diagnostics, on exit.
+//
+// Notes:
+// o  With A = QR (thin, Q is P x 6), the hat matrix is QQ', so
+//
+//       h_p  = || Q(p,:) ||^2
+//       e_p  = b_p - Q(p,:) Q'b
+//       e_-p = e_p / (1 - h_p)
+//       D_p  = e_p^2 h_p / ( 6 s^2 (1 - h_p)^2 ),   s^2 = e'e / (P - 6)
+//
+//    The total cost is O(36 P), instead of P refits.
+//
+// o  Q is computed by modified Gram-Schmidt with reorthogonalization.  The
+//    orthogonalization and the sums are serial, so the diagnostics do not 
+//    depend on the number of threads; the assembly of the equations and 
+//    the per-piezometer results are parallelized over the piezometers.
+//
+// o  If h_p = 1 (the fit without p is not determined) the deleted residual
+//    and Cook's distance are NaN; if P <= 6, Cook's distance is NaN.
+//
+// o  Throws Exception_SingularSystem if the system is rank deficient.
+//
+// References:
+// o  Belsley, D.A., E. Kuh, and R.E. Welsch, 1980, Regression Diagnostics,
+//    John Wiley & Sons, New York, Chapter 2.
+//-----------------------------------------------------------------------------
+void LeaveOneOutDiagnostics(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   int P, const double* Xp, const double* Yp, const double* Ep, const double* Sp, 
+   double Xo, double Yo,
+   LeaveOneOut& D )
+{
+   assert( P > 0 );
+
+   const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+   // Assemble the transposed system: row j of At is column j of A.
+   Matrix At( N, P );
+   Matrix b( 1, P );
+
+   #pragma omp parallel for schedule(static)
+   for (int p=0; p<P; ++p)
+   {
+      double row[6];
+      ObservationEquation( k, H, Base, W, Xw, Yw, Qw, 
+         Xp[p], Yp[p], Ep[p], Sp[p], Xo, Yo, row, b(0,p) );
+
+      for (int j=0; j<N; ++j)
+         At(j,p) = row[j];
+   }
+
+   // Orthonormalize the columns of A in place: At becomes Q'.
+   for (int j=0; j<N; ++j)
+   {
+      double* q = At.Base(j,0);
+      double norm0 = sqrt( Dot( P, q, q ) );
+
+      for (int pass=0; pass<2; ++pass)
+         for (int l=0; l<j; ++l)
+            Axpy( P, Dot( P, At.Base(l,0), q ), At.Base(l,0), q );
+
+      double norm = sqrt( Dot( P, q, q ) );
+      if( !(norm > RANK_TOLERANCE*norm0) ) throw oneka::Exception_SingularSystem();
+
+      for (int p=0; p<P; ++p)
+         q[p] /= norm;
+   }
+
+   // c = Q'b.
+   double c[6];
+   for (int j=0; j<N; ++j)
+      c[j] = Dot( P, At.Base(j,0), b.Base() );
+
+   // Residuals and leverages.
+   D.Residual.Resize( 1, P );
+   D.Leverage.Resize( 1, P );
+   D.Deleted.Resize( 1, P );
+   D.CooksDistance.Resize( 1, P );
+
+   #pragma omp parallel for schedule(static)
+   for (int p=0; p<P; ++p)
+   {
+      double h = 0;
+      double fit = 0;
+      for (int j=0; j<N; ++j)
+      {
+         h   += At(j,p)*At(j,p);
+         fit += At(j,p)*c[j];
+      }
+
+      double e = b(0,p) - fit;
+      D.Residual(0,p) = e;
+      D.Leverage(0,p) = h;
+      D.Deleted(0,p)  = (h < 1) ? e/(1 - h) : NaN;
+   }
+
+   // Cook's distance.
+   double RSS = Dot( P, D.Residual.Base(), D.Residual.Base() );
+   double s2 = (P > N) ? RSS/(P - N) : NaN;
+
+   #pragma omp parallel for schedule(static)
+   for (int p=0; p<P; ++p)
+   {
+      double h = D.Leverage(0,p);
+      double e = D.Residual(0,p);
+      D.CooksDistance(0,p) = (h < 1) ? e*e*h/(N*s2*(1 - h)*(1 - h)) : NaN;
+   }
+}
+
+
+} // namespace oneka
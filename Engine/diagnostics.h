@@ -0,0 +1,71 @@
+//=============================================================================
+// diagnostics.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "matrix.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Leave-one-out diagnostics of the weighted Oneka fit.
+//
+// All quantities are in the units of the weighted equations: a residual of
+// Phi divided by the standard deviation of Phi at the piezometer, which is
+// approximately the head residual divided by Sp.
+//-----------------------------------------------------------------------------
+struct LeaveOneOut
+{
+   Matrix Residual;        // (1 x P) residual of the fit to all piezometers.
+   Matrix Leverage;        // (1 x P) diagonal of the hat matrix.
+   Matrix Deleted;         // (1 x P) residual of the fit without piezometer p.
+   Matrix CooksDistance;   // (1 x P) Cook's distance.
+};
+
+void LeaveOneOutDiagnostics(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   int P, const double* Xp, const double* Yp, const double* Ep, const double* Sp, 
+   double Xo, double Yo,
+   LeaveOneOut& D );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // DIAGNOSTICS_H
@@ -0,0 +1,172 @@
+//=============================================================================
+// engine_batch.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "engine_batch.h"
+
+#include <exception>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "trace.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// EngineInput
+//-----------------------------------------------------------------------------
+EngineInput::EngineInput()
+:  k( 0 ), H( 0 ), Base( 0 ),
+   W( 0 ), Xw( NULL ), Yw( NULL ), Qw( NULL ),
+   P( 0 ), Xp( NULL ), Yp( NULL ), Ep( NULL ), Sp( NULL ),
+   Xo( 0 ), Yo( 0 ),
+   nSims( 0 ),
+   Seed( 0 ),
+   Stream( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//
+//    Run Engine for one site, drawing the realizations from the site's own
+//    random number stream, RandomStream( In.Seed, In.Stream ).  Throws
+//    std::invalid_argument if In.Options.UseSeed is set.
+//-----------------------------------------------------------------------------
+EngineReturn Engine( const EngineInput& In, EngineWorkspace* Work )
+{
+   if( In.Options.UseSeed ) 
+      throw std::invalid_argument( "EngineInput: set Seed and Stream, not Options.UseSeed" );
+
+   RandomStream R( In.Seed, In.Stream );
+   return Engine( In.k, In.H, In.Base, 
+      In.W, In.Xw, In.Yw, In.Qw, 
+      In.P, In.Xp, In.Yp, In.Ep, In.Sp, 
+      In.Xo, In.Yo, In.nSims, In.Options, R, Work );
+}
+
+//-----------------------------------------------------------------------------
+// StatusName
+//-----------------------------------------------------------------------------
+const char* StatusName( int Status )
+{
+   switch( Status )
+   {
+      case ENGINE_OK:            return "ok";
+      case ENGINE_SINGULAR:      return "singular";
+      case ENGINE_SINK_FAILED:   return "sink_failed";
+      case ENGINE_CANCELLED:     return "cancelled";
+      case ENGINE_FAILED:        return "failed";
+   }
+   return "unknown";
+}
+
+//-----------------------------------------------------------------------------
+// EngineBatch
+//
+//    Run Engine for each of the sites in Inputs, in parallel.
+//
+// Arguments:
+//    Inputs   the sites.
+//    Results  the Engine results, in the same order as Inputs, on exit.
+//    Status   an EngineStatus for each site, on exit.  The Result of a site
+//             that is not ENGINE_OK is left default constructed, with a 
+//             NULL "a".
+//    nThreads number of threads; if <= 0, all available threads.
+//
+// Notes:
+// o  The sites are handed out one at a time to whichever thread is free
+//    (dynamic scheduling), so sites of very different sizes balance. 
+//    Each thread keeps one EngineWorkspace for all of its sites.
+//
+// o  Since each site draws from its own stream, the results do not depend
+//    upon the number of threads or the order of execution.
+//
+// o  The caller owns the realizations in each Result, as for Engine.
+//-----------------------------------------------------------------------------
+void EngineBatch( 
+   const std::vector<EngineInput>& Inputs, 
+   std::vector<EngineReturn>& Results, 
+   std::vector<int>& Status,
+   int nThreads )
+{
+   const int n = int( Inputs.size() );
+
+   Results.assign( n, EngineReturn() );
+   Status.assign( n, ENGINE_OK );
+
+   #ifdef _OPENMP
+      if (nThreads <= 0) nThreads = omp_get_max_threads();
+   #else
+      nThreads = 1;
+   #endif
+
+   #pragma omp parallel num_threads(nThreads)
+   {
+      EngineWorkspace Work;
+
+      #pragma omp for schedule(dynamic,1)
+      for (int i=0; i<n; ++i)
+      {
+         ONEKA_TRACE_SCOPE( "EngineBatch site" );
+         try
+         {
+            Results[i] = Engine( Inputs[i], &Work );
+         }
+         catch( Exception_SingularSystem& )
+         {
+            Status[i] = ENGINE_SINGULAR;
+         }
+         catch( Exception_SinkFailure& )
+         {
+            Status[i] = ENGINE_SINK_FAILED;
+         }
+         catch( Exception_Cancelled& )
+         {
+            Status[i] = ENGINE_CANCELLED;
+         }
+         catch( std::exception& )
+         {
+            Status[i] = ENGINE_FAILED;
+         }
+      }
+   }
+}
+
+
+} // namespace oneka
@@ -0,0 +1,121 @@
+//=============================================================================
+// engine_batch.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENGINE_BATCH_H
+#define ENGINE_BATCH_H
+
+#include <vector>
+
+#include "oneka_engine.h"
+
+namespace oneka{
+
+//--------------------------------------------------------------------------
+// The complete input for one Engine run at one site.
+//
+// The arrays are not copied; they must remain valid until the run is 
+// complete.  The realizations are drawn from RandomStream(Seed, Stream), 
+// so each site is reproducible on its own, regardless of the order or the
+// thread on which it is run.
+//
+// Seed and Stream are the only seed of a site, for Engine( In ), the batch
+// and lane runs, the cache, and the service.  The UseSeed, Seed, and 
+// Stream of Options belong to the argument-list Engine; here UseSeed must
+// be false, and Options.Seed and Options.Stream are ignored.  A site with
+// UseSeed set is rejected: Engine( In ) throws std::invalid_argument, and
+// the batch and lane runs report it as ENGINE_FAILED.
+//--------------------------------------------------------------------------
+struct EngineInput
+{
+   EngineInput();
+
+   double k;               // hydraulic conductivity [L/T].
+   double H;               // aquifer thickness [L].
+   double Base;            // elevation of the aquifer base [L].
+
+   int W;                  // number of discharge specified wells [#].
+   double* Xw;             // (W x 1) array of well x-coordinates [L].
+   double* Yw;             // (W x 1) array of well y-coordinates [L].
+   double* Qw;             // (W x 1) array of well discharges [L^3/T].
+
+   int P;                  // number of piezometers [#].
+   double* Xp;             // (P x 1) array of piezometer x-coordinates [L].
+   double* Yp;             // (P x 1) array of piezometer y-coordinates [L].
+   double* Ep;             // (P x 1) array of expected values of heads [L].
+   double* Sp;             // (P x 1) array of standard deviations of heads [L].
+
+   double Xo;              // x-coordinate of model origin [L].
+   double Yo;              // y-coordinate of model origin [L].
+
+   int nSims;              // number of realizations to generate [#].
+
+   unsigned long long Seed;      // random number seed.
+   unsigned long long Stream;    // random number stream id.
+
+   EngineOptions Options;
+};
+
+EngineReturn Engine( const EngineInput& In, EngineWorkspace* Work = NULL );
+
+
+//--------------------------------------------------------------------------
+// Run Engine for many independent sites.
+//--------------------------------------------------------------------------
+enum EngineStatus
+{
+   ENGINE_OK = 0,
+   ENGINE_SINGULAR,           // Exception_SingularSystem was thrown.
+   ENGINE_SINK_FAILED,        // Exception_SinkFailure was thrown.
+   ENGINE_CANCELLED,          // Exception_Cancelled was thrown.
+   ENGINE_FAILED              // a std::exception, such as std::bad_alloc, was thrown.
+};
+
+// A one word name for a status: "ok", "singular", "sink_failed", 
+// "cancelled", "failed", or "unknown".
+const char* StatusName( int Status );
+
+void EngineBatch( 
+   const std::vector<EngineInput>& Inputs, 
+   std::vector<EngineReturn>& Results, 
+   std::vector<int>& Status,
+   int nThreads = 0 );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ENGINE_BATCH_H
@@ -0,0 +1,644 @@
+//=============================================================================
+// engine_cache.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "engine_cache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "engine_protocol.h"
+
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// EngineCacheMutex
+//
+//    A plain operating system mutex, so that the cache is locked whether or
+//    not the callers are OpenMP threads.
+//-----------------------------------------------------------------------------
+class EngineCacheMutex
+{
+public:
+#ifdef _WIN32
+   EngineCacheMutex()   { ::InitializeCriticalSection( &m_Section ); }
+   ~EngineCacheMutex()  { ::DeleteCriticalSection( &m_Section ); }
+   void Lock()          { ::EnterCriticalSection( &m_Section ); }
+   void Unlock()        { ::LeaveCriticalSection( &m_Section ); }
+#else
+   EngineCacheMutex()   { ::pthread_mutex_init( &m_Mutex, NULL ); }
+   ~EngineCacheMutex()  { ::pthread_mutex_destroy( &m_Mutex ); }
+   void Lock()          { ::pthread_mutex_lock( &m_Mutex ); }
+   void Unlock()        { ::pthread_mutex_unlock( &m_Mutex ); }
+#endif
+
+private:
+   EngineCacheMutex( const EngineCacheMutex& );
+   EngineCacheMutex& operator=( const EngineCacheMutex& );
+
+#ifdef _WIN32
+   CRITICAL_SECTION m_Section;
+#else
+   pthread_mutex_t m_Mutex;
+#endif
+};
+
+namespace{
+
+   //--------------------------------------------------------------------------
+   // Holds the cache mutex for the life of a scope.
+   //--------------------------------------------------------------------------
+   class CacheLock
+   {
+   public:
+      explicit CacheLock( EngineCacheMutex& M ) : m_M( M ) { m_M.Lock(); }
+      ~CacheLock() { m_M.Unlock(); }
+
+   private:
+      CacheLock( const CacheLock& );
+      CacheLock& operator=( const CacheLock& );
+
+      EngineCacheMutex& m_M;
+   };
+
+   const unsigned int CACHE_FILE_MAGIC   = 0x434b4e4f;    // "ONKC"
+   const unsigned int CACHE_FILE_VERSION = 2;
+
+   //--------------------------------------------------------------------------
+   // The fixed part of a cache file.  It is followed by the key, the 
+   // version and run time strings, padding to a multiple of 8 bytes, and 
+   // the (nSims x 6) realizations.
+   //--------------------------------------------------------------------------
+   struct FileHeader
+   {
+      unsigned int Magic;
+      unsigned int Version;
+      unsigned int KeyLength;
+      unsigned int VersionLength;
+      unsigned int RunTimeLength;
+      int nSims;
+      double Xo;
+      double Yo;
+      unsigned long long Seed;
+      unsigned long long Stream;
+      double Mu[6];
+      double Cov[6][6];
+   };
+
+   std::size_t Padded( std::size_t n )
+   {
+      return (n + 7) & ~std::size_t( 7 );
+   }
+
+   //--------------------------------------------------------------------------
+   // 64-bit FNV-1a.
+   //--------------------------------------------------------------------------
+   unsigned long long Fnv1a( const std::vector<char>& Bytes )
+   {
+      unsigned long long h = 14695981039346656037ULL;
+      for (std::size_t i=0; i<Bytes.size(); ++i)
+      {
+         h ^= static_cast<unsigned char>( Bytes[i] );
+         h *= 1099511628211ULL;
+      }
+      return h;
+   }
+
+   //--------------------------------------------------------------------------
+   // Only the options carried in the key may be set.  An instrumented run
+   // wants its own timings, so it is never served from the cache.  UseSeed
+   // is not in the key either; such a site is passed on to Engine, which
+   // rejects it.
+   //--------------------------------------------------------------------------
+   bool Cacheable( const EngineOptions& Options )
+   {
+      return !Options.KeepDerived && !Options.SummarizeDerived && Options.Monitor == NULL && Options.Sink == NULL
+         && !Options.Instrument && !Options.UseSeed;
+   }
+
+   //--------------------------------------------------------------------------
+   // A read-only view of a whole file: memory mapped where available, 
+   // otherwise read into a buffer.
+   //--------------------------------------------------------------------------
+   class MappedFile
+   {
+   public:
+      MappedFile() : m_Data( NULL ), m_Size( 0 ) {}
+
+      ~MappedFile()
+      {
+      #ifndef _WIN32
+         if (m_Data != NULL) ::munmap( const_cast<char*>( m_Data ), m_Size );
+      #endif
+      }
+
+      bool Open( const std::string& Name )
+      {
+      #ifdef _WIN32
+         std::FILE* fp = std::fopen( Name.c_str(), "rb" );
+         if (fp == NULL) return false;
+
+         char buffer[65536];
+         std::size_t n;
+         while ((n = std::fread( buffer, 1, sizeof(buffer), fp )) > 0)
+            m_Buffer.insert( m_Buffer.end(), buffer, buffer + n );
+         std::fclose( fp );
+
+         m_Size = m_Buffer.size();
+         m_Data = m_Buffer.empty() ? NULL : &m_Buffer[0];
+         return m_Data != NULL;
+      #else
+         int fd = ::open( Name.c_str(), O_RDONLY );
+         if (fd < 0) return false;
+
+         struct stat st;
+         void* p = MAP_FAILED;
+         if( ::fstat( fd, &st ) == 0 && st.st_size > 0 )
+            p = ::mmap( NULL, std::size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+         ::close( fd );
+
+         if (p == MAP_FAILED) return false;
+         m_Data = static_cast<const char*>( p );
+         m_Size = std::size_t( st.st_size );
+         return true;
+      #endif
+      }
+
+      const char* Data() const { return m_Data; }
+      std::size_t Size() const { return m_Size; }
+
+   private:
+      MappedFile( const MappedFile& );
+      MappedFile& operator=( const MappedFile& );
+
+      const char* m_Data;
+      std::size_t m_Size;
+   #ifdef _WIN32
+      std::vector<char> m_Buffer;
+   #endif
+   };
+
+   long ProcessId()
+   {
+   #ifdef _WIN32
+      return long( _getpid() );
+   #else
+      return long( ::getpid() );
+   #endif
+   }
+}
+
+//-----------------------------------------------------------------------------
+// EngineCacheStats
+//-----------------------------------------------------------------------------
+EngineCacheStats::EngineCacheStats()
+:  Hits( 0 ), DiskHits( 0 ), Misses( 0 ), Bypassed( 0 ), Evictions( 0 ),
+   Entries( 0 ), Bytes( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// EngineInputHash
+//
+//    The 64-bit FNV-1a hash of the cache key of an input.
+//-----------------------------------------------------------------------------
+unsigned long long EngineInputHash( const EngineInput& In )
+{
+   std::vector<char> Key;
+   EncodeRequest( In, Key );
+   return Fnv1a( Key );
+}
+
+//=============================================================================
+// EngineCache
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+std::size_t EngineCache::Entry::Bytes() const
+{
+   return sizeof(Entry) + Key.size() + Version.size() + RunTime.size() + a.size()*sizeof(double);
+}
+
+//-----------------------------------------------------------------------------
+EngineCache::EngineCache( std::size_t MaxBytes, const std::string& Directory )
+:  m_MaxBytes( MaxBytes ),
+   m_Directory( Directory ),
+   m_Mutex( new EngineCacheMutex )
+{
+}
+
+//-----------------------------------------------------------------------------
+EngineCache::~EngineCache()
+{
+   delete m_Mutex;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Engine
+//
+//    Return the result of Engine( In, Work ), from the cache if possible.
+//
+// Notes:
+// o  The memory tier is locked only to look up, copy, and insert entries;
+//    the computation and the disk tier run unlocked.  Two threads missing
+//    on the same input at the same time both compute it.
+//-----------------------------------------------------------------------------
+EngineReturn EngineCache::Engine( const EngineInput& In, EngineWorkspace* Work )
+{
+   if( !Cacheable( In.Options ) )
+   {
+      {
+         CacheLock lock( *m_Mutex );
+         ++m_Stats.Bypassed;
+      }
+      return oneka::Engine( In, Work );
+   }
+
+   std::vector<char> Key;
+   EncodeRequest( In, Key );
+   const unsigned long long hash = Fnv1a( Key );
+
+   EngineReturn S;
+   bool hit;
+
+   {
+      CacheLock lock( *m_Mutex );
+      hit = Lookup( hash, Key, S );
+   }
+
+   if (hit) return S;
+
+   // The disk tier.
+   Entry E;
+   if( !m_Directory.empty() && Load( hash, Key, E ) )
+   {
+      Copy( E, S );
+
+      {
+         CacheLock lock( *m_Mutex );
+         ++m_Stats.DiskHits;
+         Insert( E );
+      }
+      return S;
+   }
+
+   // Compute.
+   S = oneka::Engine( In, Work );
+
+   E.Hash = hash;
+   E.Key.swap( Key );
+   E.Version = S.Version;
+   E.RunTime = S.RunTime;
+   E.Xo = S.Xo;
+   E.Yo = S.Yo;
+   E.Seed = S.Seed;
+   E.Stream = S.Stream;
+   std::memcpy( E.Mu, S.Mu, sizeof(E.Mu) );
+   std::memcpy( E.Cov, S.Cov, sizeof(E.Cov) );
+   E.nSims = S.nSims;
+   E.a.resize( 6*std::size_t( S.nSims ) );
+   for (int i=0; i<S.nSims; ++i)
+      std::memcpy( &E.a[6*i], S.a[i], 6*sizeof(double) );
+
+   if( !m_Directory.empty() )
+      Save( E );
+
+   {
+      CacheLock lock( *m_Mutex );
+      ++m_Stats.Misses;
+      Insert( E );
+   }
+
+   return S;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Lookup
+//
+//    Copy out the memory entry for Key, if any, and mark it most recently
+//    used.  The caller holds the lock.
+//-----------------------------------------------------------------------------
+bool EngineCache::Lookup( unsigned long long Hash, const std::vector<char>& Key, EngineReturn& S )
+{
+   std::pair<EntryIndex::iterator, EntryIndex::iterator> range = m_Index.equal_range( Hash );
+
+   for (EntryIndex::iterator it = range.first; it != range.second; ++it)
+   {
+      const Entry& E = *it->second;
+      if (E.Key != Key) continue;
+
+      m_Entries.splice( m_Entries.begin(), m_Entries, it->second );
+      ++m_Stats.Hits;
+
+      Copy( E, S );
+      return true;
+   }
+   return false;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Copy
+//
+//    Copy an entry into a newly allocated result.
+//-----------------------------------------------------------------------------
+void EngineCache::Copy( const Entry& E, EngineReturn& S )
+{
+   S.Version = E.Version;
+   S.RunTime = E.RunTime;
+   S.Xo = E.Xo;
+   S.Yo = E.Yo;
+   S.Seed = E.Seed;
+   S.Stream = E.Stream;
+   std::memcpy( S.Mu, E.Mu, sizeof(S.Mu) );
+   std::memcpy( S.Cov, E.Cov, sizeof(S.Cov) );
+   S.nSims = E.nSims;
+   S.a = new double*[S.nSims];
+   for (int i=0; i<S.nSims; ++i)
+   {
+      S.a[i] = new double[6];
+      std::memcpy( S.a[i], &E.a[6*i], 6*sizeof(double) );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Insert
+//
+//    Move E into the memory tier as the most recently used entry, unless 
+//    it is already there or is larger than the whole tier.  The caller 
+//    holds the lock.
+//-----------------------------------------------------------------------------
+void EngineCache::Insert( Entry& E )
+{
+   if (E.Bytes() > m_MaxBytes) return;
+
+   std::pair<EntryIndex::iterator, EntryIndex::iterator> range = m_Index.equal_range( E.Hash );
+   for (EntryIndex::iterator it = range.first; it != range.second; ++it)
+      if (it->second->Key == E.Key) return;
+
+   m_Entries.push_front( Entry() );
+   Entry& F = m_Entries.front();
+   F.Hash = E.Hash;
+   F.Key.swap( E.Key );
+   F.Version.swap( E.Version );
+   F.RunTime.swap( E.RunTime );
+   F.Xo = E.Xo;
+   F.Yo = E.Yo;
+   F.Seed = E.Seed;
+   F.Stream = E.Stream;
+   std::memcpy( F.Mu, E.Mu, sizeof(F.Mu) );
+   std::memcpy( F.Cov, E.Cov, sizeof(F.Cov) );
+   F.nSims = E.nSims;
+   F.a.swap( E.a );
+
+   m_Index.insert( std::make_pair( F.Hash, m_Entries.begin() ) );
+   ++m_Stats.Entries;
+   m_Stats.Bytes += F.Bytes();
+
+   Evict();
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Evict
+//
+//    Drop least recently used entries until the tier fits in MaxBytes.
+//-----------------------------------------------------------------------------
+void EngineCache::Evict()
+{
+   while (m_Stats.Bytes > m_MaxBytes && !m_Entries.empty())
+   {
+      EntryList::iterator last = --m_Entries.end();
+
+      std::pair<EntryIndex::iterator, EntryIndex::iterator> range = m_Index.equal_range( last->Hash );
+      for (EntryIndex::iterator it = range.first; it != range.second; ++it)
+      {
+         if (it->second == last)
+         {
+            m_Index.erase( it );
+            break;
+         }
+      }
+
+      m_Stats.Bytes -= last->Bytes();
+      --m_Stats.Entries;
+      ++m_Stats.Evictions;
+      m_Entries.erase( last );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Erase
+//
+//    Drop the entry for In from both tiers.  Returns true if there was one.
+//-----------------------------------------------------------------------------
+bool EngineCache::Erase( const EngineInput& In )
+{
+   std::vector<char> Key;
+   EncodeRequest( In, Key );
+   const unsigned long long hash = Fnv1a( Key );
+   bool found = false;
+
+   {
+      CacheLock lock( *m_Mutex );
+      std::pair<EntryIndex::iterator, EntryIndex::iterator> range = m_Index.equal_range( hash );
+      for (EntryIndex::iterator it = range.first; it != range.second; ++it)
+      {
+         if (it->second->Key == Key)
+         {
+            m_Stats.Bytes -= it->second->Bytes();
+            --m_Stats.Entries;
+            m_Entries.erase( it->second );
+            m_Index.erase( it );
+            found = true;
+            break;
+         }
+      }
+   }
+
+   Entry E;
+   if( !m_Directory.empty() && Load( hash, Key, E ) )
+      found |= ( std::remove( FileName( hash ).c_str() ) == 0 );
+
+   return found;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Clear
+//-----------------------------------------------------------------------------
+void EngineCache::Clear()
+{
+   {
+      CacheLock lock( *m_Mutex );
+      m_Entries.clear();
+      m_Index.clear();
+      m_Stats.Entries = 0;
+      m_Stats.Bytes = 0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Stats
+//-----------------------------------------------------------------------------
+EngineCacheStats EngineCache::Stats() const
+{
+   EngineCacheStats S;
+
+   {
+      CacheLock lock( *m_Mutex );
+      S = m_Stats;
+   }
+
+   return S;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::FileName
+//-----------------------------------------------------------------------------
+std::string EngineCache::FileName( unsigned long long Hash ) const
+{
+   char name[32];
+   std::sprintf( name, "%016llx.oec", Hash );
+   return m_Directory + "/" + name;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Load
+//
+//    Read the disk entry for Key into E.  Returns false if there is no 
+//    file, or if it is malformed or holds a different key.
+//-----------------------------------------------------------------------------
+bool EngineCache::Load( unsigned long long Hash, const std::vector<char>& Key, Entry& E ) const
+{
+   MappedFile File;
+   if( !File.Open( FileName( Hash ) ) || File.Size() < sizeof(FileHeader) ) return false;
+
+   FileHeader H;
+   std::memcpy( &H, File.Data(), sizeof(H) );
+   if (H.Magic != CACHE_FILE_MAGIC || H.Version != CACHE_FILE_VERSION || H.nSims < 0) return false;
+
+   const std::size_t strings = sizeof(H) + H.KeyLength + H.VersionLength + H.RunTimeLength;
+   const std::size_t sims = Padded( strings );
+   if (File.Size() != sims + 6*sizeof(double)*std::size_t( H.nSims )) return false;
+
+   const char* p = File.Data() + sizeof(H);
+   if (H.KeyLength != Key.size() || (!Key.empty() && std::memcmp( p, &Key[0], Key.size() ) != 0)) return false;
+   p += H.KeyLength;
+
+   E.Hash = Hash;
+   E.Key = Key;
+   E.Version.assign( p, H.VersionLength );
+   p += H.VersionLength;
+   E.RunTime.assign( p, H.RunTimeLength );
+
+   E.Xo = H.Xo;
+   E.Yo = H.Yo;
+   E.Seed = H.Seed;
+   E.Stream = H.Stream;
+   std::memcpy( E.Mu, H.Mu, sizeof(E.Mu) );
+   std::memcpy( E.Cov, H.Cov, sizeof(E.Cov) );
+   E.nSims = H.nSims;
+   E.a.resize( 6*std::size_t( H.nSims ) );
+   if (H.nSims > 0)
+      std::memcpy( &E.a[0], File.Data() + sims, E.a.size()*sizeof(double) );
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// EngineCache::Save
+//
+//    Write E to its disk file.  The file is written under a temporary 
+//    name and renamed, so readers never see a partial file.  Failures are
+//    ignored; the entry is simply not on disk.
+//-----------------------------------------------------------------------------
+void EngineCache::Save( const Entry& E ) const
+{
+   FileHeader H;
+   std::memset( &H, 0, sizeof(H) );
+   H.Magic = CACHE_FILE_MAGIC;
+   H.Version = CACHE_FILE_VERSION;
+   H.KeyLength = static_cast<unsigned int>( E.Key.size() );
+   H.VersionLength = static_cast<unsigned int>( E.Version.size() );
+   H.RunTimeLength = static_cast<unsigned int>( E.RunTime.size() );
+   H.nSims = E.nSims;
+   H.Xo = E.Xo;
+   H.Yo = E.Yo;
+   H.Seed = E.Seed;
+   H.Stream = E.Stream;
+   std::memcpy( H.Mu, E.Mu, sizeof(H.Mu) );
+   std::memcpy( H.Cov, E.Cov, sizeof(H.Cov) );
+
+   const std::size_t strings = sizeof(H) + E.Key.size() + E.Version.size() + E.RunTime.size();
+   const char zeros[8] = { 0 };
+
+   const std::string name = FileName( E.Hash );
+   char suffix[64];
+   std::sprintf( suffix, ".%ld.%p.tmp", ProcessId(), static_cast<const void*>( &E ) );
+   const std::string temp = name + suffix;
+
+   std::FILE* fp = std::fopen( temp.c_str(), "wb" );
+   if (fp == NULL) return;
+
+   bool ok = std::fwrite( &H, sizeof(H), 1, fp ) == 1;
+   if (ok && !E.Key.empty()) ok = std::fwrite( &E.Key[0], E.Key.size(), 1, fp ) == 1;
+   if (ok && !E.Version.empty()) ok = std::fwrite( E.Version.data(), E.Version.size(), 1, fp ) == 1;
+   if (ok && !E.RunTime.empty()) ok = std::fwrite( E.RunTime.data(), E.RunTime.size(), 1, fp ) == 1;
+   if (ok && Padded( strings ) > strings) ok = std::fwrite( zeros, Padded( strings ) - strings, 1, fp ) == 1;
+   if (ok && !E.a.empty()) ok = std::fwrite( &E.a[0], sizeof(double), E.a.size(), fp ) == E.a.size();
+   ok &= ( std::fclose( fp ) == 0 );
+
+   if (ok)
+   {
+   #ifdef _WIN32
+      std::remove( name.c_str() );
+   #endif
+      ok = ( std::rename( temp.c_str(), name.c_str() ) == 0 );
+   }
+   if (!ok)
+      std::remove( temp.c_str() );
+}
+
+
+} // namespace oneka
@@ -0,0 +1,161 @@
+//=============================================================================
+// engine_cache.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENGINE_CACHE_H
+#define ENGINE_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "engine_batch.h"
+
+namespace oneka{
+
+class EngineCacheMutex;
+
+//-----------------------------------------------------------------------------
+// Cache statistics.
+//-----------------------------------------------------------------------------
+struct EngineCacheStats
+{
+   EngineCacheStats();
+
+   long Hits;              // answered from memory.
+   long DiskHits;          // answered from disk.
+   long Misses;            // computed.
+   long Bypassed;          // not cacheable: computed, and not stored.
+   long Evictions;         // entries dropped from memory.
+
+   long Entries;           // entries in memory.
+   std::size_t Bytes;      // bytes held in memory.
+};
+
+//-----------------------------------------------------------------------------
+// EngineCache
+//
+//    A content-addressed cache of Engine( const EngineInput& ) results.
+//
+//    The key is the complete input -- k, H, Base, the wells, the 
+//    piezometers, the origin, nSims, the seed and stream, and the options
+//    that affect the fit -- in the request encoding of engine_protocol.h, 
+//    so two inputs share an entry exactly when Engine would return the 
+//    same result for both.  The key is hashed with 64-bit FNV-1a; entries
+//    store the full key, so a hash collision is a miss, never a wrong 
+//    answer.
+//
+//    There are two tiers.  The memory tier holds up to MaxBytes of 
+//    results, evicting the least recently used.  If Directory is not 
+//    empty, every result is also written there, one file per key, and a
+//    memory miss looks there before computing; the file is memory mapped 
+//    and the result is promoted into the memory tier.
+//
+//    Inputs with KeepDerived, SummarizeDerived, or a Monitor are not
+//    cached.  Failures (Exception_SingularSystem) are not cached.
+//
+//    The cache may be shared by threads of any kind -- OpenMP, EnginePool 
+//    workers, or the service dispatcher.  The memory tier and the 
+//    statistics are guarded by an operating system mutex, so the locking 
+//    does not depend on OpenMP.
+//-----------------------------------------------------------------------------
+class EngineCache
+{
+public:
+   explicit EngineCache( std::size_t MaxBytes, const std::string& Directory = std::string() );
+   ~EngineCache();
+
+   // As Engine( In ): the caller owns the realizations in the result.
+   EngineReturn Engine( const EngineInput& In, EngineWorkspace* Work = NULL );
+
+   bool Erase( const EngineInput& In );     // drop from both tiers.
+   void Clear();                            // drop the memory tier.
+
+   EngineCacheStats Stats() const;
+
+private:
+   EngineCache( const EngineCache& );
+   EngineCache& operator=( const EngineCache& );
+
+   struct Entry
+   {
+      unsigned long long Hash;
+      std::vector<char> Key;
+      std::string Version;
+      std::string RunTime;
+      double Xo;
+      double Yo;
+      unsigned long long Seed;
+      unsigned long long Stream;
+      double Mu[6];
+      double Cov[6][6];
+      int nSims;
+      std::vector<double> a;     // (nSims x 6), by rows.
+
+      std::size_t Bytes() const;
+   };
+
+   typedef std::list<Entry> EntryList;
+   typedef std::multimap<unsigned long long, EntryList::iterator> EntryIndex;
+
+   static void Copy( const Entry& E, EngineReturn& S );
+
+   bool Lookup( unsigned long long Hash, const std::vector<char>& Key, EngineReturn& S );
+   void Insert( Entry& E );
+   void Evict();
+
+   bool Load( unsigned long long Hash, const std::vector<char>& Key, Entry& E ) const;
+   void Save( const Entry& E ) const;
+   std::string FileName( unsigned long long Hash ) const;
+
+   std::size_t m_MaxBytes;
+   std::string m_Directory;
+
+   EntryList m_Entries;          // most recently used first.
+   EntryIndex m_Index;
+   EngineCacheStats m_Stats;
+   EngineCacheMutex* m_Mutex;    // guards m_Entries, m_Index, and m_Stats.
+};
+
+unsigned long long EngineInputHash( const EngineInput& In );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ENGINE_CACHE_H
@@ -0,0 +1,301 @@
+//=============================================================================
+// engine_jobs.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "engine_jobs.h"
+
+#ifdef ONEKA_ENGINE_JOBS
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+#include "trace.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The shared state of a job: the cancellation flag and progress, written 
+// by the worker through the EngineMonitor interface, and the result.  The
+// caller's own monitor, if any, is polled and informed as well.
+//
+// The future signals completion, or carries the exception that ended the
+// job; the result itself is held here until Get takes it.  Realizations
+// that are never taken are freed with the state.
+//-----------------------------------------------------------------------------
+struct EngineJob::State : public EngineMonitor
+{
+   State() : monitor( nullptr ), cancelled( false ), done( 0 ), total( 0 ), taken( false ) {}
+
+   ~State()
+   {
+      if( result.a == nullptr ) return;
+      for (int i=0; i<result.nSims; ++i)
+         delete [] result.a[i];
+      delete [] result.a;
+   }
+
+   bool Cancelled()
+   {
+      return cancelled.load() || ( monitor != nullptr && monitor->Cancelled() );
+   }
+
+   void Progress( int nDone, int nSims )
+   {
+      done.store( nDone );
+      total.store( nSims );
+      if( monitor != nullptr ) monitor->Progress( nDone, nSims );
+   }
+
+   EngineInput input;
+   EngineMonitor* monitor;
+   std::atomic<bool> cancelled;
+   std::atomic<int> done;
+   std::atomic<int> total;
+
+   EngineReturn result;
+   std::atomic<bool> taken;
+   std::promise<void> promise;
+   std::shared_future<void> future;
+};
+
+//=============================================================================
+// EngineJob
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+EngineJob::EngineJob()
+{
+}
+
+//-----------------------------------------------------------------------------
+bool EngineJob::Valid() const
+{
+   return m_State != nullptr;
+}
+
+//-----------------------------------------------------------------------------
+bool EngineJob::Ready() const
+{
+   if( !Valid() ) return false;
+   return m_State->future.wait_for( std::chrono::seconds(0) ) == std::future_status::ready;
+}
+
+//-----------------------------------------------------------------------------
+void EngineJob::Wait() const
+{
+   if( !Valid() ) throw std::future_error( std::future_errc::no_state );
+   m_State->future.wait();
+}
+
+//-----------------------------------------------------------------------------
+// Get
+//
+//    Wait for the job, and return its result.  Rethrows the exception that
+//    ended the job: Exception_SingularSystem, or Exception_Cancelled.
+//    Like Wait, throws std::future_error if the handle refers to no job.
+//
+// Notes:
+// o  The result is taken once, by any copy of the handle, and the caller 
+//    then owns the realizations, as for Engine.  A second Get throws 
+//    std::future_error( future_already_retrieved ).  If the result is 
+//    never taken, its realizations are freed with the last handle.
+//-----------------------------------------------------------------------------
+EngineReturn EngineJob::Get()
+{
+   if( !Valid() ) throw std::future_error( std::future_errc::no_state );
+
+   m_State->future.wait();
+   if( m_State->taken.exchange( true ) ) 
+      throw std::future_error( std::future_errc::future_already_retrieved );
+
+   m_State->future.get();
+
+   EngineReturn R = m_State->result;
+   m_State->result = EngineReturn();
+   return R;
+}
+
+//-----------------------------------------------------------------------------
+// Cancel
+//
+//    Request cancellation.  A job that has not started never starts; a 
+//    running job stops at its next check, between phases or between chunks
+//    of realizations.  A job that has finished is unaffected.
+//-----------------------------------------------------------------------------
+void EngineJob::Cancel()
+{
+   if( !Valid() ) return;
+   m_State->cancelled.store( true );
+}
+
+//-----------------------------------------------------------------------------
+double EngineJob::Progress() const
+{
+   if( !Valid() ) return 0.0;
+   int total = m_State->total.load();
+   return (total > 0) ? double( m_State->done.load() )/total : 0.0;
+}
+
+
+//=============================================================================
+// EnginePool
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Constructor.
+//
+//    Start nThreads workers; if nThreads <= 0, one per hardware thread.
+//-----------------------------------------------------------------------------
+EnginePool::EnginePool( int nThreads )
+:  m_Stop( false )
+{
+   if( nThreads <= 0 ) nThreads = int( std::thread::hardware_concurrency() );
+   if( nThreads <= 0 ) nThreads = 1;
+
+   for (int i=0; i<nThreads; ++i)
+      m_Threads.push_back( std::thread( &EnginePool::Worker, this ) );
+}
+
+//-----------------------------------------------------------------------------
+// Destructor.
+//
+//    Jobs still queued are cancelled; running jobs are allowed to finish.
+//-----------------------------------------------------------------------------
+EnginePool::~EnginePool()
+{
+   {
+      std::lock_guard<std::mutex> lock( m_Mutex );
+      m_Stop = true;
+   }
+   m_Wake.notify_all();
+
+   for (size_t i=0; i<m_Threads.size(); ++i)
+      m_Threads[i].join();
+}
+
+//-----------------------------------------------------------------------------
+int EnginePool::nThreads() const
+{
+   return int( m_Threads.size() );
+}
+
+//-----------------------------------------------------------------------------
+// Submit
+//
+//    Queue an Engine run, and return its handle immediately.  The arrays 
+//    referenced by In must remain valid until the job is finished.
+//
+// Notes:
+// o  The job runs under its own monitor.  A monitor in In.Options is kept:
+//    it is polled for cancellation along with EngineJob::Cancel, and it 
+//    receives the progress reports, on the worker thread.
+//-----------------------------------------------------------------------------
+EngineJob EnginePool::Submit( const EngineInput& In )
+{
+   EngineJob job;
+   job.m_State = std::make_shared<EngineJob::State>();
+
+   EngineJob::State& state = *job.m_State;
+   state.input = In;
+   state.monitor = In.Options.Monitor;
+   state.input.Options.Monitor = &state;
+   state.total.store( In.nSims );
+   state.future = state.promise.get_future().share();
+
+   {
+      std::lock_guard<std::mutex> lock( m_Mutex );
+      m_Queue.push_back( job.m_State );
+   }
+   m_Wake.notify_one();
+
+   return job;
+}
+
+//-----------------------------------------------------------------------------
+// Worker
+//
+//    Run queued jobs until the pool is stopped.  When stopping, the jobs 
+//    left in the queue are cancelled.
+//-----------------------------------------------------------------------------
+void EnginePool::Worker()
+{
+   ONEKA_TRACE_THREAD( "EnginePool worker" );
+
+   while( true )
+   {
+      std::shared_ptr<EngineJob::State> state;
+      {
+         std::unique_lock<std::mutex> lock( m_Mutex );
+         m_Wake.wait( lock, [this]{ return m_Stop || !m_Queue.empty(); } );
+
+         if( m_Queue.empty() ) return;
+
+         state = m_Queue.front();
+         m_Queue.pop_front();
+         if( m_Stop ) state->cancelled.store( true );
+      }
+
+      Run( *state );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Run
+//
+//    Run one job, and deliver its result or exception.
+//-----------------------------------------------------------------------------
+void EnginePool::Run( EngineJob::State& state )
+{
+   ONEKA_TRACE_SCOPE( "EnginePool job" );
+
+   try
+   {
+      if( state.Cancelled() ) throw Exception_Cancelled();
+
+      EngineWorkspace Work;
+      state.result = Engine( state.input, &Work );
+      state.promise.set_value();
+   }
+   catch( ... )
+   {
+      state.promise.set_exception( std::current_exception() );
+   }
+}
+
+
+} // namespace oneka
+
+#endif  // ONEKA_ENGINE_JOBS
@@ -0,0 +1,124 @@
+//=============================================================================
+// engine_jobs.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENGINE_JOBS_H
+#define ENGINE_JOBS_H
+
+//-----------------------------------------------------------------------------
+// The asynchronous job interface requires C++11 threads and futures.  With
+// an older compiler this header declares nothing.
+//-----------------------------------------------------------------------------
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define ONEKA_ENGINE_JOBS
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "engine_batch.h"
+
+namespace oneka{
+
+//=============================================================================
+// EngineJob
+//
+//    A handle to one Engine run submitted to an EnginePool.  The handle may
+//    be copied; all copies refer to the same job.  A default-constructed 
+//    handle refers to no job: it is never Ready, its Progress is 0, Cancel 
+//    does nothing, and Wait and Get throw std::future_error.
+//=============================================================================
+class EngineJob
+{
+public:
+   EngineJob();
+
+   bool Valid() const;                    // refers to a job
+   bool Ready() const;                    // finished, cancelled, or failed
+   void Wait() const;
+
+   EngineReturn Get();                    // wait, then return the result once
+   void Cancel();                         // request cooperative cancellation
+   double Progress() const;               // fraction of nSims generated
+
+private:
+   friend class EnginePool;
+   struct State;
+
+   std::shared_ptr<State> m_State;
+};
+
+
+//=============================================================================
+// EnginePool
+//
+//    A fixed set of worker threads running submitted Engine jobs in order of
+//    submission.  The submitting thread is never blocked.
+//=============================================================================
+class EnginePool
+{
+public:
+   explicit EnginePool( int nThreads = 0 );
+   ~EnginePool();
+
+   EngineJob Submit( const EngineInput& In );
+   int nThreads() const;
+
+private:
+   EnginePool( const EnginePool& );
+   EnginePool& operator=( const EnginePool& );
+
+   void Worker();
+   static void Run( EngineJob::State& state );
+
+   std::vector<std::thread> m_Threads;
+   std::deque< std::shared_ptr<EngineJob::State> > m_Queue;
+   std::mutex m_Mutex;
+   std::condition_variable m_Wake;
+   bool m_Stop;
+};
+
+
+} // namespace oneka
+
+#endif
+
+//=============================================================================
+#endif  // ENGINE_JOBS_H
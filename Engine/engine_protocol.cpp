@@ -0,0 +1,353 @@
+//=============================================================================
+// engine_protocol.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "engine_protocol.h"
+
+#include <cstring>
+
+namespace oneka{
+
+namespace{
+
+   const unsigned int FLAG_COLLAPSE_READINGS = 1;
+   const unsigned int FLAG_USE_PRIOR = 2;
+
+   //--------------------------------------------------------------------------
+   // Append raw values to a message body.
+   //--------------------------------------------------------------------------
+   template <typename T>
+   void Put( std::vector<char>& Body, const T& x )
+   {
+      const char* p = reinterpret_cast<const char*>( &x );
+      Body.insert( Body.end(), p, p + sizeof(T) );
+   }
+
+   void PutArray( std::vector<char>& Body, const double* x, int n )
+   {
+      if (n <= 0) return;
+      const char* p = reinterpret_cast<const char*>( x );
+      Body.insert( Body.end(), p, p + n*sizeof(double) );
+   }
+
+   void PutString( std::vector<char>& Body, const std::string& s )
+   {
+      Put( Body, static_cast<unsigned int>( s.size() ) );
+      Body.insert( Body.end(), s.begin(), s.end() );
+   }
+
+   //--------------------------------------------------------------------------
+   // Read raw values from a message body.  Every read is bounds checked; 
+   // once a read fails, all later reads fail.
+   //--------------------------------------------------------------------------
+   class Reader
+   {
+   public:
+      Reader( const char* Body, std::size_t Length ) : m_p( Body ), m_end( Body + Length ), m_ok( true ) {}
+
+      template <typename T>
+      bool Get( T& x )
+      {
+         if( !Take( sizeof(T) ) ) return false;
+         std::memcpy( &x, m_p - sizeof(T), sizeof(T) );
+         return true;
+      }
+
+      bool GetArray( int n, std::vector<double>& x )
+      {
+         if( n < 0 || std::size_t(n) > Remaining()/sizeof(double) ) return m_ok = false;
+         x.resize( n );
+         if( n > 0 )
+         {
+            std::memcpy( &x[0], m_p, n*sizeof(double) );
+            m_p += n*sizeof(double);
+         }
+         return true;
+      }
+
+      bool GetString( std::string& s )
+      {
+         unsigned int n;
+         if( !Get( n ) || !Take( n ) ) return false;
+         s.assign( m_p - n, n );
+         return true;
+      }
+
+      bool Ok() const { return m_ok; }
+      bool AtEnd() const { return m_ok && m_p == m_end; }
+      std::size_t Remaining() const { return m_ok ? std::size_t( m_end - m_p ) : 0; }
+
+   private:
+      bool Take( std::size_t n )
+      {
+         if( n > Remaining() ) return m_ok = false;
+         m_p += n;
+         return true;
+      }
+
+      const char* m_p;
+      const char* m_end;
+      bool m_ok;
+   };
+}
+
+//-----------------------------------------------------------------------------
+// EngineRequest
+//-----------------------------------------------------------------------------
+EngineRequest::EngineRequest()
+:  k( 0 ), H( 0 ), Base( 0 ),
+   Xo( 0 ), Yo( 0 ),
+   nSims( 0 ),
+   Seed( 0 ),
+   Stream( 0 ),
+   CollapseReadings( false ),
+   UsePrior( false )
+{
+   std::memset( PriorMu, 0, sizeof(PriorMu) );
+   std::memset( PriorCov, 0, sizeof(PriorCov) );
+}
+
+//-----------------------------------------------------------------------------
+// EngineRequest::Input
+//-----------------------------------------------------------------------------
+EngineInput EngineRequest::Input() const
+{
+   EngineInput In;
+
+   In.k    = k;
+   In.H    = H;
+   In.Base = Base;
+
+   In.W  = int( Xw.size() );
+   In.Xw = Xw.empty() ? NULL : const_cast<double*>( &Xw[0] );
+   In.Yw = Yw.empty() ? NULL : const_cast<double*>( &Yw[0] );
+   In.Qw = Qw.empty() ? NULL : const_cast<double*>( &Qw[0] );
+
+   In.P  = int( Xp.size() );
+   In.Xp = Xp.empty() ? NULL : const_cast<double*>( &Xp[0] );
+   In.Yp = Yp.empty() ? NULL : const_cast<double*>( &Yp[0] );
+   In.Ep = Ep.empty() ? NULL : const_cast<double*>( &Ep[0] );
+   In.Sp = Sp.empty() ? NULL : const_cast<double*>( &Sp[0] );
+
+   In.Xo = Xo;
+   In.Yo = Yo;
+   In.nSims  = nSims;
+   In.Seed   = Seed;
+   In.Stream = Stream;
+
+   In.Options.CollapseReadings = CollapseReadings;
+   In.Options.UsePrior = UsePrior;
+   if (UsePrior)
+   {
+      std::memcpy( In.Options.PriorMu, PriorMu, sizeof(PriorMu) );
+      std::memcpy( In.Options.PriorCov, PriorCov, sizeof(PriorCov) );
+   }
+
+   return In;
+}
+
+//-----------------------------------------------------------------------------
+// EncodeRequest
+//
+//    Write the request body for one Engine run.
+//-----------------------------------------------------------------------------
+void EncodeRequest( const EngineInput& In, std::vector<char>& Body )
+{
+   Body.clear();
+   Body.reserve( 128 + 8*(3*In.W + 4*In.P) );
+
+   Put( Body, In.k );
+   Put( Body, In.H );
+   Put( Body, In.Base );
+
+   Put( Body, In.W );
+   PutArray( Body, In.Xw, In.W );
+   PutArray( Body, In.Yw, In.W );
+   PutArray( Body, In.Qw, In.W );
+
+   Put( Body, In.P );
+   PutArray( Body, In.Xp, In.P );
+   PutArray( Body, In.Yp, In.P );
+   PutArray( Body, In.Ep, In.P );
+   PutArray( Body, In.Sp, In.P );
+
+   Put( Body, In.Xo );
+   Put( Body, In.Yo );
+   Put( Body, In.nSims );
+   Put( Body, In.Seed );
+   Put( Body, In.Stream );
+
+   unsigned int flags = 0;
+   if (In.Options.CollapseReadings) flags |= FLAG_COLLAPSE_READINGS;
+   if (In.Options.UsePrior) flags |= FLAG_USE_PRIOR;
+   Put( Body, flags );
+
+   if (In.Options.UsePrior)
+   {
+      PutArray( Body, In.Options.PriorMu, 6 );
+      PutArray( Body, &In.Options.PriorCov[0][0], 36 );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// DecodeRequest
+//
+//    Read a request body.  Returns false if the body is malformed -- 
+//    truncated, with trailing bytes, or with negative counts -- or if the
+//    request exceeds PROTOCOL_MAX_SIMS or PROTOCOL_MAX_WORK.
+//-----------------------------------------------------------------------------
+bool DecodeRequest( const char* Body, std::size_t Length, EngineRequest& Request )
+{
+   Reader R( Body, Length );
+   int W = 0, P = 0;
+   unsigned int flags = 0;
+
+   R.Get( Request.k );
+   R.Get( Request.H );
+   R.Get( Request.Base );
+
+   R.Get( W );
+   R.GetArray( W, Request.Xw );
+   R.GetArray( W, Request.Yw );
+   R.GetArray( W, Request.Qw );
+
+   R.Get( P );
+   R.GetArray( P, Request.Xp );
+   R.GetArray( P, Request.Yp );
+   R.GetArray( P, Request.Ep );
+   R.GetArray( P, Request.Sp );
+
+   R.Get( Request.Xo );
+   R.Get( Request.Yo );
+   R.Get( Request.nSims );
+   R.Get( Request.Seed );
+   R.Get( Request.Stream );
+
+   if( !R.Get( flags ) ) return false;
+   Request.CollapseReadings = ( flags & FLAG_COLLAPSE_READINGS ) != 0;
+   Request.UsePrior = ( flags & FLAG_USE_PRIOR ) != 0;
+
+   if (Request.UsePrior)
+   {
+      for (int i=0; i<6; ++i)
+         R.Get( Request.PriorMu[i] );
+      for (int i=0; i<6; ++i)
+         for (int j=0; j<6; ++j)
+            R.Get( Request.PriorCov[i][j] );
+   }
+
+   return R.AtEnd() 
+      && Request.nSims >= 0 && Request.nSims <= PROTOCOL_MAX_SIMS
+      && static_cast<long long>( W )*P <= PROTOCOL_MAX_WORK;
+}
+
+//-----------------------------------------------------------------------------
+// EncodeResponse
+//
+//    Write the response body for one Engine run.  See the header for the
+//    meaning of Segment.
+//-----------------------------------------------------------------------------
+void EncodeResponse( int Status, const EngineReturn& S, const std::string& Segment, std::vector<char>& Body )
+{
+   const int nSims = ( Status == ENGINE_OK ) ? S.nSims : 0;
+   const bool inline_sims = Segment.empty();
+
+   Body.clear();
+   Body.reserve( 512 + ( inline_sims ? 6*sizeof(double)*nSims : 0 ) );
+
+   Put( Body, Status );
+   PutString( Body, S.Version );
+   PutString( Body, S.RunTime );
+   Put( Body, S.Xo );
+   Put( Body, S.Yo );
+   Put( Body, S.Seed );
+   Put( Body, S.Stream );
+   PutArray( Body, S.Mu, 6 );
+   PutArray( Body, &S.Cov[0][0], 36 );
+   Put( Body, nSims );
+   PutString( Body, Segment );
+
+   if (inline_sims)
+      for (int i=0; i<nSims; ++i)
+         PutArray( Body, S.a[i], 6 );
+}
+
+//-----------------------------------------------------------------------------
+// DecodeResponse
+//
+//    Read a response body.  Returns false if the body is malformed.
+//-----------------------------------------------------------------------------
+bool DecodeResponse( const char* Body, std::size_t Length, int& Status, EngineReturn& S, std::string& Segment )
+{
+   Reader R( Body, Length );
+   int nSims;
+
+   R.Get( Status );
+   R.GetString( S.Version );
+   R.GetString( S.RunTime );
+   R.Get( S.Xo );
+   R.Get( S.Yo );
+   R.Get( S.Seed );
+   R.Get( S.Stream );
+   for (int i=0; i<6; ++i)
+      R.Get( S.Mu[i] );
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         R.Get( S.Cov[i][j] );
+   R.Get( nSims );
+   R.GetString( Segment );
+
+   if( !R.Ok() || nSims < 0 ) return false;
+
+   S.nSims = nSims;
+   S.a = NULL;
+   if( !Segment.empty() || nSims == 0 ) 
+      return R.AtEnd();
+
+   if( R.Remaining() != 6*sizeof(double)*std::size_t(nSims) ) return false;
+
+   S.a = new double*[nSims];
+   for (int i=0; i<nSims; ++i)
+   {
+      S.a[i] = new double[6];
+      for (int j=0; j<6; ++j)
+         R.Get( S.a[i][j] );
+   }
+
+   return true;
+}
+
+
+} // namespace oneka
@@ -0,0 +1,141 @@
+//=============================================================================
+// engine_protocol.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENGINE_PROTOCOL_H
+#define ENGINE_PROTOCOL_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "engine_batch.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// A compact binary message format for Engine requests and responses, used
+// by the local Engine service (see Service/).
+//
+// Every message is a MessageHeader followed by Length bytes of body.  The
+// fields are written in the native byte order and floating point format,
+// since both ends of the connection run on the same machine.
+//
+// A request body carries the arguments of Engine( const EngineInput& ):
+// the scalars, the well and piezometer arrays, the random number seed and
+// stream, and the CollapseReadings and UsePrior options (with the prior).
+// The monitor and the derived quantity options are not sent.
+//
+// A response body carries the status, the version and run time strings, 
+// the origin, the seed and stream, the mean and covariance, and the 
+// realizations.  The 
+// realizations are either inline -- nSims rows of 6 doubles -- or in a 
+// shared memory segment laid out the same way.  The descriptor of the 
+// segment is passed along with the response (SCM_RIGHTS); its name, 
+// already unlinked, is sent only to mark the realizations as out of line.
+//-----------------------------------------------------------------------------
+const unsigned int PROTOCOL_MAGIC   = 0x4b4e4f31;    // "1ONK"
+const unsigned int PROTOCOL_VERSION = 3;
+
+enum MessageType
+{
+   MESSAGE_REQUEST = 1,
+   MESSAGE_RESPONSE = 2
+};
+
+struct MessageHeader
+{
+   unsigned int Magic;
+   unsigned int Version;
+   unsigned int Type;      // a MessageType.
+   unsigned int Id;        // chosen by the client, echoed in the response.
+   unsigned int Length;    // body length in bytes.
+};
+
+// Largest accepted body.
+const unsigned int PROTOCOL_MAX_LENGTH = 1u << 30;
+
+// Largest accepted requests: realizations per request (their inline 
+// response fits in PROTOCOL_MAX_LENGTH), and wells times piezometers, the
+// work of assembling the equations.
+const int PROTOCOL_MAX_SIMS = 1 << 24;
+const long long PROTOCOL_MAX_WORK = 1LL << 32;
+
+//-----------------------------------------------------------------------------
+// A decoded request.  The request owns the arrays; the EngineInput built
+// by Input() points into them, and is valid while the request is alive
+// and unchanged.
+//-----------------------------------------------------------------------------
+struct EngineRequest
+{
+   EngineRequest();
+
+   EngineInput Input() const;
+
+   double k, H, Base;
+   std::vector<double> Xw, Yw, Qw;
+   std::vector<double> Xp, Yp, Ep, Sp;
+   double Xo, Yo;
+   int nSims;
+   unsigned long long Seed;
+   unsigned long long Stream;
+
+   bool CollapseReadings;
+   bool UsePrior;
+   double PriorMu[6];
+   double PriorCov[6][6];
+};
+
+void EncodeRequest( const EngineInput& In, std::vector<char>& Body );
+bool DecodeRequest( const char* Body, std::size_t Length, EngineRequest& Request );
+
+//-----------------------------------------------------------------------------
+// Responses.  If Segment is empty the realizations of S are sent inline;
+// otherwise only the segment name is sent, and S.a is not read.
+//
+// DecodeResponse allocates S.a for inline realizations, as Engine does; 
+// for a segment, S.a is left NULL and the segment name is returned.
+//-----------------------------------------------------------------------------
+const int ENGINE_BAD_REQUEST = -1;     // a status: the request was malformed.
+
+void EncodeResponse( int Status, const EngineReturn& S, const std::string& Segment, std::vector<char>& Body );
+bool DecodeResponse( const char* Body, std::size_t Length, int& Status, EngineReturn& S, std::string& Segment );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ENGINE_PROTOCOL_H
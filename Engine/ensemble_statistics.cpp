@@ -0,0 +1,547 @@
+//=============================================================================
+// ensemble_statistics.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "ensemble_statistics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "head_field.h"
+
+namespace{
+   // The number of head values evaluated at a time by AccumulateHeads: 
+   // 2 MB of doubles per block.
+   const int CHUNK_VALUES = 262144;
+
+   // The default number of blocks in AccumulateHeads: fixed, so that the
+   // result does not depend on the machine, and enough to occupy the 
+   // threads of a typical workstation.
+   const int DEFAULT_BLOCKS = 16;
+
+   //--------------------------------------------------------------------------
+   // The desired position of P-squared marker i after n observations, for
+   // the p'th quantile.  See Jain and Chlamtac (1985), Box 1, B3.
+   //--------------------------------------------------------------------------
+   double DesiredPosition( int i, int n, double p )
+   {
+      switch (i)
+      {
+         case 0:  return 1;
+         case 1:  return 1 + (n-1)*p/2;
+         case 2:  return 1 + (n-1)*p;
+         case 3:  return 1 + (n-1)*(1+p)/2;
+         default: return n;
+      }
+   }
+}
+
+namespace oneka{
+
+//=============================================================================
+// EnsembleStatistics
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Null constructor.
+//-----------------------------------------------------------------------------
+EnsembleStatistics::EnsembleStatistics()
+:  m_N( 0 ),
+   m_Count( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Constructor.
+//
+// Arguments:
+//    N              number of points in each field [#].
+//    nThresholds    number of exceedance thresholds [#].
+//    Thresholds     (nThresholds x 1) array of thresholds.
+//    nProbabilities number of quantiles to estimate [#].
+//    Probabilities  (nProbabilities x 1) array of quantile probabilities, 
+//                   each strictly between 0 and 1.
+//-----------------------------------------------------------------------------
+EnsembleStatistics::EnsembleStatistics( 
+   int N, 
+   int nThresholds, const double* Thresholds, 
+   int nProbabilities, const double* Probabilities )
+:  m_N( N ),
+   m_Count( 0 ),
+   m_Mean( 1, N ),
+   m_M2( 1, N ),
+   m_Min( 1, N ),
+   m_Max( 1, N ),
+   m_Thresholds( Thresholds, Thresholds + nThresholds ),
+   m_Exceed( nThresholds, N ),
+   m_Probabilities( Probabilities, Probabilities + nProbabilities ),
+   m_Height( N, 5*nProbabilities ),
+   m_Position( N, 5*nProbabilities )
+{
+   assert( N > 0 );
+   assert( nThresholds >= 0 );
+   assert( nProbabilities >= 0 );
+
+   for (int k=0; k<nProbabilities; ++k)
+      assert( 0 < Probabilities[k] && Probabilities[k] < 1 );
+}
+
+//-----------------------------------------------------------------------------
+// Add each row of Fields, an (m x N) Matrix, as a separate realization.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Add( const Matrix& Fields )
+{
+   assert( Fields.nCols() == m_N );
+
+   for (int i=0; i<Fields.nRows(); ++i)
+      Add( Fields.Base(i,0) );
+}
+
+//-----------------------------------------------------------------------------
+// Add a single realization: the (N) array Field.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Add( const double* x )
+{
+   ++m_Count;
+   const double n = m_Count;
+
+   // Welford's update of the mean and sum of squared deviations.
+   double* mean = m_Mean.Base();
+   double* m2   = m_M2.Base();
+
+   for (int j=0; j<m_N; ++j)
+   {
+      double delta = x[j] - mean[j];
+      mean[j] += delta/n;
+      m2[j]   += delta*(x[j] - mean[j]);
+   }
+
+   // Extremes.
+   double* lo = m_Min.Base();
+   double* hi = m_Max.Base();
+
+   if (m_Count == 1)
+   {
+      for (int j=0; j<m_N; ++j)
+         lo[j] = hi[j] = x[j];
+   }
+   else
+   {
+      for (int j=0; j<m_N; ++j)
+      {
+         lo[j] = (x[j] < lo[j]) ? x[j] : lo[j];
+         hi[j] = (x[j] > hi[j]) ? x[j] : hi[j];
+      }
+   }
+
+   // Exceedance counts.
+   for (int t=0; t<static_cast<int>(m_Thresholds.size()); ++t)
+   {
+      const double threshold = m_Thresholds[t];
+      double* count = m_Exceed.Base(t,0);
+
+      for (int j=0; j<m_N; ++j)
+         count[j] += (x[j] > threshold) ? 1 : 0;
+   }
+
+   // Quantiles.
+   if (!m_Probabilities.empty())
+   {
+      for (int j=0; j<m_N; ++j)
+         UpdateQuantiles( j, x[j], m_Count );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// UpdateQuantiles
+//
+//    Add the observation x at point j to the P-squared markers of every
+//    quantile, where x is observation number "count".  The first five
+//    observations are simply stored.  See Jain and Chlamtac (1985), Box 1.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::UpdateQuantiles( int j, double x, int count )
+{
+   for (int k=0; k<static_cast<int>(m_Probabilities.size()); ++k)
+   {
+      double* q = m_Height.Base(j, 5*k);
+      double* n = m_Position.Base(j, 5*k);
+
+      if (count <= 5)
+      {
+         q[count-1] = x;
+         if (count == 5)
+         {
+            std::sort( q, q+5 );
+            for (int i=0; i<5; ++i) n[i] = i+1;
+         }
+         continue;
+      }
+
+      // Find the cell containing x, and adjust the extreme markers.
+      int c;
+      if (x < q[0])
+      {
+         q[0] = x;
+         c = 0;
+      }
+      else if (x >= q[4])
+      {
+         q[4] = x;
+         c = 3;
+      }
+      else
+      {
+         c = 0;
+         while (x >= q[c+1]) ++c;
+      }
+
+      for (int i=c+1; i<5; ++i) n[i] += 1;
+
+      // Adjust the heights of the interior markers if necessary.
+      const double p = m_Probabilities[k];
+      for (int i=1; i<4; ++i)
+      {
+         double d = DesiredPosition( i, count, p ) - n[i];
+
+         if ((d >= 1 && n[i+1]-n[i] > 1) || (d <= -1 && n[i-1]-n[i] < -1))
+         {
+            int s = (d > 0) ? 1 : -1;
+
+            // Piecewise-parabolic prediction.
+            double qp = q[i] + s/(n[i+1]-n[i-1]) * 
+               ( (n[i]-n[i-1]+s)*(q[i+1]-q[i])/(n[i+1]-n[i]) 
+               + (n[i+1]-n[i]-s)*(q[i]-q[i-1])/(n[i]-n[i-1]) );
+
+            // Fall back to linear prediction if the parabola misbehaves.
+            if (qp <= q[i-1] || qp >= q[i+1])
+               qp = q[i] + s*(q[i+s]-q[i])/(n[i+s]-n[i]);
+
+            q[i] = qp;
+            n[i] += s;
+         }
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Merge the realizations accumulated in S into this accumulator.
+//
+// Notes:
+// o  The mean, variance, extremes and exceedance counts are merged exactly
+//    (Chan et al., 1979).
+//
+// o  The P-squared algorithm has no exact merge.  If either side has fewer
+//    than five observations they are replayed into the other side. 
+//    Otherwise, the interior marker heights are averaged, weighted by the
+//    counts, and the marker positions are reset to their desired positions.
+//
+// o  Merging is deterministic: the same accumulators merged in the same 
+//    order always give the same result.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Merge( const EnsembleStatistics& S )
+{
+   assert( S.m_N == m_N );
+   assert( S.m_Thresholds == m_Thresholds );
+   assert( S.m_Probabilities == m_Probabilities );
+
+   if (S.m_Count == 0) return;
+   if (m_Count == 0)
+   {
+      *this = S;
+      return;
+   }
+
+   const double na = m_Count;
+   const double nb = S.m_Count;
+   const double n  = na + nb;
+
+   // Mean and sum of squared deviations.
+   for (int j=0; j<m_N; ++j)
+   {
+      double delta = S.m_Mean(0,j) - m_Mean(0,j);
+      m_Mean(0,j) += delta*nb/n;
+      m_M2(0,j)   += S.m_M2(0,j) + delta*delta*na*nb/n;
+   }
+
+   // Extremes and exceedance counts.
+   for (int j=0; j<m_N; ++j)
+   {
+      if (S.m_Min(0,j) < m_Min(0,j)) m_Min(0,j) = S.m_Min(0,j);
+      if (S.m_Max(0,j) > m_Max(0,j)) m_Max(0,j) = S.m_Max(0,j);
+   }
+
+   for (int t=0; t<m_Exceed.nRows(); ++t)
+      for (int j=0; j<m_N; ++j)
+         m_Exceed(t,j) += S.m_Exceed(t,j);
+
+   // Quantiles.
+   if (!m_Probabilities.empty())
+   {
+      if (S.m_Count < 5)
+      {
+         for (int r=0; r<S.m_Count; ++r)
+            for (int j=0; j<m_N; ++j)
+               UpdateQuantiles( j, S.m_Height(j,r), m_Count + r + 1 );
+      }
+      else if (m_Count < 5)
+      {
+         Matrix Stored( m_Height );
+         m_Height   = S.m_Height;
+         m_Position = S.m_Position;
+
+         for (int r=0; r<m_Count; ++r)
+            for (int j=0; j<m_N; ++j)
+               UpdateQuantiles( j, Stored(j,r), S.m_Count + r + 1 );
+      }
+      else
+      {
+         const int total = m_Count + S.m_Count;
+
+         for (int j=0; j<m_N; ++j)
+         {
+            for (int k=0; k<static_cast<int>(m_Probabilities.size()); ++k)
+            {
+               double* q = m_Height.Base(j, 5*k);
+               double* pos = m_Position.Base(j, 5*k);
+               const double* qb = S.m_Height.Base(j, 5*k);
+
+               q[0] = (qb[0] < q[0]) ? qb[0] : q[0];
+               q[4] = (qb[4] > q[4]) ? qb[4] : q[4];
+               for (int i=1; i<4; ++i)
+                  q[i] = (na*q[i] + nb*qb[i])/n;
+
+               pos[0] = 1;
+               for (int i=1; i<5; ++i)
+               {
+                  pos[i] = floor( DesiredPosition( i, total, m_Probabilities[k] ) + 0.5 );
+                  if (pos[i] <= pos[i-1]) pos[i] = pos[i-1] + 1;
+               }
+            }
+         }
+      }
+   }
+
+   m_Count += S.m_Count;
+}
+
+//-----------------------------------------------------------------------------
+// Forget all realizations, retaining the points, thresholds and quantiles.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Clear()
+{
+   m_Count = 0;
+
+   m_Mean = 0.0;
+   m_M2 = 0.0;
+   m_Min = 0.0;
+   m_Max = 0.0;
+   m_Exceed = 0.0;
+   m_Height = 0.0;
+   m_Position = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Number of points.
+//-----------------------------------------------------------------------------
+int EnsembleStatistics::nPoints() const
+{
+   return m_N;
+}
+
+//-----------------------------------------------------------------------------
+// Number of realizations accumulated.
+//-----------------------------------------------------------------------------
+int EnsembleStatistics::Count() const
+{
+   return m_Count;
+}
+
+//-----------------------------------------------------------------------------
+// Mean at each point.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Mean( Matrix& x ) const
+{
+   x = m_Mean;
+}
+
+//-----------------------------------------------------------------------------
+// Sample variance at each point.  This is zero for fewer than two
+// realizations.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Variance( Matrix& x ) const
+{
+   x.Resize( 1, m_N );
+
+   if (m_Count > 1)
+   {
+      for (int j=0; j<m_N; ++j)
+         x(0,j) = m_M2(0,j)/(m_Count-1);
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Minimum at each point.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Min( Matrix& x ) const
+{
+   x = m_Min;
+}
+
+//-----------------------------------------------------------------------------
+// Maximum at each point.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Max( Matrix& x ) const
+{
+   x = m_Max;
+}
+
+//-----------------------------------------------------------------------------
+// Fraction of the realizations that exceed each threshold at each point:
+// x(t,j) is the estimated probability that the field at point j exceeds 
+// threshold t.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Exceedance( Matrix& x ) const
+{
+   x.Resize( m_Exceed.nRows(), m_N );
+
+   if (m_Count > 0)
+   {
+      for (int t=0; t<m_Exceed.nRows(); ++t)
+         for (int j=0; j<m_N; ++j)
+            x(t,j) = m_Exceed(t,j)/m_Count;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Estimated quantiles at each point: x(k,j) is the estimated quantile at
+// point j for probability k.  With five or fewer realizations the exact
+// sample quantiles are returned.
+//-----------------------------------------------------------------------------
+void EnsembleStatistics::Quantiles( Matrix& x ) const
+{
+   const int nP = static_cast<int>(m_Probabilities.size());
+   x.Resize( nP, m_N );
+
+   if (m_Count == 0) return;
+
+   for (int k=0; k<nP; ++k)
+   {
+      for (int j=0; j<m_N; ++j)
+      {
+         const double* q = m_Height.Base(j, 5*k);
+
+         if (m_Count > 5)
+         {
+            x(k,j) = q[2];
+         }
+         else
+         {
+            // Sort the (at most five) observations, by insertion.  At five
+            // the markers are just the sample, so q[2] is its median.
+            double v[5];
+            const int n = std::min( m_Count, 5 );
+            for (int i=0; i<n; ++i)
+            {
+               int m = i;
+               for (; m>0 && v[m-1] > q[i]; --m) v[m] = v[m-1];
+               v[m] = q[i];
+            }
+
+            double r = m_Probabilities[k]*(m_Count-1);
+            int lo = static_cast<int>(floor(r));
+            int hi = (lo+1 < m_Count) ? lo+1 : lo;
+            x(k,j) = v[lo] + (r-lo)*(v[hi]-v[lo]);
+         }
+      }
+   }
+}
+
+
+//=============================================================================
+// AccumulateHeads
+//
+// Arguments:
+//    S        the evaluation points.
+//    k        hydraulic conductivity [L/T].
+//    H        aquifer thickness [L].
+//    Base     elevation of the aquifer base [L].
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//    Stats    on exit, Stats has accumulated the nSims head fields.
+//    nBlocks  number of independent accumulators.
+//
+// Notes:
+// o  Each block evaluates its heads in chunks of at most CHUNK_VALUES 
+//    values, so the working memory is O(nBlocks * N).
+//=============================================================================
+void AccumulateHeads( 
+   const PointSet& S, double k, double H, double Base, 
+   int nSims, const double* const* a, 
+   EnsembleStatistics& Stats, int nBlocks )
+{
+   assert( S.nPoints() == Stats.nPoints() );
+   assert( nSims > 0 );
+
+   if (nBlocks <= 0) nBlocks = DEFAULT_BLOCKS;
+   if (nBlocks > nSims) nBlocks = nSims;
+
+   const int nRows = (CHUNK_VALUES/S.nPoints() > 0) ? CHUNK_VALUES/S.nPoints() : 1;
+
+   EnsembleStatistics Empty( Stats );
+   Empty.Clear();
+   std::vector< EnsembleStatistics > Block( nBlocks, Empty );
+
+   #pragma omp parallel for schedule(dynamic)
+   for (int b=0; b<nBlocks; ++b)
+   {
+      const int i0 = static_cast<int>( (static_cast<double>(nSims)*b)/nBlocks );
+      const int i1 = static_cast<int>( (static_cast<double>(nSims)*(b+1))/nBlocks );
+
+      Matrix Heads;
+      for (int i=i0; i<i1; i+=nRows)
+      {
+         int m = (i1-i < nRows) ? i1-i : nRows;
+         EvaluateHeads( S, k, H, Base, m, a+i, Heads );
+         Block[b].Add( Heads );
+      }
+   }
+
+   for (int b=0; b<nBlocks; ++b)
+      Stats.Merge( Block[b] );
+}
+
+
+} // namespace oneka
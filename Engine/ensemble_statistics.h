@@ -0,0 +1,137 @@
+//=============================================================================
+// ensemble_statistics.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENSEMBLE_STATISTICS_H
+#define ENSEMBLE_STATISTICS_H
+
+#include <vector>
+
+#include "matrix.h"
+#include "point_set.h"
+
+namespace oneka{
+
+//=============================================================================
+// EnsembleStatistics
+//
+//    Streaming per-point statistics of an ensemble of fields.  The fields
+//    are added a chunk of realizations at a time, and only O(N) numbers are
+//    retained, regardless of the number of realizations:
+//
+//    o  the mean and variance (Welford's algorithm),
+//    o  the minimum and maximum,
+//    o  the number of realizations exceeding each of a set of thresholds,
+//    o  P-squared estimates of a set of quantiles (Jain and Chlamtac, 1985).
+//
+//    Two accumulators over the same points, thresholds and probabilities
+//    can be merged, so independent accumulators can be filled in parallel.
+//
+// References:
+// o  Chan, T.F., G.H. Golub, and R.J. LeVeque, 1979, Updating Formulae and
+//    a Pairwise Algorithm for Computing Sample Variances, Technical Report
+//    STAN-CS-79-773, Stanford University.
+//
+// o  Jain, R., and I. Chlamtac, 1985, The P-Square Algorithm for Dynamic
+//    Calculation of Quantiles and Histograms Without Storing Observations,
+//    Communications of the ACM, v. 28, n. 10, pp. 1076-1085.
+//=============================================================================
+class EnsembleStatistics
+{
+public:
+   // Life cycle
+   EnsembleStatistics();                              // null constructor
+   EnsembleStatistics( 
+      int N, 
+      int nThresholds, const double* Thresholds, 
+      int nProbabilities, const double* Probabilities );
+
+   // Accumulation.
+   void Add( const Matrix& Fields );                  // (m x N) realizations
+   void Add( const double* Field );                   // (N) one realization
+   void Merge( const EnsembleStatistics& S );
+   void Clear();                                      // forget all realizations
+
+   // Inquiry.
+   int nPoints() const;                               // number of points
+   int Count() const;                                 // number of realizations
+
+   void Mean( Matrix& x ) const;                      // (1 x N)
+   void Variance( Matrix& x ) const;                  // (1 x N)
+   void Min( Matrix& x ) const;                       // (1 x N)
+   void Max( Matrix& x ) const;                       // (1 x N)
+   void Exceedance( Matrix& x ) const;                // (nThresholds x N)
+   void Quantiles( Matrix& x ) const;                 // (nProbabilities x N)
+
+private:
+   void UpdateQuantiles( int j, double x, int count );
+
+   int    m_N;                                        // number of points
+   int    m_Count;                                    // number of realizations
+
+   Matrix m_Mean;                                     // (1 x N) running mean
+   Matrix m_M2;                                       // (1 x N) sum of squared deviations
+   Matrix m_Min;                                      // (1 x N) running minimum
+   Matrix m_Max;                                      // (1 x N) running maximum
+
+   std::vector<double> m_Thresholds;
+   Matrix m_Exceed;                                   // (nThresholds x N) counts
+
+   std::vector<double> m_Probabilities;
+   Matrix m_Height;                                   // (N x 5*nProbabilities) marker heights
+   Matrix m_Position;                                 // (N x 5*nProbabilities) marker positions
+};
+
+
+//-----------------------------------------------------------------------------
+// Accumulate the statistics of the piezometric heads at the points in S over
+// nSims realizations, without storing the (nSims x N) head fields.
+//
+// The realizations are split into nBlocks contiguous blocks, each block is
+// accumulated independently (in parallel), and the blocks are merged in 
+// order.  The result depends on nBlocks, but not on the number of threads.
+// If nBlocks <= 0, 16 blocks are used.
+//-----------------------------------------------------------------------------
+void AccumulateHeads( 
+   const PointSet& S, double k, double H, double Base, 
+   int nSims, const double* const* a, 
+   EnsembleStatistics& Stats, int nBlocks = 0 );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ENSEMBLE_STATISTICS_H
@@ -0,0 +1,371 @@
+//=============================================================================
+// fitted_model.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "fitted_model.h"
+
+#include <cmath>
+#include <limits>
+
+#include "gaussian.h"
+#include "oneka_engine.h"
+#include "oneka_model.h"
+#include "triangular_factor.h"
+
+namespace{
+   const int N = 6;
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Constructor.
+//
+// Arguments:
+//    k     hydraulic conductivity [L/T].
+//    H     aquifer thickness [L].
+//    Base  elevation of the aquifer base [L].
+//
+//    W     number of discharge specified wells [#].
+//    Xw    (W x 1) array of well x-coordinates [L].
+//    Yw    (W x 1) array of well y-coordinates [L].
+//    Qw    (W x 1) array of well discharges [L^3/T].
+//
+//    Xo    x-coordinate of model origin [L].
+//    Yo    y-coordinate of model origin [L].
+//
+// Notes:
+// o  The model starts with no piezometers and no prior.
+//-----------------------------------------------------------------------------
+FittedModel::FittedModel( 
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   double Xo, double Yo )
+:  m_k( k ),
+   m_H( H ),
+   m_Base( Base ),
+   m_Xw( Xw, Xw+W ),
+   m_Yw( Yw, Yw+W ),
+   m_Qw( Qw, Qw+W ),
+   m_Xo( Xo ),
+   m_Yo( Yo ),
+   m_HasPrior( false )
+{
+   Refactor();
+}
+
+//-----------------------------------------------------------------------------
+// Add
+//
+//    Add a piezometer.  Returns false, and does nothing, if a piezometer
+//    with the same id already exists.
+//
+// Arguments:
+//    id    piezometer identifier.
+//    Xp    x-coordinate of the piezometer [L].
+//    Yp    y-coordinate of the piezometer [L].
+//    Ep    expected value of the head [L].
+//    Sp    standard deviation of the head [L].
+//-----------------------------------------------------------------------------
+bool FittedModel::Add( int id, double Xp, double Yp, double Ep, double Sp )
+{
+   if( m_Piezometers.count(id) > 0 ) return false;
+
+   Piezometer& p = m_Piezometers[id];
+   p.Xp = Xp;
+   p.Yp = Yp;
+   p.Ep = Ep;
+   p.Sp = Sp;
+   Equation( p );
+
+   Insert( p.row, p.rhs );
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Update
+//
+//    Replace the reading at an existing piezometer.  Returns false, and 
+//    does nothing, if there is no piezometer with the given id.
+//
+// Arguments:
+//    id    piezometer identifier.
+//    Ep    expected value of the head [L].
+//    Sp    standard deviation of the head [L].
+//-----------------------------------------------------------------------------
+bool FittedModel::Update( int id, double Ep, double Sp )
+{
+   std::map<int,Piezometer>::iterator it = m_Piezometers.find(id);
+   if( it == m_Piezometers.end() ) return false;
+
+   Piezometer& p = it->second;
+   Piezometer old = p;
+
+   p.Ep = Ep;
+   p.Sp = Sp;
+   Equation( p );
+
+   Insert( p.row, p.rhs );
+   if( !Delete( old.row, old.rhs ) ) Refactor();
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Remove
+//
+//    Remove a piezometer.  Returns false, and does nothing, if there is no
+//    piezometer with the given id.
+//-----------------------------------------------------------------------------
+bool FittedModel::Remove( int id )
+{
+   std::map<int,Piezometer>::iterator it = m_Piezometers.find(id);
+   if( it == m_Piezometers.end() ) return false;
+
+   Piezometer old = it->second;
+   m_Piezometers.erase( it );
+
+   if( !Delete( old.row, old.rhs ) ) Refactor();
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Refactor
+//
+//    Recompute the factorization from the retained equations.  This costs
+//    O(36 P).
+//-----------------------------------------------------------------------------
+void FittedModel::Refactor()
+{
+   for (int i=0; i<N; ++i)
+   {
+      m_z[i] = 0;
+      for (int j=0; j<N; ++j)
+         m_R[i][j] = 0;
+   }
+
+   if( m_HasPrior )
+      for (int i=0; i<N; ++i)
+         Insert( m_PriorRows[i], m_PriorRhs[i] );
+
+   for (std::map<int,Piezometer>::const_iterator it = m_Piezometers.begin(); it != m_Piezometers.end(); ++it)
+      Insert( it->second.row, it->second.rhs );
+}
+
+//-----------------------------------------------------------------------------
+// SetPrior
+//
+//    Set, or replace, the Gaussian prior N(Mu0, Cov0) on the coefficients.
+//    Returns false, and does nothing, if Cov0 is not positive definite.
+//-----------------------------------------------------------------------------
+bool FittedModel::SetPrior( const double Mu0[6], const double Cov0[6][6] )
+{
+   double rows[6][6];
+   double rhs[6];
+   if( !PriorEquations( Mu0, Cov0, rows, rhs ) ) return false;
+
+   for (int i=0; i<N; ++i)
+      Insert( rows[i], rhs[i] );
+
+   bool ok = true;
+   if( m_HasPrior )
+      for (int i=0; i<N && ok; ++i)
+         ok = Delete( m_PriorRows[i], m_PriorRhs[i] );
+
+   for (int i=0; i<N; ++i)
+   {
+      for (int j=0; j<N; ++j)
+         m_PriorRows[i][j] = rows[i][j];
+      m_PriorRhs[i] = rhs[i];
+   }
+   m_HasPrior = true;
+
+   if( !ok ) Refactor();
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// ClearPrior
+//-----------------------------------------------------------------------------
+void FittedModel::ClearPrior()
+{
+   if( !m_HasPrior ) return;
+
+   bool ok = true;
+   for (int i=0; i<N && ok; ++i)
+      ok = Delete( m_PriorRows[i], m_PriorRhs[i] );
+
+   m_HasPrior = false;
+   if( !ok ) Refactor();
+}
+
+//-----------------------------------------------------------------------------
+// HasPrior
+//-----------------------------------------------------------------------------
+bool FittedModel::HasPrior() const
+{
+   return m_HasPrior;
+}
+
+//-----------------------------------------------------------------------------
+// nPiezometers
+//-----------------------------------------------------------------------------
+int FittedModel::nPiezometers() const
+{
+   return int( m_Piezometers.size() );
+}
+
+//-----------------------------------------------------------------------------
+// Solve
+//
+//    Compute the conditional mean vector and covariance matrix of the six
+//    coefficients [A,B,C,D,E,F] from the current factorization:
+//
+//       R Mu = z,     Cov = inv(R'R) = inv(R) inv(R)'.
+//
+// Notes:
+// o  Throws Exception_SingularSystem if the piezometers do not determine 
+//    the six coefficients (e.g. there are fewer than six).
+//-----------------------------------------------------------------------------
+void FittedModel::Solve( double Mu[6], double Cov[6][6] ) const
+{
+   if( !TriangularSolve<N>( m_R, m_z, Mu, Cov ) ) 
+      throw oneka::Exception_SingularSystem();
+}
+
+//-----------------------------------------------------------------------------
+// Simulate
+//
+//    Generate nSims equi-probable realizations of the six coefficients,
+//    one per row of X.
+//-----------------------------------------------------------------------------
+void FittedModel::Simulate( int nSims, Matrix& X ) const
+{
+   double mu[6];
+   double cov[6][6];
+   Solve( mu, cov );
+
+   Matrix Mut( 1, N, mu );
+   Matrix Cov( N, N, &cov[0][0] );
+   X.Resize( nSims, N );
+   if( !MVNormalRNG( nSims, Mut, Cov, X ) ) throw oneka::Exception_SingularSystem();
+}
+
+//-----------------------------------------------------------------------------
+// Equation
+//
+//    Compute the weighted equation for piezometer p.
+//-----------------------------------------------------------------------------
+void FittedModel::Equation( Piezometer& p ) const
+{
+   int W = int( m_Xw.size() );
+   ObservationEquation( m_k, m_H, m_Base, 
+      W, W > 0 ? &m_Xw[0] : NULL, W > 0 ? &m_Yw[0] : NULL, W > 0 ? &m_Qw[0] : NULL,
+      p.Xp, p.Yp, p.Ep, p.Sp, m_Xo, m_Yo, p.row, p.rhs );
+}
+
+//-----------------------------------------------------------------------------
+// Insert
+//
+//    Add the row [x | beta] to the factorization using Givens rotations.
+//-----------------------------------------------------------------------------
+void FittedModel::Insert( const double* row, double rhs )
+{
+   GivensInsert<N>( m_R, m_z, row, rhs );
+}
+
+//-----------------------------------------------------------------------------
+// Delete
+//
+//    Remove the row [x | beta] from the factorization (LINPACK DCHDD).
+//    Returns false, leaving the factorization unusable, if the downdated 
+//    matrix is not positive definite to working precision.
+//-----------------------------------------------------------------------------
+bool FittedModel::Delete( const double* row, double rhs )
+{
+   // Solve R'a = x.
+   double a[6];
+   double norm = 0;
+   for (int j=0; j<N; ++j)
+   {
+      if( m_R[j][j] == 0 ) return false;
+
+      double sum = row[j];
+      for (int i=0; i<j; ++i)
+         sum -= m_R[i][j]*a[i];
+      a[j] = sum/m_R[j][j];
+      norm += a[j]*a[j];
+   }
+
+   if( norm >= 1 - std::numeric_limits<double>::epsilon() ) return false;
+
+   // Determine the transformations.
+   double c[6], s[6];
+   double alpha = sqrt( 1 - norm );
+   for (int i=N-1; i>=0; --i)
+   {
+      double scale = alpha + fabs(a[i]);
+      double p = alpha/scale;
+      double q = a[i]/scale;
+      double r = sqrt( p*p + q*q );
+      c[i] = p/r;
+      s[i] = q/r;
+      alpha = scale*r;
+   }
+
+   // Apply the transformations to R.
+   for (int j=0; j<N; ++j)
+   {
+      double xx = 0;
+      for (int i=j; i>=0; --i)
+      {
+         double t = c[i]*xx + s[i]*m_R[i][j];
+         m_R[i][j] = c[i]*m_R[i][j] - s[i]*xx;
+         xx = t;
+      }
+   }
+
+   // Apply the transformations to z.
+   double zeta = rhs;
+   for (int i=0; i<N; ++i)
+   {
+      m_z[i] = (m_z[i] - s[i]*zeta)/c[i];
+      zeta = c[i]*zeta - s[i]*m_z[i];
+   }
+
+   return true;
+}
+
+
+} // namespace oneka
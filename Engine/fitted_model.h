@@ -0,0 +1,135 @@
+//=============================================================================
+// fitted_model.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef FITTED_MODEL_H
+#define FITTED_MODEL_H
+
+#include <map>
+#include <vector>
+
+#include "matrix.h"
+
+namespace oneka{
+
+//=============================================================================
+// FittedModel
+//
+//    A fitted Oneka model that is kept current as individual piezometer
+//    readings arrive, are corrected, or are withdrawn.  
+//
+//    The model retains the (6 x 6) upper triangular factor R, and z = Q'b,
+//    of the weighted least squares system, rather than the system itself.
+//    Adding a piezometer inserts one row into the factorization using 
+//    Givens rotations; removing a piezometer deletes one row using the 
+//    LINPACK Cholesky downdating algorithm.  Each change costs O(36), 
+//    regardless of the number of piezometers.
+//
+//    Piezometers are identified by a caller-supplied integer id.
+//
+//    A Gaussian prior on the coefficients, such as the posterior from an 
+//    earlier round of readings, may be included as six more rows (see 
+//    PriorEquations).  Each new round then costs only its own readings.
+//
+// Notes:
+// o  Downdating can lose accuracy when a row that dominates the fit is
+//    removed.  If the downdate fails, the factor is recomputed from the
+//    retained rows.  Refactor() may also be called explicitly.
+//
+// References:
+// o  Dongarra, J.J., C.B. Moler, J.R. Bunch, and G.W. Stewart, 1979, 
+//    LINPACK Users' Guide, SIAM, Philadelphia, Chapter 10.
+//
+// o  Golub, G.H., and C.F. Van Loan, 1996, Matrix Computations, 3rd 
+//    edition, Johns Hopkins University Press, Section 12.5.
+//=============================================================================
+class FittedModel
+{
+public:
+   // Life cycle
+   FittedModel( 
+      double k, double H, double Base,
+      int W, const double* Xw, const double* Yw, const double* Qw, 
+      double Xo, double Yo );
+
+   // Piezometers.
+   bool Add( int id, double Xp, double Yp, double Ep, double Sp );
+   bool Update( int id, double Ep, double Sp );
+   bool Remove( int id );
+   void Refactor();
+
+   // Prior.
+   bool SetPrior( const double Mu0[6], const double Cov0[6][6] );
+   void ClearPrior();
+   bool HasPrior() const;
+
+   int nPiezometers() const;
+
+   // Results.
+   void Solve( double Mu[6], double Cov[6][6] ) const;
+   void Simulate( int nSims, Matrix& X ) const;      // (nSims x 6)
+
+private:
+   struct Piezometer
+   {
+      double Xp, Yp, Ep, Sp;
+      double row[6];
+      double rhs;
+   };
+
+   void Equation( Piezometer& p ) const;
+   void Insert( const double* row, double rhs );
+   bool Delete( const double* row, double rhs );
+
+   double m_k, m_H, m_Base;
+   std::vector<double> m_Xw, m_Yw, m_Qw;
+   double m_Xo, m_Yo;
+
+   std::map<int,Piezometer> m_Piezometers;
+
+   bool   m_HasPrior;
+   double m_PriorRows[6][6];              // prior equations
+   double m_PriorRhs[6];
+
+   double m_R[6][6];                      // upper triangular factor
+   double m_z[6];                         // Q'b
+};
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // FITTED_MODEL_H
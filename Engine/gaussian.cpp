@@ -44,9 +44,95 @@
 
 #include "linear_systems.h"
 #include "matrix.h"
+#include "trace.h"
 
 namespace oneka{
 
+//=============================================================================
+// RandomStream
+//
+//    PCG32 (XSH-RR): a 64-bit linear congruential generator with a stream-
+//    dependent odd increment, and a permuted 32-bit output.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+RandomStream::RandomStream( unsigned long long seed, unsigned long long stream )
+:  m_Seed( seed ),
+   m_Stream( stream ),
+   m_State( 0 ),
+   m_Increment( (stream << 1) | 1 ),
+   m_Saved( false ),
+   m_S( 0 )
+{
+   Next();
+   m_State += seed;
+   Next();
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long RandomStream::Seed() const
+{
+   return m_Seed;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long RandomStream::Stream() const
+{
+   return m_Stream;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int RandomStream::Next()
+{
+   unsigned long long old = m_State;
+   m_State = old*6364136223846793005ULL + m_Increment;
+
+   unsigned int xorshifted = static_cast<unsigned int>( ((old >> 18) ^ old) >> 27 );
+   unsigned int rot = static_cast<unsigned int>( old >> 59 );
+   return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+//-----------------------------------------------------------------------------
+// Uniform
+//
+//    A 53-bit uniform deviate on [0,1), from two 32-bit outputs.
+//-----------------------------------------------------------------------------
+double RandomStream::Uniform()
+{
+   unsigned int a = Next() >> 5;
+   unsigned int b = Next() >> 6;
+   return (a*67108864.0 + b) * (1.0/9007199254740992.0);
+}
+
+//-----------------------------------------------------------------------------
+// Gaussian
+//
+//    The same polar Box-Mueller transformation as GaussianRNG().
+//-----------------------------------------------------------------------------
+double RandomStream::Gaussian()
+{
+   if (m_Saved)
+   {
+      m_Saved = false;
+      return m_S;
+   }
+
+   while (true)
+   {
+      double U1 = 2.0*Uniform() - 1.0;
+      double U2 = 2.0*Uniform() - 1.0;
+
+      double R = U1*U1 + U2*U2;
+      if (R<1 && R>0)
+      {
+         double P = sqrt( -2*log(R)/R );
+         m_S = P*U1;
+         m_Saved = true;
+         return P*U2;
+      }
+   }
+}
+
 //=============================================================================
 // GaussianCDF
 //
@@ -161,6 +247,8 @@ double GaussianRNG()
 //=============================================================================
 bool GaussianRNG( int M, int N, Matrix& Z )
 {
+   ONEKA_TRACE_SCOPE( "GaussianRNG" );
+
    assert( M >= 1 );
    assert( N >= 1 );
 
@@ -205,6 +293,8 @@ bool GaussianRNG( int M, int N, Matrix& Z )
 //=============================================================================
 bool MVNormalRNG( int M, const Matrix& Mu, const Matrix& Sigma, Matrix& X )
 {
+   ONEKA_TRACE_SCOPE( "MVNormalRNG" );
+
    assert( Mu.nRows() == 1 );
    assert( Mu.nCols() >= 1 );
    assert( Mu.nCols() == Sigma.nCols() );
@@ -220,4 +310,48 @@ bool MVNormalRNG( int M, const Matrix& Mu, const Matrix& Sigma, Matrix& X )
    return true;
 }
 
+//=============================================================================
+// GaussianRNG and MVNormalRNG, drawing from the stream R rather than from 
+// the global generator.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+bool GaussianRNG( RandomStream& R, int M, int N, Matrix& Z )
+{
+   ONEKA_TRACE_SCOPE( "GaussianRNG" );
+
+   assert( M >= 1 );
+   assert( N >= 1 );
+
+   Z.Resize(M,N);
+
+   double* z = Z.Base();
+   for (int k=0; k<M*N; ++k)
+   {
+      z[k] = R.Gaussian();
+   }
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+bool MVNormalRNG( RandomStream& R, int M, const Matrix& Mu, const Matrix& Sigma, Matrix& X )
+{
+   ONEKA_TRACE_SCOPE( "MVNormalRNG" );
+
+   assert( Mu.nRows() == 1 );
+   assert( Mu.nCols() >= 1 );
+   assert( Mu.nCols() == Sigma.nCols() );
+   assert( Sigma.nRows() == Sigma.nCols() );
+
+   Matrix L, U;
+   if( !CholeskyDecomposition( Sigma, L ) ) return false;
+   Transpose(L,U);
+
+   GaussianRNG(R, M, Mu.nCols(), X);
+   AffineTransformation(X,U,Mu,X);
+
+   return true;
+}
+
 } // namespace oneka
\ No newline at end of file
@@ -45,6 +45,42 @@
 
 namespace oneka{
 
+//-----------------------------------------------------------------------------
+// RandomStream
+//
+//    An independent, reproducible pseudo-random number stream, identified by
+//    a seed and a stream id.  Different stream ids with the same seed give
+//    statistically independent sequences, so concurrent computations can 
+//    each own a stream without sharing any state.
+//
+// References:
+// o  O'Neill, M.E., 2014, PCG: A Family of Simple Fast Space-Efficient 
+//    Statistically Good Algorithms for Random Number Generation, Technical 
+//    Report HMC-CS-2014-0905, Harvey Mudd College.
+//-----------------------------------------------------------------------------
+class RandomStream
+{
+public:
+   RandomStream( unsigned long long seed = 0, unsigned long long stream = 0 );
+
+   unsigned long long Seed() const;
+   unsigned long long Stream() const;
+
+   unsigned int Next();                   // uniform 32-bit integer
+   double Uniform();                      // uniform on [0,1)
+   double Gaussian();                     // standard Normal
+
+private:
+   unsigned long long m_Seed;
+   unsigned long long m_Stream;
+
+   unsigned long long m_State;
+   unsigned long long m_Increment;
+
+   bool   m_Saved;
+   double m_S;
+};
+
 //-----------------------------------------------------------------------------
 
 double GaussianCDF(double x);
@@ -56,6 +92,9 @@ double GaussianRNG();
 bool GaussianRNG( int M, int N, Matrix& Z );
 bool MVNormalRNG( int M, const Matrix& Mu, const Matrix& Sigma, Matrix& X );
 
+bool GaussianRNG( RandomStream& R, int M, int N, Matrix& Z );
+bool MVNormalRNG( RandomStream& R, int M, const Matrix& Mu, const Matrix& Sigma, Matrix& X );
+
 } // namespace oneka
 
 //=============================================================================
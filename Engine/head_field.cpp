@@ -0,0 +1,219 @@
+//=============================================================================
+// head_field.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "head_field.h"
+
+#include <cassert>
+
+#include "oneka_model.h"
+
+namespace{
+   // Tile sizes for the (nSims x N) output.  A tile of points carries six
+   // basis values and the well potential per point, so 512 points is 28 KB
+   // of input: this is reused by all of the realizations in the tile.
+   const int TILE_POINTS = 512;
+   const int TILE_SIMS   = 64;
+}
+
+namespace oneka{
+
+namespace{
+
+//-----------------------------------------------------------------------------
+// EvaluateField
+//
+//    The common kernel for EvaluatePotential and EvaluateHeads.  This is the
+//    (nSims x 6)(6 x N) matrix product, plus the well potential, computed
+//    tile by tile.  The tiles are independent, so they are distributed over
+//    the available threads.
+//-----------------------------------------------------------------------------
+void EvaluateField( 
+   const PointSet& S, bool ToHead, double k, double H, double Base,
+   int nSims, const double* const* a, Matrix& Field )
+{
+   assert( S.nPoints() > 0 );
+   assert( nSims > 0 );
+
+   const int N = S.nPoints();
+   Field.Resize( nSims, N );
+
+   const double* g0 = S.Basis(0);
+   const double* g1 = S.Basis(1);
+   const double* g2 = S.Basis(2);
+   const double* g3 = S.Basis(3);
+   const double* g4 = S.Basis(4);
+   const double* w  = S.Phiw();
+
+   const int nPointTiles = (N + TILE_POINTS - 1)/TILE_POINTS;
+   const int nSimTiles   = (nSims + TILE_SIMS - 1)/TILE_SIMS;
+   const int nTiles      = nPointTiles*nSimTiles;
+
+   #pragma omp parallel for schedule(dynamic)
+   for (int t=0; t<nTiles; ++t)
+   {
+      const int i0 = (t/nPointTiles)*TILE_SIMS;
+      const int j0 = (t%nPointTiles)*TILE_POINTS;
+      const int i1 = (i0 + TILE_SIMS   < nSims) ? i0 + TILE_SIMS   : nSims;
+      const int j1 = (j0 + TILE_POINTS < N    ) ? j0 + TILE_POINTS : N;
+
+      for (int i=i0; i<i1; ++i)
+      {
+         const double A = a[i][0];
+         const double B = a[i][1];
+         const double C = a[i][2];
+         const double D = a[i][3];
+         const double E = a[i][4];
+         const double F = a[i][5];
+
+         double* phi = Field.Base(i,0);
+
+         for (int j=j0; j<j1; ++j)
+         {
+            phi[j] = A*g0[j] + B*g1[j] + C*g2[j] + D*g3[j] + E*g4[j] + F + w[j];
+         }
+
+         if (ToHead)
+         {
+            for (int j=j0; j<j1; ++j)
+            {
+               phi[j] = PhiToHead( phi[j], k, H, Base );
+            }
+         }
+      }
+   }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+// EvaluatePotential
+//
+// Arguments:
+//    S        the evaluation points.
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//    Phi      on exit, the (nSims x N) discharge potentials [L^3/T].
+//-----------------------------------------------------------------------------
+void EvaluatePotential( const PointSet& S, int nSims, const double* const* a, Matrix& Phi )
+{
+   EvaluateField( S, false, 0, 0, 0, nSims, a, Phi );
+}
+
+//-----------------------------------------------------------------------------
+// EvaluateHeads
+//
+// Arguments:
+//    S        the evaluation points.
+//    k        hydraulic conductivity [L/T].
+//    H        aquifer thickness [L].
+//    Base     elevation of the aquifer base [L].
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//    Heads    on exit, the (nSims x N) piezometric head elevations [L].
+//-----------------------------------------------------------------------------
+void EvaluateHeads( const PointSet& S, double k, double H, double Base, int nSims, const double* const* a, Matrix& Heads )
+{
+   EvaluateField( S, true, k, H, Base, nSims, a, Heads );
+}
+
+//-----------------------------------------------------------------------------
+// EvaluateDischarge
+//
+// Arguments:
+//    S        the evaluation points.
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//    Qx       on exit, the (nSims x N) x-components of discharge [L^2/T].
+//    Qy       on exit, the (nSims x N) y-components of discharge [L^2/T].
+//
+// Notes:
+// o  The discharge is 
+//
+//       Qx = -( 2A dX + C dY + D + dPhiw/dX )
+//       Qy = -( 2B dY + C dX + E + dPhiw/dY )
+//
+//    where dX, dY and the well gradient come from the PointSet, so the 
+//    inner loops are pure multiply-adds over contiguous arrays.  The tiling
+//    and threading are as for EvaluateField.
+//-----------------------------------------------------------------------------
+void EvaluateDischarge( const PointSet& S, int nSims, const double* const* a, Matrix& Qx, Matrix& Qy )
+{
+   assert( S.nPoints() > 0 );
+   assert( nSims > 0 );
+
+   const int N = S.nPoints();
+   Qx.Resize( nSims, N );
+   Qy.Resize( nSims, N );
+
+   const double* dX = S.Basis(3);
+   const double* dY = S.Basis(4);
+   const double* gx = S.dPhiwdX();
+   const double* gy = S.dPhiwdY();
+
+   const int nPointTiles = (N + TILE_POINTS - 1)/TILE_POINTS;
+   const int nSimTiles   = (nSims + TILE_SIMS - 1)/TILE_SIMS;
+   const int nTiles      = nPointTiles*nSimTiles;
+
+   #pragma omp parallel for schedule(dynamic)
+   for (int t=0; t<nTiles; ++t)
+   {
+      const int i0 = (t/nPointTiles)*TILE_SIMS;
+      const int j0 = (t%nPointTiles)*TILE_POINTS;
+      const int i1 = (i0 + TILE_SIMS   < nSims) ? i0 + TILE_SIMS   : nSims;
+      const int j1 = (j0 + TILE_POINTS < N    ) ? j0 + TILE_POINTS : N;
+
+      for (int i=i0; i<i1; ++i)
+      {
+         const double A2 = 2*a[i][0];
+         const double B2 = 2*a[i][1];
+         const double C  = a[i][2];
+         const double D  = a[i][3];
+         const double E  = a[i][4];
+
+         double* qx = Qx.Base(i,0);
+         double* qy = Qy.Base(i,0);
+
+         for (int j=j0; j<j1; ++j)
+         {
+            qx[j] = -( A2*dX[j] + C*dY[j] + D + gx[j] );
+            qy[j] = -( B2*dY[j] + C*dX[j] + E + gy[j] );
+         }
+      }
+   }
+}
+
+
+} // namespace oneka
@@ -0,0 +1,68 @@
+//=============================================================================
+// head_field.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef HEAD_FIELD_H
+#define HEAD_FIELD_H
+
+#include "matrix.h"
+#include "point_set.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Evaluate the discharge potential, or the piezometric head, at every point
+// in a PointSet for each of nSims realizations of the coefficients.  The
+// realizations are given as in EngineReturn::a, so a chunk of realizations
+// can be evaluated by passing S.a + first.
+//
+// The results are (nSims x N): row i is the field for realization i.
+//-----------------------------------------------------------------------------
+void EvaluatePotential( const PointSet& S, int nSims, const double* const* a, Matrix& Phi );
+void EvaluateHeads( const PointSet& S, double k, double H, double Base, int nSims, const double* const* a, Matrix& Heads );
+
+//-----------------------------------------------------------------------------
+// Evaluate the discharge vector, Q = -grad(Phi), at every point in a 
+// PointSet for each of nSims realizations.  Qx and Qy are (nSims x N), as
+// above.
+//-----------------------------------------------------------------------------
+void EvaluateDischarge( const PointSet& S, int nSims, const double* const* a, Matrix& Qx, Matrix& Qy );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // HEAD_FIELD_H
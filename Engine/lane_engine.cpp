@@ -0,0 +1,496 @@
+//=============================================================================
+// lane_engine.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "lane_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "gaussian.h"
+#include "now.h"
+#include "oneka_model.h"
+#include "trace.h"
+#include "version.h"
+
+namespace{
+   using oneka::ENGINE_LANES;
+
+   const int N = 6;
+
+   // Smallest acceptable pivot of the Cholesky factorization of the 
+   // equilibrated (unit diagonal) normal equations.
+   const double MIN_PIVOT = 1e-12;
+
+   //--------------------------------------------------------------------------
+   // Can the site be run in a lane, or does it need the scalar Engine?
+   //--------------------------------------------------------------------------
+   bool LaneCompatible( const oneka::EngineInput& In )
+   {
+      return !In.Options.UsePrior && !In.Options.KeepDerived && !In.Options.SummarizeDerived 
+         && In.Options.Monitor == NULL && In.Options.Sink == NULL && !In.Options.Instrument
+         && !In.Options.UseSeed;
+   }
+
+   //--------------------------------------------------------------------------
+   // Order the sites by the number of piezometers, so that the sites in a
+   // group are of similar size.
+   //--------------------------------------------------------------------------
+   struct ByP
+   {
+      const std::vector<oneka::EngineInput>* In;
+      bool operator()( int i, int j ) const { return (*In)[i].P < (*In)[j].P; }
+   };
+
+   //--------------------------------------------------------------------------
+   // Cholesky factorization of a (6 x 6) symmetric matrix in each lane, 
+   // L L' = M.  Lanes with a pivot below MIN_PIVOT are flagged in Bad.
+   //--------------------------------------------------------------------------
+   void CholeskyLanes( double M[N][N][ENGINE_LANES], double L[N][N][ENGINE_LANES], bool* Bad, double MinPivot )
+   {
+      for (int j=0; j<N; ++j)
+      {
+         double d[ENGINE_LANES];
+         for (int l=0; l<ENGINE_LANES; ++l)
+            d[l] = M[j][j][l];
+
+         for (int k=0; k<j; ++k)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               d[l] -= L[j][k][l]*L[j][k][l];
+
+         for (int l=0; l<ENGINE_LANES; ++l)
+         {
+            if( !(d[l] > MinPivot) )
+            {
+               Bad[l] = true;
+               d[l] = 1;
+            }
+            L[j][j][l] = sqrt( d[l] );
+         }
+
+         for (int i=j+1; i<N; ++i)
+         {
+            double s[ENGINE_LANES];
+            for (int l=0; l<ENGINE_LANES; ++l)
+               s[l] = M[i][j][l];
+
+            for (int k=0; k<j; ++k)
+               for (int l=0; l<ENGINE_LANES; ++l)
+                  s[l] -= L[i][k][l]*L[j][k][l];
+
+            for (int l=0; l<ENGINE_LANES; ++l)
+               L[i][j][l] = s[l]/L[j][j][l];
+         }
+
+         for (int i=0; i<j; ++i)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               L[i][j][l] = 0;
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // Release whatever a site that could not be completed holds.
+   //--------------------------------------------------------------------------
+   void Fail( oneka::EngineReturn& S, int& Status )
+   {
+      if( S.a != NULL )
+      {
+         for (int k=0; k<S.nSims; ++k) delete [] S.a[k];
+         delete [] S.a;
+      }
+      S = oneka::EngineReturn();
+      Status = oneka::ENGINE_FAILED;
+   }
+
+   //--------------------------------------------------------------------------
+   // Run one group of up to ENGINE_LANES sites.  Settled[l] is set once
+   // lane l has its final status, so that if RunGroup throws the caller
+   // fails only the lanes that were still pending.
+   //--------------------------------------------------------------------------
+   void RunGroup( 
+      const std::vector<oneka::EngineInput>& Inputs, const int* site, int n,
+      std::vector<oneka::EngineReturn>& Results, std::vector<int>& Status,
+      bool* Settled )
+   {
+      // Accumulate the normal equations, M = A'A and r = A'b.
+      double M[N][N][ENGINE_LANES];
+      double r[N][ENGINE_LANES];
+      for (int i=0; i<N; ++i)
+      {
+         for (int l=0; l<ENGINE_LANES; ++l) r[i][l] = 0;
+         for (int j=0; j<N; ++j)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               M[i][j][l] = 0;
+      }
+
+      int maxP = 0;
+      for (int l=0; l<n; ++l)
+         maxP = std::max( maxP, Inputs[site[l]].P );
+
+      for (int p=0; p<maxP; ++p)
+      {
+         double g[N][ENGINE_LANES];
+         double beta[ENGINE_LANES];
+
+         for (int l=0; l<ENGINE_LANES; ++l)
+         {
+            double row[N];
+            if( l < n && p < Inputs[site[l]].P )
+            {
+               const oneka::EngineInput& In = Inputs[site[l]];
+               oneka::ObservationEquation( In.k, In.H, In.Base, In.W, In.Xw, In.Yw, In.Qw, 
+                  In.Xp[p], In.Yp[p], In.Ep[p], In.Sp[p], In.Xo, In.Yo, row, beta[l] );
+            }
+            else
+            {
+               for (int i=0; i<N; ++i) row[i] = 0;
+               beta[l] = 0;
+            }
+
+            for (int i=0; i<N; ++i) g[i][l] = row[i];
+         }
+
+         for (int i=0; i<N; ++i)
+         {
+            for (int j=i; j<N; ++j)
+               for (int l=0; l<ENGINE_LANES; ++l)
+                  M[i][j][l] += g[i][l]*g[j][l];
+
+            for (int l=0; l<ENGINE_LANES; ++l)
+               r[i][l] += g[i][l]*beta[l];
+         }
+      }
+
+      // Equilibrate: Ms = S M S, with S = diag(1/sqrt(M_ii)).
+      bool Bad[ENGINE_LANES];
+      double s[N][ENGINE_LANES];
+      for (int l=0; l<ENGINE_LANES; ++l)
+         Bad[l] = (l >= n);
+
+      for (int i=0; i<N; ++i)
+      {
+         for (int l=0; l<ENGINE_LANES; ++l)
+         {
+            if( !(M[i][i][l] > 0) ) Bad[l] = true;
+            s[i][l] = (M[i][i][l] > 0) ? 1/sqrt( M[i][i][l] ) : 1;
+         }
+      }
+
+      for (int i=0; i<N; ++i)
+         for (int j=i; j<N; ++j)
+            for (int l=0; l<ENGINE_LANES; ++l)
+            {
+               M[i][j][l] *= s[i][l]*s[j][l];
+               M[j][i][l]  = M[i][j][l];
+            }
+
+      // Factor, Ms = L L'.
+      double L[N][N][ENGINE_LANES];
+      CholeskyLanes( M, L, Bad, MIN_PIVOT );
+
+      // Mu = S inv(L') inv(L) S r.
+      double y[N][ENGINE_LANES];
+      for (int i=0; i<N; ++i)
+      {
+         for (int l=0; l<ENGINE_LANES; ++l)
+            y[i][l] = s[i][l]*r[i][l];
+         for (int k=0; k<i; ++k)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               y[i][l] -= L[i][k][l]*y[k][l];
+         for (int l=0; l<ENGINE_LANES; ++l)
+            y[i][l] /= L[i][i][l];
+      }
+
+      double Mu[N][ENGINE_LANES];
+      for (int i=N-1; i>=0; --i)
+      {
+         for (int l=0; l<ENGINE_LANES; ++l)
+            Mu[i][l] = y[i][l];
+         for (int k=i+1; k<N; ++k)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               Mu[i][l] -= L[k][i][l]*Mu[k][l];
+         for (int l=0; l<ENGINE_LANES; ++l)
+            Mu[i][l] /= L[i][i][l];
+      }
+
+      for (int i=0; i<N; ++i)
+         for (int l=0; l<ENGINE_LANES; ++l)
+            Mu[i][l] *= s[i][l];
+
+      // Cov = S inv(L)' inv(L) S.
+      double Linv[N][N][ENGINE_LANES];
+      for (int j=0; j<N; ++j)
+      {
+         for (int i=0; i<N; ++i)
+            for (int l=0; l<ENGINE_LANES; ++l)
+               Linv[i][j][l] = 0;
+
+         for (int l=0; l<ENGINE_LANES; ++l)
+            Linv[j][j][l] = 1/L[j][j][l];
+
+         for (int i=j+1; i<N; ++i)
+         {
+            double t[ENGINE_LANES];
+            for (int l=0; l<ENGINE_LANES; ++l) t[l] = 0;
+            for (int k=j; k<i; ++k)
+               for (int l=0; l<ENGINE_LANES; ++l)
+                  t[l] += L[i][k][l]*Linv[k][j][l];
+            for (int l=0; l<ENGINE_LANES; ++l)
+               Linv[i][j][l] = -t[l]/L[i][i][l];
+         }
+      }
+
+      double Cov[N][N][ENGINE_LANES];
+      for (int i=0; i<N; ++i)
+      {
+         for (int j=i; j<N; ++j)
+         {
+            double t[ENGINE_LANES];
+            for (int l=0; l<ENGINE_LANES; ++l) t[l] = 0;
+            for (int k=j; k<N; ++k)
+               for (int l=0; l<ENGINE_LANES; ++l)
+                  t[l] += Linv[k][i][l]*Linv[k][j][l];
+            for (int l=0; l<ENGINE_LANES; ++l)
+            {
+               Cov[i][j][l] = t[l]*s[i][l]*s[j][l];
+               Cov[j][i][l] = Cov[i][j][l];
+            }
+         }
+      }
+
+      // Factor the covariance for the sampling, Cov = C C'.
+      double C[N][N][ENGINE_LANES];
+      CholeskyLanes( Cov, C, Bad, 0.0 );
+
+      // Fill in the results.
+      int maxSims = 0;
+      std::vector<oneka::RandomStream> R( ENGINE_LANES );
+
+      for (int l=0; l<n; ++l)
+      {
+         if( Bad[l] )
+         {
+            Status[site[l]] = oneka::ENGINE_SINGULAR;
+            Settled[l] = true;
+            continue;
+         }
+
+         const oneka::EngineInput& In = Inputs[site[l]];
+         oneka::EngineReturn& S = Results[site[l]];
+
+         S.Version = oneka::EngineVersion();
+         S.RunTime = oneka::Now();
+         S.Xo = In.Xo;
+         S.Yo = In.Yo;
+         S.Seed = In.Seed;
+         S.Stream = In.Stream;
+
+         for (int i=0; i<N; ++i)
+         {
+            S.Mu[i] = Mu[i][l];
+            for (int j=0; j<N; ++j)
+               S.Cov[i][j] = Cov[i][j][l];
+         }
+
+         S.nSims = In.nSims;
+         try
+         {
+            S.a = new double*[In.nSims]();
+            for (int k=0; k<In.nSims; ++k)
+               S.a[k] = new double[N];
+         }
+         catch( std::bad_alloc& )
+         {
+            Fail( S, Status[site[l]] );
+            Bad[l] = true;
+            Settled[l] = true;
+            continue;
+         }
+
+         R[l] = oneka::RandomStream( In.Seed, In.Stream );
+         maxSims = std::max( maxSims, In.nSims );
+      }
+
+      // Generate the realizations, a = Mu + C z, one realization per lane
+      // at a time.
+      for (int k=0; k<maxSims; ++k)
+      {
+         double z[N][ENGINE_LANES];
+         bool active[ENGINE_LANES];
+
+         for (int l=0; l<ENGINE_LANES; ++l)
+         {
+            active[l] = (l < n) && !Bad[l] && (k < Inputs[site[l]].nSims);
+            for (int j=0; j<N; ++j)
+               z[j][l] = active[l] ? R[l].Gaussian() : 0;
+         }
+
+         double x[N][ENGINE_LANES];
+         for (int i=0; i<N; ++i)
+         {
+            for (int l=0; l<ENGINE_LANES; ++l)
+               x[i][l] = Mu[i][l];
+            for (int j=0; j<=i; ++j)
+               for (int l=0; l<ENGINE_LANES; ++l)
+                  x[i][l] += C[i][j][l]*z[j][l];
+         }
+
+         for (int l=0; l<ENGINE_LANES; ++l)
+            if( active[l] )
+               for (int i=0; i<N; ++i)
+                  Results[site[l]].a[k][i] = x[i][l];
+      }
+
+      for (int l=0; l<n; ++l)
+         Settled[l] = true;
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// EngineLanes
+//
+//    Run Engine for each of the sites in Inputs, ENGINE_LANES sites at a 
+//    time.
+//
+// Arguments:
+//    Inputs   the sites.
+//    Results  the Engine results, in the same order as Inputs, on exit.
+//    Status   an EngineStatus for each site, on exit.
+//    nThreads number of threads; if <= 0, all available threads.
+//
+// Notes:
+// o  The coefficients are computed from the normal equations, equilibrated
+//    to unit diagonal before the Cholesky factorization, rather than by 
+//    the Gram-Schmidt least squares solve of Engine.  For the small, well
+//    posed problems this mode is intended for, the difference is at the
+//    level of rounding.
+//
+// o  The sites are grouped by the number of piezometers to limit masking.
+//    The groups are distributed over the threads.
+//
+// o  Sites using a prior, derived quantities, a monitor, or instrumentation
+//    are run by the scalar Engine.  Collapsing repeated readings does not 
+//    change the fit, so it is not needed here.
+//-----------------------------------------------------------------------------
+void EngineLanes( 
+   const std::vector<EngineInput>& Inputs, 
+   std::vector<EngineReturn>& Results, 
+   std::vector<int>& Status,
+   int nThreads )
+{
+   const int n = int( Inputs.size() );
+
+   Results.assign( n, EngineReturn() );
+   Status.assign( n, ENGINE_OK );
+
+   // Split the sites, and order the lane sites by size.
+   std::vector<int> lane, scalar;
+   for (int i=0; i<n; ++i)
+      (LaneCompatible( Inputs[i] ) ? lane : scalar).push_back( i );
+
+   ByP order;
+   order.In = &Inputs;
+   std::stable_sort( lane.begin(), lane.end(), order );
+
+   const int nGroups = (int(lane.size()) + ENGINE_LANES - 1)/ENGINE_LANES;
+   const int nScalar = int( scalar.size() );
+
+   #ifdef _OPENMP
+      if (nThreads <= 0) nThreads = omp_get_max_threads();
+   #else
+      nThreads = 1;
+   #endif
+
+   #pragma omp parallel num_threads(nThreads)
+   {
+      #pragma omp for schedule(dynamic,1) nowait
+      for (int g=0; g<nGroups; ++g)
+      {
+         ONEKA_TRACE_SCOPE( "EngineLanes group" );
+         int first = g*ENGINE_LANES;
+         int count = std::min( ENGINE_LANES, int(lane.size()) - first );
+         bool Settled[ENGINE_LANES] = { false };
+         try
+         {
+            RunGroup( Inputs, &lane[first], count, Results, Status, Settled );
+         }
+         catch( std::exception& )
+         {
+            for (int l=0; l<count; ++l)
+               if( !Settled[l] )
+                  Fail( Results[lane[first+l]], Status[lane[first+l]] );
+         }
+      }
+
+      EngineWorkspace Work;
+
+      #pragma omp for schedule(dynamic,1)
+      for (int i=0; i<nScalar; ++i)
+      {
+         ONEKA_TRACE_SCOPE( "EngineLanes site" );
+         try
+         {
+            Results[scalar[i]] = Engine( Inputs[scalar[i]], &Work );
+         }
+         catch( Exception_SingularSystem& )
+         {
+            Status[scalar[i]] = ENGINE_SINGULAR;
+         }
+         catch( Exception_SinkFailure& )
+         {
+            Status[scalar[i]] = ENGINE_SINK_FAILED;
+         }
+         catch( Exception_Cancelled& )
+         {
+            Status[scalar[i]] = ENGINE_CANCELLED;
+         }
+         catch( std::exception& )
+         {
+            Status[scalar[i]] = ENGINE_FAILED;
+         }
+      }
+   }
+}
+
+
+} // namespace oneka
@@ -0,0 +1,72 @@
+//=============================================================================
+// lane_engine.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef LANE_ENGINE_H
+#define LANE_ENGINE_H
+
+#include <vector>
+
+#include "engine_batch.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// A lane-batched counterpart of EngineBatch for many small sites.
+//
+// Sites are packed ENGINE_LANES at a time into structure-of-arrays lanes:
+// every arithmetic step -- accumulating the normal equations, the (6 x 6)
+// Cholesky factorizations, the inversion, and the transformation of the 
+// Gaussian deviates into realizations -- is an inner loop over the lanes, 
+// which the compiler maps onto SIMD registers.  Sites with fewer 
+// piezometers or realizations than the others in their group are masked.
+//
+// The results agree with Engine( Input ) to rounding, and are returned in
+// input order.
+//-----------------------------------------------------------------------------
+const int ENGINE_LANES = 4;
+
+void EngineLanes( 
+   const std::vector<EngineInput>& Inputs, 
+   std::vector<EngineReturn>& Results, 
+   std::vector<int>& Status,
+   int nThreads = 0 );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // LANE_ENGINE_H
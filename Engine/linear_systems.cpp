@@ -48,6 +48,7 @@
 #include <cmath>
 
 #include "sum_product-inl.h"
+#include "trace.h"
 
 namespace{
    double MIN_DIVISOR = 1e-12;
@@ -81,6 +82,11 @@ namespace oneka{
 //    triangular portion needs to be filled.
 // 
 // o  The routine CholeskySolve is this routine's complementary pair.
+//
+// o  A pivot is rejected if it is not larger than MIN_DIVISOR times the
+//    corresponding diagonal element of A, so the test does not depend upon
+//    the scale of A.  (The covariance of the Oneka coefficients shrinks 
+//    in proportion to the number of piezometers.)
 //                                                                           
 // References:
 //                                                                           
@@ -89,6 +95,8 @@ namespace oneka{
 //=============================================================================
 bool CholeskyDecomposition( const Matrix& A, Matrix& L )
 {
+   ONEKA_TRACE_SCOPE( "CholeskyDecomposition" );
+
    assert( A.nRows() == A.nCols() );
 
    // Define local constants.
@@ -104,7 +112,7 @@ bool CholeskyDecomposition( const Matrix& A, Matrix& L )
             L(k,j) -= SumProduct(j, L.Base(j,0), L.Base(k,0));
       }
 
-      if (L(j,j) < MIN_DIVISOR) return false;
+      if (!(L(j,j) > MIN_DIVISOR*A(j,j))) return false;
       L(j,j) = sqrt(L(j,j));
 
       for (int k=j+1; k<N; ++k)
@@ -146,6 +154,8 @@ bool CholeskyDecomposition( const Matrix& A, Matrix& L )
 //=============================================================================
 bool RSPDInv( const Matrix& A, Matrix& Ainv )
 {
+   ONEKA_TRACE_SCOPE( "RSPDInv" );
+
    assert( A.nRows() > 0 );
    assert( A.nRows() == A.nCols() );
    const int N = A.nRows();
@@ -246,6 +256,8 @@ bool RSPDInv( const Matrix& A, Matrix& Ainv )
 //=============================================================================
 bool LeastSquaresSolve( const Matrix& A, const Matrix& B, Matrix& X )
 {
+   ONEKA_TRACE_SCOPE( "LeastSquaresSolve" );
+
    assert(A.nRows() == B.nRows());
 
    // Setup the necessary dimension constants.
@@ -295,14 +307,14 @@ bool LeastSquaresSolve( const Matrix& A, const Matrix& B, Matrix& X )
 
    // Compute X = R~Z using back-substitution: e.g. Golub and Van Loan (1996)
    // Algorithm 3.1.2. Recall that the augmenting Matrix "z" is stored in "X".
-   if( abs(R(N-1,N-1)) < MIN_DIVISOR ) return false;
+   if( fabs(R(N-1,N-1)) < MIN_DIVISOR ) return false;
 
    for (int p=0; p<P; ++p)
       X(N-1,p) /= R(N-1,N-1);
 
    for (int i=N-2; i>=0; --i)
    {
-      if (abs(R(i,i)) < MIN_DIVISOR ) return false;
+      if (fabs(R(i,i)) < MIN_DIVISOR ) return false;
 
       for (int p=0; p<P; ++p)
          X(i,p) = (X(i,p) - SumProduct(N-i-1, R.Base(i,i+1), X.Base(i+1,p), X.nCols())) / R(i,i);
@@ -331,6 +343,8 @@ bool LeastSquaresSolve( const Matrix& A, const Matrix& B, Matrix& X )
 //=============================================================================
 void AffineTransformation( const Matrix& A, const Matrix& B, const Matrix& C, Matrix& D )
 {
+   ONEKA_TRACE_SCOPE( "AffineTransformation" );
+
    assert( A.nCols() == B.nRows() );
    assert( B.nRows() == B.nCols() );
    assert( C.nRows() == 1 );
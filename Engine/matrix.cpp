@@ -40,16 +40,48 @@
 //=============================================================================
 #include "matrix.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <vector>
 
 #include "sum_product-inl.h"
+#include "trace.h"
 
 namespace oneka{
 
+namespace{
+
+   // The Matrix storage allocations made by this thread.
+   ONEKA_THREAD_LOCAL long g_Allocations = 0;
+   ONEKA_THREAD_LOCAL long long g_AllocatedBytes = 0;
+
+   double* Allocate( int n )
+   {
+      ++g_Allocations;
+      g_AllocatedBytes += static_cast<long long>( n )*sizeof(double);
+      return new double[ n ];
+   }
+}
+
+//-----------------------------------------------------------------------------
+// MatrixAllocations
+//
+//    The number of Matrix storage allocations, and their total size in 
+//    bytes, made by the calling thread since it started.  The difference
+//    of two calls counts the allocations of the code between them.
+//-----------------------------------------------------------------------------
+void MatrixAllocations( long& Count, long long& Bytes )
+{
+   Count = g_Allocations;
+   Bytes = g_AllocatedBytes;
+}
+
+
 //=============================================================================
 // Matrix
 //=============================================================================
@@ -76,7 +108,7 @@ Matrix::Matrix( const Matrix& A )
    {
       m_nRows = A.nRows();
       m_nCols = A.nCols();
-      m_Data  = new double[ m_nRows*m_nCols ];
+      m_Data  = Allocate( m_nRows*m_nCols );
       memcpy( m_Data, A.Base(), sizeof(double)*m_nRows*m_nCols );
    }
 }
@@ -93,7 +125,7 @@ Matrix::Matrix( int nrows, int ncols )
 
    m_nRows = nrows;
    m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
+   m_Data  = Allocate( m_nRows*m_nCols );
    memset( m_Data, 0, sizeof(double)*m_nRows*m_nCols );
 }
 
@@ -109,7 +141,7 @@ Matrix::Matrix( int nrows, int ncols, double a )
 
    m_nRows = nrows;
    m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
+   m_Data  = Allocate( m_nRows*m_nCols );
 
    for (int i=0; i<nrows; ++i)
       for (int j=0; j<ncols; ++j)
@@ -128,7 +160,7 @@ Matrix::Matrix( int nrows, int ncols, const double* data )
 
    m_nRows = nrows;
    m_nCols = ncols;
-   m_Data  = new double[ m_nRows*m_nCols ];
+   m_Data  = Allocate( m_nRows*m_nCols );
    memcpy( m_Data, data, sizeof(double)*m_nRows*m_nCols );
 }
 
@@ -194,7 +226,7 @@ Matrix::Matrix( const std::string& str )
       if ( static_cast<int>(i->size()) > m_nCols) m_nCols = i->size();
    }
 
-   m_Data  = new double[ m_nRows*m_nCols ];
+   m_Data  = Allocate( m_nRows*m_nCols );
    memset( m_Data, 0, sizeof(double)*m_nRows*m_nCols );
 
    for (std::vector< std::vector< double > >::const_iterator i = rows.begin(); i != rows.end(); ++i)   
@@ -236,7 +268,7 @@ void Matrix::Resize( int nrows, int ncols )
       {
          m_nRows = nrows;
          m_nCols = ncols;
-         m_Data  = new double[ m_nRows*m_nCols ];
+         m_Data  = Allocate( m_nRows*m_nCols );
       }
       else
       {
@@ -383,6 +415,140 @@ std::ostream& operator <<( std::ostream& ostr, const Matrix& A )
 }
 
 
+//=============================================================================
+// Binary files.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// MatrixFileHeader
+//-----------------------------------------------------------------------------
+MatrixFileHeader::MatrixFileHeader()
+:  Version( MATRIX_FILE_VERSION ),
+   Type( MATRIX_FLOAT64 ),
+   nRows( 0 ),
+   nCols( 0 ),
+   Offset( sizeof(MatrixFileHeader) ),
+   Reserved( 0 )
+{
+   memcpy( Magic, MATRIX_FILE_MAGIC, sizeof(Magic) );
+}
+
+//-----------------------------------------------------------------------------
+std::size_t MatrixFileElementSize( unsigned int Type )
+{
+   switch( Type )
+   {
+   case MATRIX_FLOAT64: return sizeof(double);
+   case MATRIX_FLOAT32: return sizeof(float);
+   default:             return 0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// SaveMatrix
+//
+//    Write A to the binary matrix file Name, as doubles or floats.
+//-----------------------------------------------------------------------------
+bool SaveMatrix( const std::string& Name, const Matrix& A, unsigned int Type )
+{
+   if( MatrixFileElementSize( Type ) == 0 ) return false;
+
+   std::FILE* fp = std::fopen( Name.c_str(), "wb" );
+   if( fp == NULL ) return false;
+
+   MatrixFileHeader H;
+   H.Type  = Type;
+   H.nRows = A.nRows();
+   H.nCols = A.nCols();
+
+   bool ok = std::fwrite( &H, sizeof(H), 1, fp ) == 1;
+
+   const std::size_t n = std::size_t( A.nRows() )*A.nCols();
+   if( ok && n > 0 )
+   {
+      if( Type == MATRIX_FLOAT64 )
+         ok = std::fwrite( A.Base(), sizeof(double), n, fp ) == n;
+      else
+      {
+         std::vector<float> f( A.Base(), A.Base() + n );
+         ok = std::fwrite( &f[0], sizeof(float), n, fp ) == n;
+      }
+   }
+
+   ok &= ( std::fclose( fp ) == 0 );
+   if( !ok ) std::remove( Name.c_str() );
+   return ok;
+}
+
+//-----------------------------------------------------------------------------
+// LoadMatrixHeader
+//
+//    Read and check the header of the binary matrix file Name.
+//-----------------------------------------------------------------------------
+bool LoadMatrixHeader( const std::string& Name, MatrixFileHeader& H )
+{
+   std::FILE* fp = std::fopen( Name.c_str(), "rb" );
+   if( fp == NULL ) return false;
+
+   bool ok = std::fread( &H, sizeof(H), 1, fp ) == 1;
+   std::fclose( fp );
+
+   return ok 
+      && memcmp( H.Magic, MATRIX_FILE_MAGIC, sizeof(H.Magic) ) == 0
+      && H.Version == MATRIX_FILE_VERSION
+      && MatrixFileElementSize( H.Type ) > 0
+      && H.nRows >= 0 && H.nRows <= 0x7fffffffLL
+      && H.nCols >= 0 && H.nCols <= 0x7fffffffLL
+      && H.nRows*H.nCols <= 0x7fffffffLL
+      && H.Offset >= static_cast<long long>( sizeof(H) );
+}
+
+//-----------------------------------------------------------------------------
+// LoadMatrix
+//
+//    Read the binary matrix file Name into A.  Returns false, and leaves A
+//    empty, if the file is not a complete matrix file.
+//-----------------------------------------------------------------------------
+bool LoadMatrix( const std::string& Name, Matrix& A )
+{
+   A.Resize( 0, 0 );
+
+   MatrixFileHeader H;
+   if( !LoadMatrixHeader( Name, H ) ) return false;
+
+   std::FILE* fp = std::fopen( Name.c_str(), "rb" );
+   if( fp == NULL ) return false;
+
+   bool ok = std::fseek( fp, long( H.Offset ), SEEK_SET ) == 0;
+
+   const std::size_t n = std::size_t( H.nRows*H.nCols );
+   if( ok && n > 0 )
+   {
+      A.Resize( int( H.nRows ), int( H.nCols ) );
+
+      if( H.Type == MATRIX_FLOAT64 )
+         ok = std::fread( A.Base(), sizeof(double), n, fp ) == n;
+      else
+      {
+         // Widen a block at a time.
+         std::vector<float> f( std::min( n, std::size_t( 1 << 16 ) ) );
+         double* p = A.Base();
+         for( std::size_t done = 0; ok && done < n; )
+         {
+            std::size_t m = std::min( f.size(), n - done );
+            ok = std::fread( &f[0], sizeof(float), m, fp ) == m;
+            for( std::size_t i = 0; i < m; ++i ) *p++ = f[i];
+            done += m;
+         }
+      }
+   }
+
+   std::fclose( fp );
+   if( !ok ) A.Resize( 0, 0 );
+   return ok;
+}
+
+
 //=============================================================================
 // Matrix measures and norms.
 //=============================================================================
@@ -732,6 +898,8 @@ void Subtract_MM( const Matrix& A, const Matrix& B, Matrix& C )
 //-----------------------------------------------------------------------------
 void Multiply_MM( const Matrix& A, const Matrix& B, Matrix& C )
 {
+   ONEKA_TRACE_SCOPE( "Multiply_MM" );
+
    // Check the arguments.
    assert( A.nRows() > 0 && A.nCols() > 0 );
    assert( B.nRows() > 0 && B.nCols() > 0 );
@@ -757,6 +925,8 @@ void Multiply_MM( const Matrix& A, const Matrix& B, Matrix& C )
 //-----------------------------------------------------------------------------
 void Multiply_MtM( const Matrix& A, const Matrix& B, Matrix& C )
 {
+   ONEKA_TRACE_SCOPE( "Multiply_MtM" );
+
    // Check the arguments.
    assert( A.nRows() > 0 && A.nCols() > 0 );
    assert( B.nRows() > 0 && B.nCols() > 0 );
@@ -782,6 +952,8 @@ void Multiply_MtM( const Matrix& A, const Matrix& B, Matrix& C )
 //-----------------------------------------------------------------------------
 void Multiply_MMt( const Matrix& A, const Matrix& B, Matrix& C )
 {
+   ONEKA_TRACE_SCOPE( "Multiply_MMt" );
+
    // Check the arguments.
    assert( A.nRows() > 0 && A.nCols() > 0 );
    assert( B.nRows() > 0 && B.nCols() > 0 );
@@ -807,6 +979,8 @@ void Multiply_MMt( const Matrix& A, const Matrix& B, Matrix& C )
 //-----------------------------------------------------------------------------
 void Multiply_MtMt( const Matrix& A, const Matrix& B, Matrix& C )
 {
+   ONEKA_TRACE_SCOPE( "Multiply_MtMt" );
+
    // Check the arguments.
    assert( A.nRows() > 0 && A.nCols() > 0 );
    assert( B.nRows() > 0 && B.nCols() > 0 );
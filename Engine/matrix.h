@@ -39,7 +39,9 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <cstddef>
 #include <iostream>
+#include <string>
 
 namespace oneka{
 
@@ -91,6 +93,49 @@ private:
 std::ostream& operator << ( std::ostream& ostr, const Matrix& A );
 
 
+//=============================================================================
+// Binary files
+//
+// A matrix file is a MatrixFileHeader, followed at byte Offset by the rows
+// of the matrix, in native byte order.  Any bytes between the header and 
+// Offset are free for metadata (see realization_file.h).  A FLOAT32 file
+// is widened to double when it is loaded.
+//=============================================================================
+enum MatrixFileType
+{
+   MATRIX_FLOAT64 = 1,
+   MATRIX_FLOAT32 = 2
+};
+
+struct MatrixFileHeader
+{
+   MatrixFileHeader();
+
+   char Magic[8];          // MATRIX_FILE_MAGIC.
+   unsigned int Version;   // MATRIX_FILE_VERSION.
+   unsigned int Type;      // a MatrixFileType.
+   long long nRows;
+   long long nCols;
+   long long Offset;       // byte offset of the data from the start of the file.
+   long long Reserved;
+};
+
+const char MATRIX_FILE_MAGIC[8] = { 'O','N','E','K','A','M','T','X' };
+const unsigned int MATRIX_FILE_VERSION = 1;
+
+std::size_t MatrixFileElementSize( unsigned int Type );   // 0 for an unknown type.
+
+bool SaveMatrix( const std::string& Name, const Matrix& A, unsigned int Type = MATRIX_FLOAT64 );
+bool LoadMatrix( const std::string& Name, Matrix& A );
+bool LoadMatrixHeader( const std::string& Name, MatrixFileHeader& H );
+
+
+//=============================================================================
+// Allocation counters, for the calling thread.
+//=============================================================================
+void MatrixAllocations( long& Count, long long& Bytes );
+
+
 //=============================================================================
 // Matrix sums, measures and norms.
 //=============================================================================
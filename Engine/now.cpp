@@ -41,12 +41,22 @@
 #include <ctime>
 #include <string>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
 namespace oneka{
 
 //-----------------------------------------------------------------------------
 // Now
 //
 //    Return the current date and time as a string.
+//
+// Notes:
+// o  localtime and asctime share static buffers, so concurrent calls are
+//    serialized.
 //-----------------------------------------------------------------------------
 std::string Now()
 {
@@ -54,14 +64,42 @@ std::string Now()
 
    time_t rawtime;
    struct tm *timeinfo;
+   std::string str;
 
    time( &rawtime );
-   timeinfo = localtime( &rawtime );
 
-   std::string str( asctime(timeinfo) );
+   #pragma omp critical( oneka_now )
+   {
+      timeinfo = localtime( &rawtime );
+      str = asctime(timeinfo);
+   }
+
    str = str.substr(0, str.find('\n'));
 
    return str;
 }
 
-} // namespace oneka
\ No newline at end of file
+//-----------------------------------------------------------------------------
+// WallClock
+//
+//    Return the time in seconds on a monotonic clock, for timing intervals.
+//
+// Notes:
+// o  QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere: the
+//    same clocks that back std::chrono::steady_clock.
+//-----------------------------------------------------------------------------
+double WallClock()
+{
+#ifdef _WIN32
+   LARGE_INTEGER count, frequency;
+   QueryPerformanceCounter( &count );
+   QueryPerformanceFrequency( &frequency );
+   return double( count.QuadPart ) / double( frequency.QuadPart );
+#else
+   timespec t;
+   clock_gettime( CLOCK_MONOTONIC, &t );
+   return double( t.tv_sec ) + 1e-9*double( t.tv_nsec );
+#endif
+}
+
+} // namespace oneka
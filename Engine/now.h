@@ -47,6 +47,9 @@ namespace oneka{
 //-----------------------------------------------------------------------------
 std::string Now();
 
+// Seconds on a monotonic high-resolution clock, from an arbitrary origin.
+double WallClock();
+
 
 } // namespace onkea
 
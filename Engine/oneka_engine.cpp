@@ -37,16 +37,392 @@
 //=============================================================================
 #include "oneka_engine.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 
 #include "gaussian.h"
 #include "linear_systems.h"
 #include "matrix.h"
 #include "now.h"
+#include "oneka_model.h"
+#include "trace.h"
 #include "version.h"
 
 namespace oneka{
 
+//-----------------------------------------------------------------------------
+// EngineInstrumentation
+//-----------------------------------------------------------------------------
+EngineInstrumentation::EngineInstrumentation()
+:  Valid( false ),
+   TotalSeconds( 0 ),
+   Allocations( 0 ),
+   AllocatedBytes( 0 ),
+   W( 0 ),
+   P( 0 ),
+   nRows( 0 ),
+   nSims( 0 )
+{
+   for (int i=0; i<N_PHASES; ++i)
+      Seconds[i] = 0;
+}
+
+//-----------------------------------------------------------------------------
+// EngineOptions
+//
+//    The defaults reproduce the original results: no derived quantities,
+//    and no prior.  Repeated readings are collapsed, which does not change
+//    the fit.
+//-----------------------------------------------------------------------------
+EngineOptions::EngineOptions()
+:  KeepDerived( false ),
+   SummarizeDerived( false ),
+   UsePrior( false ),
+   CollapseReadings( false ),
+   UseSeed( false ),
+   Seed( 0 ),
+   Stream( 0 ),
+   Instrument( false ),
+   Monitor( NULL ),
+   Sink( NULL )
+{
+   Probabilities.push_back( 0.05 );
+   Probabilities.push_back( 0.50 );
+   Probabilities.push_back( 0.95 );
+
+   for (int i=0; i<6; ++i)
+   {
+      PriorMu[i] = 0;
+      for (int j=0; j<6; ++j)
+         PriorCov[i][j] = 0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// EngineReturn
+//
+//    An empty result: no realizations.
+//-----------------------------------------------------------------------------
+EngineReturn::EngineReturn()
+:  Xo( 0 ),
+   Yo( 0 ),
+   nSims( 0 ),
+   a( NULL ),
+   Seed( 0 ),
+   Stream( 0 )
+{
+   for (int i=0; i<6; ++i)
+   {
+      Mu[i] = 0;
+      for (int j=0; j<6; ++j)
+         Cov[i][j] = 0;
+   }
+}
+
+
+namespace{
+
+   // The number of realizations generated at a time.
+   const int CHUNK_SIMS = 4096;
+
+   //--------------------------------------------------------------------------
+   // A 64-bit seed from the global generator.  rand() may return as few as
+   // 15 bits, so 16 bits are taken from each of four calls.
+   //--------------------------------------------------------------------------
+   unsigned long long DrawSeed()
+   {
+      unsigned long long seed = 0;
+      for (int i=0; i<4; ++i)
+         seed = (seed << 16) ^ static_cast<unsigned long long>( rand() & 0xffff );
+      return seed;
+   }
+
+   //--------------------------------------------------------------------------
+   // Charges the time since the previous lap to a phase, if instrumented,
+   // and records it as a trace event, if tracing.
+   //--------------------------------------------------------------------------
+   const char* const PHASE_NAMES[N_PHASES] = 
+   {
+      "Engine assembly",
+      "Engine normal equations",
+      "Engine inverse",
+      "Engine solve",
+      "Engine factor",
+      "Engine random",
+      "Engine copy"
+   };
+
+   class PhaseClock
+   {
+   public:
+      explicit PhaseClock( bool on ) : m_On( on ), m_Start( 0 ), m_Last( 0 )
+      {
+      #ifdef ONEKA_TRACING
+         m_On = true;
+      #endif
+         for (int i=0; i<N_PHASES; ++i) m_Seconds[i] = 0;
+         if (m_On) m_Start = m_Last = WallClock();
+      }
+
+      void Lap( EnginePhase phase )
+      {
+         if (!m_On) return;
+         double t = WallClock();
+         m_Seconds[phase] += t - m_Last;
+         ONEKA_TRACE_EVENT( PHASE_NAMES[phase], m_Last, t );
+         m_Last = t;
+      }
+
+      void Report( EngineInstrumentation& I ) const
+      {
+         for (int i=0; i<N_PHASES; ++i) I.Seconds[i] = m_Seconds[i];
+         I.TotalSeconds = m_Last - m_Start;
+      }
+
+   private:
+      bool m_On;
+      double m_Start;
+      double m_Last;
+      double m_Seconds[N_PHASES];
+   };
+
+   //--------------------------------------------------------------------------
+   // EngineCore
+   //
+   //    The body of Engine.  The realizations are drawn from Stream.
+   //
+   //    The realizations are generated CHUNK_SIMS at a time, so the scratch
+   //    space does not grow with nSims, and a monitor sees regular progress.
+   //--------------------------------------------------------------------------
+   EngineReturn EngineCore( 
+      double k, double H, double Base,
+      int W, double* Xw, double* Yw, double* Qw, 
+      int P, double* Xp, double* Yp, double* Ep, double* Sp, 
+      double Xo, double Yo,
+      int nSims,
+      const EngineOptions& Options,
+      RandomStream& Stream,
+      EngineWorkspace& Work )
+   {
+      ONEKA_TRACE_SCOPE( "Engine" );
+
+      Matrix& A   = Work.A;
+      Matrix& b   = Work.b;
+      Matrix& Mu  = Work.Mu;
+      Matrix& Mut = Work.Mut;
+      Matrix& Cov = Work.Cov;
+      Matrix& L   = Work.L;
+      Matrix& U   = Work.U;
+      Matrix& X   = Work.X;
+
+      EngineMonitor* Monitor = Options.Monitor;
+
+      PhaseClock Clock( Options.Instrument );
+      long allocations = 0;
+      long long bytes = 0;
+      if( Options.Instrument )
+         MatrixAllocations( allocations, bytes );
+
+      // Group repeated readings.
+      std::vector<int>& Group = Work.Group;
+      int nRows = Options.CollapseReadings ? CollapseObservations( P, Xp, Yp, Group ) : P;
+
+      // Initialize.
+      const int nPrior = Options.UsePrior ? 6 : 0;
+      A.Resize(nRows+nPrior,6);
+      b.Resize(nRows+nPrior,1);
+
+      // Setup the system of Oneka equations.
+      if( nRows < P )
+      {
+         CollapsedEquations( k, H, Base, W, Xw, Yw, Qw, 
+            P, Xp, Yp, Ep, Sp, Xo, Yo, nRows, Group, A.Base(), b.Base() );
+      }
+      else
+      {
+         for( int p = 0; p < P; ++p)
+         {
+            ObservationEquation( k, H, Base, W, Xw, Yw, Qw, 
+               Xp[p], Yp[p], Ep[p], Sp[p], Xo, Yo, A.Base(p,0), b(p,0) );
+         }
+      }
+
+      // Stack the prior equations.
+      if( Options.UsePrior )
+      {
+         double rows[6][6];
+         double rhs[6];
+         if( !PriorEquations( Options.PriorMu, Options.PriorCov, rows, rhs ) ) throw oneka::Exception_SingularSystem();
+
+         for (int i=0; i<6; ++i)
+         {
+            for (int j=0; j<6; ++j)
+               A(nRows+i,j) = rows[i][j];
+            b(nRows+i,0) = rhs[i];
+         }
+      }
+
+      Clock.Lap( PHASE_ASSEMBLY );
+      if( Monitor != NULL && Monitor->Cancelled() ) throw oneka::Exception_Cancelled();
+
+      // Compute the statistics.
+      Cov.Resize(6,6);
+
+      Multiply_MtM( A, A, Cov );
+      Clock.Lap( PHASE_NORMAL );
+
+      if( !RSPDInv( Cov, Cov ) ) throw oneka::Exception_SingularSystem();
+      Clock.Lap( PHASE_INVERSE );
+
+      // Compute the least squares fit.
+      if( !LeastSquaresSolve( A, b, Mu ) ) throw oneka::Exception_SingularSystem();
+      Clock.Lap( PHASE_SOLVE );
+
+      if( Monitor != NULL && Monitor->Cancelled() ) throw oneka::Exception_Cancelled();
+
+      // Factor the covariance for the realizations, X = Z U + Mu'.
+      Transpose(Mu,Mut);                           // The RNG requires a row not a column.
+      if( !CholeskyDecomposition( Cov, L ) ) throw oneka::Exception_SingularSystem();
+      Transpose(L,U);
+      Clock.Lap( PHASE_FACTOR );
+
+      // Fill the return structure.
+      EngineReturn S;
+
+      S.Version = EngineVersion();
+      S.RunTime = Now();
+
+      S.Xo = Xo;
+      S.Yo = Yo;
+
+      S.Seed = Stream.Seed();
+      S.Stream = Stream.Stream();
+
+      for (int i=0; i<6; ++i)
+      {
+         S.Mu[i] = Mu(i,0);
+         for (int j=0; j<6; ++j)
+         {
+            S.Cov[i][j] = Cov(i,j);
+         }
+      }
+
+      S.nSims = nSims;
+
+      if( Options.KeepDerived )
+         S.Derived.Resize( nSims, N_DERIVED );
+
+      if( Options.SummarizeDerived )
+         S.DerivedStats = EnsembleStatistics( N_DERIVED, 0, NULL,
+            int(Options.Probabilities.size()), 
+            Options.Probabilities.empty() ? NULL : &Options.Probabilities[0] );
+
+      // Generate the realizations, a chunk at a time.  They are kept in 
+      // "a", or handed to the sink.
+      RealizationSink* Sink = Options.Sink;
+      double d[N_DERIVED];
+
+      // The rows of "a" are NULL until filled, so a failure part way 
+      // through -- cancellation, the sink, or memory -- can free them.
+      if( Sink == NULL )
+         S.a = new double*[nSims]();
+      else if( !Sink->Begin( S ) )
+         throw oneka::Exception_SinkFailure();
+      Clock.Lap( PHASE_COPY );
+
+      try
+      {
+         for (int first=0; first<nSims; first+=CHUNK_SIMS)
+         {
+            int n = std::min( CHUNK_SIMS, nSims-first );
+
+            GaussianRNG( Stream, n, 6, X );
+            AffineTransformation( X, U, Mut, X );
+            Clock.Lap( PHASE_RANDOM );
+
+            if( Sink != NULL && !Sink->Write( first, n, X.Base(0,0) ) )
+               throw oneka::Exception_SinkFailure();
+
+            for (int i=first; i<first+n; ++i)
+            {
+               const double* x = X.Base(i-first,0);
+
+               if( Sink == NULL )
+               {
+                  S.a[i] = new double[6];
+
+                  for (int j=0; j<6; ++j)
+                  {
+                     S.a[i][j] = x[j];
+                  }
+               }
+
+               if( Options.KeepDerived || Options.SummarizeDerived )
+               {
+                  DerivedQuantities( x, Xo, Yo, d );
+
+                  if( Options.KeepDerived )
+                     for (int j=0; j<N_DERIVED; ++j) S.Derived(i,j) = d[j];
+
+                  if( Options.SummarizeDerived )
+                     S.DerivedStats.Add( d );
+               }
+            }
+            Clock.Lap( PHASE_COPY );
+
+            if( Monitor != NULL )
+            {
+               Monitor->Progress( first+n, nSims );
+
+               if( first+n < nSims && Monitor->Cancelled() )
+                  throw oneka::Exception_Cancelled();
+            }
+         }
+
+         if( Sink != NULL && !Sink->End() )
+            throw oneka::Exception_SinkFailure();
+      }
+      catch( ... )
+      {
+         if( S.a != NULL )
+         {
+            for (int i=0; i<nSims; ++i) delete [] S.a[i];
+            delete [] S.a;
+         }
+         throw;
+      }
+
+      if( Options.Instrument )
+      {
+         EngineInstrumentation& I = S.Instrumentation;
+         Clock.Report( I );
+
+         long allocations_after;
+         long long bytes_after;
+         MatrixAllocations( allocations_after, bytes_after );
+
+         // The Matrix storage, plus the realizations: "a" and its rows.
+         I.Allocations = allocations_after - allocations;
+         I.AllocatedBytes = bytes_after - bytes;
+         if( Sink == NULL )
+         {
+            I.Allocations += 1 + nSims;
+            I.AllocatedBytes += static_cast<long long>( nSims )*( sizeof(double*) + 6*sizeof(double) );
+         }
+
+         I.Valid = true;
+         I.W = W;
+         I.P = P;
+         I.nRows = nRows;
+         I.nSims = nSims;
+      }
+
+      return S;
+   }
+}
+
+
 //-----------------------------------------------------------------------------
 // Engine
 //
@@ -71,14 +447,23 @@ namespace oneka{
 //
 //    nSims number of realizations to generate [#].
 //
+//    Options  see EngineOptions.
+//
+//    Stream   the random number stream for the realizations (optional).
+//    Work     scratch space (optional).
+//
 // Returns:
 //
 //    struct EngineReturn
 //    {
+//       double Xo, Yo;       // model origin.
 //       double Mu[6];        // conditional mean vector of the coefficients.
 //       double Cov[6][6];    // conditional covariance matrix of the coefficients.
 //       int nSims;           // number of simulations.
 //       double** a;          // matrix of simulated coefficient vectors.
+//
+//       Matrix Derived;      // derived quantities, if kept.
+//       EnsembleStatistics DerivedStats;    // their statistics, if summarized.
 //    };
 //
 // Notes:
@@ -90,6 +475,25 @@ namespace oneka{
 //    there is risk of a memory leak.  We should consider changing this by 
 //    either returning a managed class, or having the allocation be carried 
 //    out by the calling routine.
+//
+// o  The derived quantities are computed from each realization as it is
+//    copied into "a", so summarizing them costs no additional pass over
+//    the realizations, and does not require keeping them.
+//
+// o  With a prior, the six prior equations (see PriorEquations) are 
+//    stacked under the P Oneka equations, so fewer than six piezometers
+//    suffice, and the cost depends only upon the new readings.
+//
+// o  With CollapseReadings, repeated readings at a location produce one
+//    row, so the size of the system is the number of distinct locations.
+//
+// o  All of the randomness comes from one RandomStream, whose seed and 
+//    stream id are returned in S.Seed and S.Stream.  Without a Stream 
+//    argument it is RandomStream( Options.Seed, Options.Stream ) if 
+//    Options.UseSeed is set; otherwise the seed is drawn from the global 
+//    generator (see InitializeRNG), and that form must not be called 
+//    concurrently.  The results of a Stream argument are reproducible 
+//    from S.Seed and S.Stream only if the stream is freshly constructed.
 //-----------------------------------------------------------------------------
 EngineReturn Engine( 
    double k, 
@@ -106,101 +510,42 @@ EngineReturn Engine(
    double* Sp, 
    double Xo,
    double Yo,
-   int nSims )
+   int nSims,
+   const EngineOptions& Options )
 {
-	const double FOUR_PI	= 12.56637061435917295385057;
-
-   // Initialize.
-   Matrix A(P,6);
-   Matrix b(P,1);
-
-   // Setup the system of Oneka equations.
-   for( int p = 0; p < P; ++p)
-   {
-      // Compute the mean and variance of Phi at piezometer p.
-      double Avg, Std;
-
-      double head = Ep[p] - Base;
-      if( head < H )
-      {
-         Avg  = 0.5*k*(head*head + Sp[p]*Sp[p]);
-         Std = k*head*Sp[p];
-      }
-      else
-      {
-         Avg  = k*H*(head - 0.5*H);
-         Std = k*H*Sp[p];
-      }
-
-      // Compute the combined well potential at piezometer p.
-      double Phiw = 0;
-
-      for( int w = 0; w < W; ++w )
-      {
-         double dX = Xp[p] - Xw[w];
-         double dY = Yp[p] - Yw[w];
-         Phiw += Qw[w]/FOUR_PI * log( dX*dX + dY*dY );
-      }
-
-      // Fill in the p'th row of X, b, and V.
-      double dX = Xp[p] - Xo;
-      double dY = Yp[p] - Yo;
-
-      A(p,0) = dX*dX / Std;
-      A(p,1) = dY*dY / Std;
-      A(p,2) = dX*dY / Std;
-      A(p,3) = dX    / Std;
-      A(p,4) = dY    / Std;
-      A(p,5) = 1     / Std;
-
-      b(p,0) = (Avg - Phiw)/Std;
-   }
-
-   // Compute the statistics.
-   Matrix Mu;
-   Matrix Cov(6,6);
-
-   Multiply_MtM( A, A, Cov );
-   if( !RSPDInv( Cov, Cov ) ) throw oneka::Exception_SingularSystem();
-
-   // Compute the least squares fit.
-   if( !LeastSquaresSolve( A, b, Mu ) ) throw oneka::Exception_SingularSystem();
-
-   // Generate the realizations.
-   Matrix X( nSims, 6 );
-   Matrix Mut;
-   Transpose(Mu,Mut);                           // The RNG requires a row not a column.
-   MVNormalRNG( nSims, Mut, Cov, X );
-
-   // Fill the return structure and be done.
-   EngineReturn S;
-
-   S.Version = EngineVersion();
-   S.RunTime = Now();
+   RandomStream Stream = Options.UseSeed ? 
+      RandomStream( Options.Seed, Options.Stream ) : RandomStream( DrawSeed() );
 
-   for (int i=0; i<6; ++i)
-   {
-      S.Mu[i] = Mu(i,0);
-      for (int j=0; j<6; ++j)
-      {
-         S.Cov[i][j] = Cov(i,j);
-      }
-   }
-
-   S.nSims = nSims;
-
-   S.a = new double*[nSims];
-   for (int i=0; i<nSims; ++i)
-   {
-      S.a[i] = new double[6];
+   EngineWorkspace Work;
+   return EngineCore( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, nSims, Options, Stream, Work );
+}
 
-      for (int j=0; j<6; ++j)
-      {
-         S.a[i][j] = X(i,j);
-      }
-   }
+//-----------------------------------------------------------------------------
+EngineReturn Engine( 
+   double k, 
+   double H, 
+   double Base,
+   int W, 
+   double* Xw, 
+   double* Yw, 
+   double* Qw, 
+   int P, 
+   double* Xp, 
+   double* Yp, 
+   double* Ep, 
+   double* Sp, 
+   double Xo,
+   double Yo,
+   int nSims,
+   const EngineOptions& Options,
+   RandomStream& Stream,
+   EngineWorkspace* Work )
+{
+   if( Work != NULL )
+      return EngineCore( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, nSims, Options, Stream, *Work );
 
-   return S;
+   EngineWorkspace Local;
+   return EngineCore( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, nSims, Options, Stream, Local );
 }
 
-} // namespace oneka
\ No newline at end of file
+} // namespace oneka
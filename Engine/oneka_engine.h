@@ -41,9 +41,146 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include "ensemble_statistics.h"
+#include "gaussian.h"
+#include "matrix.h"
+#include "oneka_model.h"
 
 namespace oneka{
 
+//--------------------------------------------------------------------------
+// Engine monitor
+//
+//    An optional observer of a running Engine.  Cancelled is polled between
+//    the phases of the computation and between chunks of realizations; if 
+//    it returns true, Engine throws Exception_Cancelled.  Progress is called
+//    after each chunk of realizations.  Both may be called from the thread
+//    running Engine, not the thread that created the monitor.
+//--------------------------------------------------------------------------
+class EngineMonitor
+{
+public:
+   virtual ~EngineMonitor() {}
+
+   virtual bool Cancelled() { return false; }
+   virtual void Progress( int /*nDone*/, int /*nSims*/ ) {}
+};
+
+
+//--------------------------------------------------------------------------
+// Realization sink
+//
+//    An optional consumer of the realizations, for runs too large to hold
+//    in EngineReturn::a.  With Options.Sink set, Engine leaves S.a NULL; it
+//    calls Begin once, with the fitted moments, seed and stream, and nSims 
+//    filled in; then Write with each chunk of (n x 6) realizations, in 
+//    order, rows first through first+n-1; then End.  If any call returns 
+//    false, Engine throws Exception_SinkFailure.  The calls are made from
+//    the thread running Engine.
+//--------------------------------------------------------------------------
+struct EngineReturn;
+
+class RealizationSink
+{
+public:
+   virtual ~RealizationSink() {}
+
+   virtual bool Begin( const EngineReturn& S ) = 0;
+   virtual bool Write( int first, int n, const double* X ) = 0;
+   virtual bool End() = 0;
+};
+
+
+//--------------------------------------------------------------------------
+// Engine instrumentation
+//
+//    With Options.Instrument set, Engine records the wall time spent in 
+//    each phase, the heap allocations it made (Matrix storage and the 
+//    realizations), and the size of the problem.  An uninstrumented run 
+//    leaves Valid false and does not read the clock.
+//--------------------------------------------------------------------------
+enum EnginePhase
+{
+   PHASE_ASSEMBLY,         // the observation equations, Phiw and the moments.
+   PHASE_NORMAL,           // Multiply_MtM.
+   PHASE_INVERSE,          // RSPDInv.
+   PHASE_SOLVE,            // LeastSquaresSolve.
+   PHASE_FACTOR,           // Cholesky factor of the covariance.
+   PHASE_RANDOM,           // Gaussian deviates and their transformation.
+   PHASE_COPY,             // copy into "a", and the derived quantities.
+   N_PHASES
+};
+
+struct EngineInstrumentation
+{
+   EngineInstrumentation();
+
+   bool Valid;                      // the run was instrumented.
+
+   double Seconds[N_PHASES];        // wall time of each phase [s].
+   double TotalSeconds;             // wall time of the whole run [s].
+
+   long Allocations;                // number of heap allocations.
+   long long AllocatedBytes;        // total size of the allocations [bytes].
+
+   int W;                           // number of wells.
+   int P;                           // number of piezometers.
+   int nRows;                       // number of equations, after collapsing.
+   int nSims;                       // number of realizations.
+};
+
+
+//--------------------------------------------------------------------------
+// Engine options
+//
+//    The derived quantities (see DerivedQuantity) are computed for each
+//    realization as it is generated.  They may be kept for every 
+//    realization, or summarized by streaming statistics, or both.
+//
+//    If UsePrior is set, (PriorMu, PriorCov) is a Gaussian prior on the 
+//    six coefficients -- typically the posterior from an earlier round of
+//    readings -- and Engine returns the posterior given the new readings.
+//
+//    If CollapseReadings is set, repeated readings at the same location 
+//    are combined into one equivalent equation before the fit (see 
+//    CollapsedEquations).  The fit is unchanged.  It is off by default: 
+//    finding the repeats costs a sort of the readings, which is wasted 
+//    when every location is read once.
+//
+//    If UseSeed is set, the realizations are drawn from 
+//    RandomStream( Seed, Stream ); otherwise the seed is drawn from the 
+//    global generator (see InitializeRNG).  Either way the seed and stream
+//    are recorded in EngineReturn, and rerunning with them reproduces the
+//    realizations exactly.  An EngineInput carries its own Seed and Stream
+//    instead, and UseSeed must not be set there (see engine_batch.h).
+//--------------------------------------------------------------------------
+struct EngineOptions
+{
+   EngineOptions();
+
+   bool KeepDerived;                      // keep the (nSims x N_DERIVED) derived quantities.
+   bool SummarizeDerived;                 // accumulate statistics of the derived quantities.
+   std::vector<double> Probabilities;     // quantiles reported in the summary.
+
+   bool UsePrior;                         // fuse the prior with the readings.
+   double PriorMu[6];                     // prior mean vector of the coefficients.
+   double PriorCov[6][6];                 // prior covariance matrix of the coefficients.
+
+   bool CollapseReadings;                 // one equation per distinct location.
+
+   bool UseSeed;                          // draw from RandomStream( Seed, Stream ).
+   unsigned long long Seed;               // random number seed, if UseSeed.
+   unsigned long long Stream;             // random number stream id, if UseSeed.
+
+   bool Instrument;                       // fill EngineReturn::Instrumentation.
+
+   EngineMonitor* Monitor;                // progress and cancellation (optional).
+   RealizationSink* Sink;                 // receives the realizations, instead of "a" (optional).
+};
+
+
 //--------------------------------------------------------------------------
 // oneka engine
 //
@@ -54,13 +191,44 @@ namespace oneka{
 //--------------------------------------------------------------------------
 struct EngineReturn
 {
+   EngineReturn();
+
    std::string Version;    // OnekaLite version.
    std::string RunTime;    // Run date and time.
 
+   double Xo;              // x-coordinate of model origin.
+   double Yo;              // y-coordinate of model origin.
+
    double Mu[6];           // conditional mean vector of the coefficients.
    double Cov[6][6];       // conditional covariance matrix of the coefficients.
    int nSims;              // number of simulations.
-   double** a;             // 2d array of simulated coefficient vectors.
+   double** a;             // 2d array of simulated coefficient vectors; NULL with Options.Sink.
+
+   unsigned long long Seed;      // "a" was drawn from RandomStream( Seed, Stream ).
+   unsigned long long Stream;
+
+   EngineInstrumentation Instrumentation;    // timings and counters, if requested.
+
+   Matrix Derived;                  // (nSims x N_DERIVED) derived quantities, if kept.
+   EnsembleStatistics DerivedStats; // statistics of the derived quantities, if summarized.
+};
+
+//--------------------------------------------------------------------------
+// Scratch space for Engine.  A caller making many Engine calls on one
+// thread can keep one workspace, so the scratch matrices are reallocated
+// only when the problem size changes.
+//--------------------------------------------------------------------------
+struct EngineWorkspace
+{
+   Matrix A;
+   Matrix b;
+   Matrix Mu;
+   Matrix Mut;
+   Matrix Cov;
+   Matrix L;
+   Matrix U;
+   Matrix X;
+   std::vector<int> Group;
 };
 
 EngineReturn Engine( 
@@ -68,13 +236,26 @@ EngineReturn Engine(
    int W, double* Xw, double* Yw, double* Qw, 
    int P, double* Xp, double* Yp, double* Ep, double* Sp, 
    double Xo, double Yo,
-   int nSims );
+   int nSims,
+   const EngineOptions& Options = EngineOptions() );
+
+EngineReturn Engine( 
+   double k, double H, double Base,
+   int W, double* Xw, double* Yw, double* Qw, 
+   int P, double* Xp, double* Yp, double* Ep, double* Sp, 
+   double Xo, double Yo,
+   int nSims,
+   const EngineOptions& Options,
+   RandomStream& Stream,
+   EngineWorkspace* Work = NULL );
 
 
 //--------------------------------------------------------------------------
 // Exception classes.
 //--------------------------------------------------------------------------
 class Exception_SingularSystem{};
+class Exception_Cancelled{};
+class Exception_SinkFailure{};
 
 
 } // namespace oneka
@@ -0,0 +1,539 @@
+//=============================================================================
+// oneka_model.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "oneka_model.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "linear_systems.h"
+#include "matrix.h"
+
+namespace{
+   const double TWO_PI  = 6.283185307179586476925287;
+   const double FOUR_PI = 12.56637061435917295385057;
+
+   // Orders reading indices by location, then by index.
+   struct ByLocation
+   {
+      ByLocation( const double* X, const double* Y ) : X( X ), Y( Y ) {}
+
+      bool operator()( int i, int j ) const
+      {
+         if (X[i] != X[j]) return X[i] < X[j];
+         if (Y[i] != Y[j]) return Y[i] < Y[j];
+         return i < j;
+      }
+
+      const double* X;
+      const double* Y;
+   };
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// WellPotential
+//
+//    Return the combined discharge potential of the W discharge specified
+//    wells at the point (x,y).
+//
+// Arguments:
+//    x     x-coordinate of the evaluation point [L].
+//    y     y-coordinate of the evaluation point [L].
+//
+//    W     number of discharge specified wells [#].
+//    Xw    (W x 1) array of well x-coordinates [L].
+//    Yw    (W x 1) array of well y-coordinates [L].
+//    Qw    (W x 1) array of well discharges [L^3/T].
+//-----------------------------------------------------------------------------
+double WellPotential( double x, double y, int W, const double* Xw, const double* Yw, const double* Qw )
+{
+   double Phiw = 0;
+
+   for( int w = 0; w < W; ++w )
+   {
+      double dX = x - Xw[w];
+      double dY = y - Yw[w];
+      Phiw += Qw[w]/FOUR_PI * log( dX*dX + dY*dY );
+   }
+
+   return Phiw;
+}
+
+//-----------------------------------------------------------------------------
+// WellGradient
+//
+//    Compute the gradient of the combined well potential at the point (x,y):
+//
+//       Gx = sum_w Qw/(2 pi) (x-Xw)/r^2
+//       Gy = sum_w Qw/(2 pi) (y-Yw)/r^2
+//
+//    The arguments are as for WellPotential.
+//-----------------------------------------------------------------------------
+void WellGradient( double x, double y, int W, const double* Xw, const double* Yw, const double* Qw, double& Gx, double& Gy )
+{
+   Gx = 0;
+   Gy = 0;
+
+   for( int w = 0; w < W; ++w )
+   {
+      double dX = x - Xw[w];
+      double dY = y - Yw[w];
+      double c  = Qw[w]/TWO_PI / ( dX*dX + dY*dY );
+
+      Gx += c*dX;
+      Gy += c*dY;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Discharge
+//
+//    Compute the discharge vector [L^2/T], Q = -grad(Phi), at the point (x,y)
+//    for the coefficient vector a = [A,B,C,D,E,F]:
+//
+//       Qx = -( 2A dX + C dY + D + Gx )
+//       Qy = -( 2B dY + C dX + E + Gy )
+//
+//    where (Gx,Gy) is the gradient of the well potential.  The remaining
+//    arguments are as for Engine.
+//-----------------------------------------------------------------------------
+void Discharge( 
+   const double* a, double x, double y, 
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   double Xo, double Yo, double& Qx, double& Qy )
+{
+   double dX = x - Xo;
+   double dY = y - Yo;
+
+   double Gx, Gy;
+   WellGradient( x, y, W, Xw, Yw, Qw, Gx, Gy );
+
+   Qx = -( 2*a[0]*dX + a[2]*dY + a[3] + Gx );
+   Qy = -( 2*a[1]*dY + a[2]*dX + a[4] + Gy );
+}
+
+//-----------------------------------------------------------------------------
+// HeadToPhi
+//
+//    Return the discharge potential [L^3/T] associated with the piezometric
+//    head elevation "head" [L].  The aquifer is unconfined where the 
+//    saturated thickness is less than H, and confined elsewhere.
+//-----------------------------------------------------------------------------
+double HeadToPhi( double head, double k, double H, double Base )
+{
+   double h = head - Base;
+
+   if( h < H )
+      return 0.5*k*h*h;
+   else
+      return k*H*(h - 0.5*H);
+}
+
+//-----------------------------------------------------------------------------
+// PhiToHead
+//
+//    Return the piezometric head elevation [L] associated with the discharge
+//    potential "Phi" [L^3/T].  This is the inverse of HeadToPhi.
+//
+// Notes:
+// o  A non-positive discharge potential corresponds to a dry aquifer, for 
+//    which the head elevation is the elevation of the base.
+//-----------------------------------------------------------------------------
+double PhiToHead( double Phi, double k, double H, double Base )
+{
+   if( Phi >= 0.5*k*H*H )
+      return Base + Phi/(k*H) + 0.5*H;
+   else if( Phi > 0 )
+      return Base + sqrt( 2*Phi/k );
+   else
+      return Base;
+}
+
+//-----------------------------------------------------------------------------
+// PhiMoments
+//
+//    Compute the mean and standard deviation of the discharge potential
+//    implied by a head reading with mean Ep and standard deviation Sp.
+//
+// Arguments:
+//    Ep    expected value of the head [L].
+//    Sp    standard deviation of the head [L].
+//    k     hydraulic conductivity [L/T].
+//    H     aquifer thickness [L].
+//    Base  elevation of the aquifer base [L].
+//    Avg   mean of Phi [L^3/T], on exit.
+//    Std   standard deviation of Phi [L^3/T], on exit.
+//-----------------------------------------------------------------------------
+void PhiMoments( double Ep, double Sp, double k, double H, double Base, double& Avg, double& Std )
+{
+   double head = Ep - Base;
+   if( head < H )
+   {
+      Avg = 0.5*k*(head*head + Sp*Sp);
+      Std = k*head*Sp;
+   }
+   else
+   {
+      Avg = k*H*(head - 0.5*H);
+      Std = k*H*Sp;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// ObservationEquation
+//
+//    Compute the weighted Oneka equation for one piezometer: the row of the
+//    least squares system for the coefficients [A,B,C,D,E,F], and the 
+//    corresponding right-hand-side.
+//
+// Arguments:
+//    k     hydraulic conductivity [L/T].
+//    H     aquifer thickness [L].
+//    Base  elevation of the aquifer base [L].
+//
+//    W     number of discharge specified wells [#].
+//    Xw    (W x 1) array of well x-coordinates [L].
+//    Yw    (W x 1) array of well y-coordinates [L].
+//    Qw    (W x 1) array of well discharges [L^3/T].
+//
+//    Xp    x-coordinate of the piezometer [L].
+//    Yp    y-coordinate of the piezometer [L].
+//    Ep    expected value of the head [L].
+//    Sp    standard deviation of the head [L].
+//
+//    Xo    x-coordinate of model origin [L].
+//    Yo    y-coordinate of model origin [L].
+//
+//    row   (6) row of the system, on exit.
+//    rhs   right-hand-side, on exit.
+//
+// Notes:
+// o  The equation is scaled by the standard deviation of Phi at the 
+//    piezometer, so the ordinary least squares solution of the stacked
+//    equations is the weighted least squares solution.
+//-----------------------------------------------------------------------------
+void ObservationEquation(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xp, double Yp, double Ep, double Sp,
+   double Xo, double Yo, double* row, double& rhs )
+{
+   // Compute the mean and standard deviation of Phi at the piezometer.
+   double Avg, Std;
+   PhiMoments( Ep, Sp, k, H, Base, Avg, Std );
+
+   // Compute the combined well potential at the piezometer.
+   double Phiw = WellPotential( Xp, Yp, W, Xw, Yw, Qw );
+
+   // Fill in the row.
+   double dX = Xp - Xo;
+   double dY = Yp - Yo;
+
+   row[0] = dX*dX / Std;
+   row[1] = dY*dY / Std;
+   row[2] = dX*dY / Std;
+   row[3] = dX    / Std;
+   row[4] = dY    / Std;
+   row[5] = 1     / Std;
+
+   rhs = (Avg - Phiw)/Std;
+}
+
+
+//-----------------------------------------------------------------------------
+// CollapseObservations
+//
+//    Group the readings taken at coincident locations.
+//
+// Arguments:
+//    P     number of readings [#].
+//    Xp    (P x 1) array of reading x-coordinates [L].
+//    Yp    (P x 1) array of reading y-coordinates [L].
+//    Group (P x 1) location index of each reading, on exit.
+//
+// Returns:
+//    the number of distinct locations.
+//
+// Notes:
+// o  Locations are numbered in order of first appearance.  Coordinates 
+//    must be exactly equal to be coincident.
+//
+// o  The readings are sorted by location, O(P log P) with no allocation 
+//    per location.  Without repeats, Group[p] = p.
+//-----------------------------------------------------------------------------
+int CollapseObservations( int P, const double* Xp, const double* Yp, std::vector<int>& Group )
+{
+   Group.resize( P );
+
+   // Sort the readings by location; coincident readings become adjacent,
+   // the first reading of each location leading.
+   std::vector<int> order( P );
+   for (int p=0; p<P; ++p) order[p] = p;
+   std::sort( order.begin(), order.end(), ByLocation( Xp, Yp ) );
+
+   // Group[p] = the first reading at the location of reading p.
+   bool repeats = false;
+   for (int r=0; r<P; ++r)
+   {
+      int p = order[r];
+      int q = (r > 0) ? order[r-1] : -1;
+
+      if (q >= 0 && Xp[p] == Xp[q] && Yp[p] == Yp[q])
+      {
+         Group[p] = Group[q];
+         repeats = true;
+      }
+      else
+         Group[p] = p;
+   }
+
+   if (!repeats) return P;
+
+   // Number the locations in order of first appearance.
+   int nGroups = 0;
+   for (int p=0; p<P; ++p)
+      Group[p] = (Group[p] == p) ? nGroups++ : Group[Group[p]];
+
+   return nGroups;
+}
+
+//-----------------------------------------------------------------------------
+// CollapsedEquations
+//
+//    Compute one weighted Oneka equation per location, equivalent to the 
+//    equations of all of the readings taken there.
+//
+// Arguments:
+//    k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo 
+//          as for ObservationEquation, for P readings.
+//
+//    nGroups  number of distinct locations [#].
+//    Group    (P x 1) location index of each reading (see CollapseObservations).
+//    rows     (nGroups x 6) rows of the system, row-major, on exit.
+//    rhs      (nGroups x 1) right-hand-sides, on exit.
+//
+// Notes:
+// o  The readings at one location share the row g = [dX^2,...,1], so their
+//    equations g'/s_i = (Avg_i - Phiw)/s_i contribute
+//
+//       g g' sum(w_i)    and    g sum( w_i (Avg_i - Phiw) ),   w_i = 1/s_i^2
+//
+//    to the normal equations.  The single equation
+//
+//       g' sqrt(w) = sqrt(w) (Avg - Phiw),   w = sum(w_i),  Avg = sum(w_i Avg_i)/w
+//
+//    contributes exactly the same, so the fitted mean and covariance are
+//    unchanged, while the well potential is computed once per location.
+//
+// o  A location with a single reading gets exactly the row computed by 
+//    ObservationEquation.
+//-----------------------------------------------------------------------------
+void CollapsedEquations(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   int P, const double* Xp, const double* Yp, const double* Ep, const double* Sp,
+   double Xo, double Yo, 
+   int nGroups, const std::vector<int>& Group, double* rows, double* rhs )
+{
+   assert( int(Group.size()) == P );
+
+   std::vector<int>    count( nGroups, 0 );
+   std::vector<int>    first( nGroups, -1 );
+   std::vector<double> sumw( nGroups, 0.0 );
+   std::vector<double> sumwAvg( nGroups, 0.0 );
+
+   for (int p=0; p<P; ++p)
+   {
+      int g = Group[p];
+
+      double Avg, Std;
+      PhiMoments( Ep[p], Sp[p], k, H, Base, Avg, Std );
+
+      double w = 1/(Std*Std);
+      sumw[g]    += w;
+      sumwAvg[g] += w*Avg;
+
+      if( count[g]++ == 0 ) first[g] = p;
+   }
+
+   for (int g=0; g<nGroups; ++g)
+   {
+      int p = first[g];
+      double* row = rows + 6*g;
+
+      if( count[g] == 1 )
+      {
+         ObservationEquation( k, H, Base, W, Xw, Yw, Qw, 
+            Xp[p], Yp[p], Ep[p], Sp[p], Xo, Yo, row, rhs[g] );
+         continue;
+      }
+
+      double Phiw = WellPotential( Xp[p], Yp[p], W, Xw, Yw, Qw );
+      double s = sqrt( sumw[g] );
+
+      double dX = Xp[p] - Xo;
+      double dY = Yp[p] - Yo;
+
+      row[0] = dX*dX * s;
+      row[1] = dY*dY * s;
+      row[2] = dX*dY * s;
+      row[3] = dX    * s;
+      row[4] = dY    * s;
+      row[5] = 1     * s;
+
+      rhs[g] = (sumwAvg[g]/sumw[g] - Phiw) * s;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// PriorEquations
+//
+//    Express a Gaussian prior on the six coefficients, N(Mu0, Cov0), as six
+//    pseudo-observation equations.  Stacking these rows under the weighted
+//    Oneka equations turns the least squares solution into the Bayesian 
+//    posterior (the information filter form of the update).
+//
+// Arguments:
+//    Mu0   (6) prior mean vector of the coefficients.
+//    Cov0  (6 x 6) prior covariance matrix of the coefficients.
+//    rows  (6 x 6) prior equations, on exit.
+//    rhs   (6) corresponding right-hand-sides, on exit.
+//
+// Returns:
+//    true  if Cov0 is positive definite;
+//    false if not.
+//
+// Notes:
+// o  The rows are inv(S L), where S = diag(sqrt(Cov0)) and S L L' S = Cov0, 
+//    so that rows' rows = inv(Cov0).  Factoring the correlation matrix 
+//    rather than Cov0 keeps the pivot tests independent of the very 
+//    different scales of the six coefficients.
+//-----------------------------------------------------------------------------
+bool PriorEquations( const double Mu0[6], const double Cov0[6][6], double rows[6][6], double rhs[6] )
+{
+   double s[6];
+   for (int i=0; i<6; ++i)
+   {
+      if( !(Cov0[i][i] > 0) ) return false;
+      s[i] = sqrt( Cov0[i][i] );
+   }
+
+   Matrix R(6,6);
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         R(i,j) = Cov0[i][j]/(s[i]*s[j]);
+
+   Matrix L;
+   if( !CholeskyDecomposition( R, L ) ) return false;
+
+   // Invert L by forward substitution, column by column, and unscale.
+   for (int j=0; j<6; ++j)
+   {
+      double x[6];
+      for (int i=0; i<6; ++i)
+      {
+         double sum = (i == j) ? 1.0 : 0.0;
+         for (int l=0; l<i; ++l)
+            sum -= L(i,l)*x[l];
+         x[i] = sum/L(i,i);
+      }
+
+      for (int i=0; i<6; ++i)
+         rows[i][j] = x[i]/s[j];
+   }
+
+   for (int i=0; i<6; ++i)
+   {
+      rhs[i] = 0;
+      for (int j=0; j<6; ++j)
+         rhs[i] += rows[i][j]*Mu0[j];
+   }
+
+   return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// DerivedQuantities
+//
+//    Compute the derived quantities, indexed by DerivedQuantity, for the 
+//    coefficient vector a = [A,B,C,D,E,F] about the origin (Xo,Yo).
+//
+// Arguments:
+//    a     (6) coefficient vector.
+//    Xo    x-coordinate of model origin [L].
+//    Yo    y-coordinate of model origin [L].
+//    d     (N_DERIVED) array of derived quantities, on exit.
+//
+// Notes:
+// o  The regional discharge at the origin is -(D,E); its direction is 
+//    measured counter-clockwise from the +x axis.
+//
+// o  The stationary point of the quadratic (the center of the mound or
+//    trough) solves
+//
+//       [2A  C ] [dX]     [D]
+//       [ C 2B ] [dY] = - [E]
+//
+//    If the quadratic has no unique stationary point, NaN is returned.
+//-----------------------------------------------------------------------------
+void DerivedQuantities( const double* a, double Xo, double Yo, double* d )
+{
+   const double A = a[0], B = a[1], C = a[2], D = a[3], E = a[4];
+
+   d[DERIVED_RECHARGE]  = -2*(A + B);
+   d[DERIVED_GRADIENT]  = sqrt( D*D + E*E );
+   d[DERIVED_DIRECTION] = atan2( -E, -D );
+
+   double det = 4*A*B - C*C;
+   if (det != 0)
+   {
+      d[DERIVED_STATIONARY_X] = Xo + (-2*B*D + C*E)/det;
+      d[DERIVED_STATIONARY_Y] = Yo + ( C*D - 2*A*E)/det;
+   }
+   else
+   {
+      d[DERIVED_STATIONARY_X] = std::numeric_limits<double>::quiet_NaN();
+      d[DERIVED_STATIONARY_Y] = std::numeric_limits<double>::quiet_NaN();
+   }
+}
+
+
+} // namespace oneka
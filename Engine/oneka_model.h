@@ -0,0 +1,107 @@
+//=============================================================================
+// oneka_model.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ONEKA_MODEL_H
+#define ONEKA_MODEL_H
+
+#include <vector>
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The Oneka discharge potential is
+//
+//    Phi(x,y) = A dX^2 + B dY^2 + C dX dY + D dX + E dY + F 
+//             + sum_w Qw/(4 pi) log( (x-Xw)^2 + (y-Yw)^2 )
+//
+// where dX = x - Xo and dY = y - Yo.  These routines evaluate the pieces
+// of the model that do not depend upon the six coefficients, and convert
+// between the discharge potential and the piezometric head.
+//-----------------------------------------------------------------------------
+
+double WellPotential( double x, double y, int W, const double* Xw, const double* Yw, const double* Qw );
+void WellGradient( double x, double y, int W, const double* Xw, const double* Yw, const double* Qw, double& Gx, double& Gy );
+
+void Discharge( 
+   const double* a, double x, double y, 
+   int W, const double* Xw, const double* Yw, const double* Qw, 
+   double Xo, double Yo, double& Qx, double& Qy );
+
+double HeadToPhi( double head, double k, double H, double Base );
+double PhiToHead( double Phi, double k, double H, double Base );
+
+void PhiMoments( double Ep, double Sp, double k, double H, double Base, double& Avg, double& Std );
+
+void ObservationEquation(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xp, double Yp, double Ep, double Sp,
+   double Xo, double Yo, double* row, double& rhs );
+
+int CollapseObservations( int P, const double* Xp, const double* Yp, std::vector<int>& Group );
+
+void CollapsedEquations(
+   double k, double H, double Base,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   int P, const double* Xp, const double* Yp, const double* Ep, const double* Sp,
+   double Xo, double Yo, 
+   int nGroups, const std::vector<int>& Group, double* rows, double* rhs );
+
+bool PriorEquations( const double Mu0[6], const double Cov0[6][6], double rows[6][6], double rhs[6] );
+
+
+//-----------------------------------------------------------------------------
+// Derived quantities: simple functions of the six coefficients [A..F] that
+// are of direct hydrogeologic interest.
+//-----------------------------------------------------------------------------
+enum DerivedQuantity
+{
+   DERIVED_RECHARGE = 0,         // areal recharge, -laplacian(Phi) = -2(A+B) [L/T].
+   DERIVED_GRADIENT,             // magnitude of the regional discharge at the origin [L^2/T].
+   DERIVED_DIRECTION,            // direction of the regional discharge at the origin [radians].
+   DERIVED_STATIONARY_X,         // x-coordinate of the stationary point of the quadratic [L].
+   DERIVED_STATIONARY_Y,         // y-coordinate of the stationary point of the quadratic [L].
+   N_DERIVED
+};
+
+void DerivedQuantities( const double* a, double Xo, double Yo, double* d );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ONEKA_MODEL_H
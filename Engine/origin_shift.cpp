@@ -0,0 +1,235 @@
+//=============================================================================
+// origin_shift.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "origin_shift.h"
+
+#include <cassert>
+#include <vector>
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// OriginTransform
+//
+//    Compute the (6 x 6) matrix T that maps the coefficients about the 
+//    origin (Xo,Yo) to the coefficients about the origin (Xn,Yn).
+//-----------------------------------------------------------------------------
+void OriginTransform( double Xo, double Yo, double Xn, double Yn, double T[6][6] )
+{
+   const double u = Xn - Xo;
+   const double v = Yn - Yo;
+
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         T[i][j] = (i == j) ? 1.0 : 0.0;
+
+   T[3][0] = 2*u;
+   T[3][2] = v;
+
+   T[4][1] = 2*v;
+   T[4][2] = u;
+
+   T[5][0] = u*u;
+   T[5][1] = v*v;
+   T[5][2] = u*v;
+   T[5][3] = u;
+   T[5][4] = v;
+}
+
+//-----------------------------------------------------------------------------
+// ShiftOrigin
+//
+//    Re-express the mean vector and covariance matrix of the coefficients
+//    about the origin (Xn,Yn).
+//
+// Arguments:
+//    Xo    x-coordinate of the current model origin [L].
+//    Yo    y-coordinate of the current model origin [L].
+//    Xn    x-coordinate of the new model origin [L].
+//    Yn    y-coordinate of the new model origin [L].
+//
+//    Mu    (6) mean vector about (Xo,Yo).
+//    Cov   (6 x 6) covariance matrix about (Xo,Yo).
+//
+//    MuN   (6) mean vector about (Xn,Yn), on exit.
+//    CovN  (6 x 6) covariance matrix about (Xn,Yn), on exit.
+//-----------------------------------------------------------------------------
+void ShiftOrigin( 
+   double Xo, double Yo, double Xn, double Yn,
+   const double Mu[6], const double Cov[6][6],
+   double MuN[6], double CovN[6][6] )
+{
+   double T[6][6];
+   OriginTransform( Xo, Yo, Xn, Yn, T );
+
+   // MuN = T Mu, and TC = T Cov.
+   double TC[6][6];
+   for (int i=0; i<6; ++i)
+   {
+      double sum = 0;
+      for (int l=0; l<=i; ++l)
+         sum += T[i][l]*Mu[l];
+      MuN[i] = sum;
+
+      for (int j=0; j<6; ++j)
+      {
+         double s = 0;
+         for (int l=0; l<=i; ++l)
+            s += T[i][l]*Cov[l][j];
+         TC[i][j] = s;
+      }
+   }
+
+   // CovN = TC T', which is symmetric.
+   for (int i=0; i<6; ++i)
+   {
+      for (int j=0; j<=i; ++j)
+      {
+         double s = 0;
+         for (int l=0; l<=j; ++l)
+            s += TC[i][l]*T[j][l];
+         CovN[i][j] = s;
+         CovN[j][i] = s;
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+// ShiftOrigins
+//
+//    Re-express the mean vector and covariance matrix of the coefficients
+//    about each of nOrigins new origins.
+//
+// Arguments:
+//    Xo       x-coordinate of the current model origin [L].
+//    Yo       y-coordinate of the current model origin [L].
+//    nOrigins number of new origins [#].
+//    Xn       (nOrigins x 1) array of new origin x-coordinates [L].
+//    Yn       (nOrigins x 1) array of new origin y-coordinates [L].
+//
+//    Mu       (6) mean vector about (Xo,Yo).
+//    Cov      (6 x 6) covariance matrix about (Xo,Yo).
+//
+//    MuN      (nOrigins x 6) mean vectors, one per row, on exit.
+//    CovN     (nOrigins x 36) covariance matrices, one per row in 
+//             row-major order, on exit.
+//-----------------------------------------------------------------------------
+void ShiftOrigins(
+   double Xo, double Yo, int nOrigins, const double* Xn, const double* Yn,
+   const double Mu[6], const double Cov[6][6],
+   Matrix& MuN, Matrix& CovN )
+{
+   assert( nOrigins >= 0 );
+
+   MuN.Resize( nOrigins, 6 );
+   CovN.Resize( nOrigins, 36 );
+
+   #pragma omp parallel for schedule(static)
+   for (int n=0; n<nOrigins; ++n)
+   {
+      double C[6][6];
+      ShiftOrigin( Xo, Yo, Xn[n], Yn[n], Mu, Cov, MuN.Base(n,0), C );
+
+      for (int i=0; i<6; ++i)
+         for (int j=0; j<6; ++j)
+            CovN(n,6*i+j) = C[i][j];
+   }
+}
+
+//-----------------------------------------------------------------------------
+// ShiftOrigins
+//
+//    Re-express each of the nSims realizations about each of nOrigins new
+//    origins.
+//
+// Arguments:
+//    Xo       x-coordinate of the current model origin [L].
+//    Yo       y-coordinate of the current model origin [L].
+//    nOrigins number of new origins [#].
+//    Xn       (nOrigins x 1) array of new origin x-coordinates [L].
+//    Yn       (nOrigins x 1) array of new origin y-coordinates [L].
+//
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) realizations about (Xo,Yo).
+//
+//    X        (nSims x 6*nOrigins) realizations, on exit.  Columns 
+//             6n..6n+5 of row i are realization i about origin n.
+//
+// Notes:
+// o  Each realization is read once and written for every origin.  Since
+//    A, B, and C are unchanged, only the shift terms are computed per
+//    origin, and the realizations are processed in parallel.
+//-----------------------------------------------------------------------------
+void ShiftOrigins(
+   double Xo, double Yo, int nOrigins, const double* Xn, const double* Yn,
+   int nSims, const double* const* a, 
+   Matrix& X )
+{
+   assert( nOrigins >= 0 && nSims >= 0 );
+
+   X.Resize( nSims, 6*nOrigins );
+
+   // The shifts, in a structure-of-arrays layout.
+   std::vector<double> u( nOrigins ), v( nOrigins );
+   for (int n=0; n<nOrigins; ++n)
+   {
+      u[n] = Xn[n] - Xo;
+      v[n] = Yn[n] - Yo;
+   }
+
+   #pragma omp parallel for schedule(static)
+   for (int i=0; i<nSims; ++i)
+   {
+      const double A = a[i][0], B = a[i][1], C = a[i][2];
+      const double D = a[i][3], E = a[i][4], F = a[i][5];
+
+      double* x = X.Base(i,0);
+      for (int n=0; n<nOrigins; ++n, x+=6)
+      {
+         const double un = u[n], vn = v[n];
+
+         x[0] = A;
+         x[1] = B;
+         x[2] = C;
+         x[3] = 2*un*A + vn*C + D;
+         x[4] = 2*vn*B + un*C + E;
+         x[5] = un*(un*A + vn*C + D) + vn*(vn*B + E) + F;
+      }
+   }
+}
+
+
+} // namespace oneka
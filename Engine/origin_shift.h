@@ -0,0 +1,82 @@
+//=============================================================================
+// origin_shift.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ORIGIN_SHIFT_H
+#define ORIGIN_SHIFT_H
+
+#include "matrix.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Re-expression of the Oneka coefficients about a new model origin.
+//
+// Moving the origin from (Xo,Yo) to (Xn,Yn) is an exact linear transform 
+// of the coefficients, a' = T a, where, with u = Xn - Xo and v = Yn - Yo,
+//
+//    A' = A
+//    B' = B
+//    C' = C
+//    D' = 2u A       + v C + D
+//    E' =       2v B + u C     + E
+//    F' = u^2 A + v^2 B + uv C + u D + v E + F
+//
+// so the mean transforms as T Mu, and the covariance as T Cov T'.  No
+// refitting is required.
+//-----------------------------------------------------------------------------
+void OriginTransform( double Xo, double Yo, double Xn, double Yn, double T[6][6] );
+
+void ShiftOrigin( 
+   double Xo, double Yo, double Xn, double Yn,
+   const double Mu[6], const double Cov[6][6],
+   double MuN[6], double CovN[6][6] );
+
+void ShiftOrigins(
+   double Xo, double Yo, int nOrigins, const double* Xn, const double* Yn,
+   const double Mu[6], const double Cov[6][6],
+   Matrix& MuN, Matrix& CovN );
+
+void ShiftOrigins(
+   double Xo, double Yo, int nOrigins, const double* Xn, const double* Yn,
+   int nSims, const double* const* a, 
+   Matrix& X );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ORIGIN_SHIFT_H
@@ -0,0 +1,210 @@
+//=============================================================================
+// point_set.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "point_set.h"
+
+#include <cassert>
+
+#include "oneka_model.h"
+
+namespace oneka{
+
+//=============================================================================
+// PointSet
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Null constructor.
+//-----------------------------------------------------------------------------
+PointSet::PointSet()
+:  m_N( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Constructor for a set of scattered points.
+//
+// Arguments:
+//    N     number of points [#].
+//    X     (N x 1) array of point x-coordinates [L].
+//    Y     (N x 1) array of point y-coordinates [L].
+//
+//    W     number of discharge specified wells [#].
+//    Xw    (W x 1) array of well x-coordinates [L].
+//    Yw    (W x 1) array of well y-coordinates [L].
+//    Qw    (W x 1) array of well discharges [L^3/T].
+//
+//    Xo    x-coordinate of model origin [L].
+//    Yo    y-coordinate of model origin [L].
+//-----------------------------------------------------------------------------
+PointSet::PointSet( 
+   int N, const double* X, const double* Y,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo )
+:  m_N( N ),
+   m_XY( 2, N )
+{
+   assert( N > 0 );
+
+   for (int j=0; j<N; ++j)
+   {
+      m_XY(0,j) = X[j];
+      m_XY(1,j) = Y[j];
+   }
+
+   Setup( W, Xw, Yw, Qw, Xo, Yo );
+}
+
+//-----------------------------------------------------------------------------
+// Constructor for a raster grid.
+//
+//    The grid has nX columns and nY rows of nodes.  The node in row i and
+//    column j is located at (X0 + j*DeltaX, Y0 + i*DeltaY), and it is point
+//    number i*nX + j in the set.
+//
+//    The remaining arguments are as for the scattered point constructor.
+//-----------------------------------------------------------------------------
+PointSet::PointSet(
+   double X0, double Y0, double DeltaX, double DeltaY, int nX, int nY,
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo )
+:  m_N( nX*nY ),
+   m_XY( 2, nX*nY )
+{
+   assert( nX > 0 && nY > 0 );
+
+   for (int i=0; i<nY; ++i)
+   {
+      for (int j=0; j<nX; ++j)
+      {
+         m_XY(0,i*nX + j) = X0 + j*DeltaX;
+         m_XY(1,i*nX + j) = Y0 + i*DeltaY;
+      }
+   }
+
+   Setup( W, Xw, Yw, Qw, Xo, Yo );
+}
+
+//-----------------------------------------------------------------------------
+// Evaluate the basis functions, the well potential and its gradient at 
+// every point.
+//-----------------------------------------------------------------------------
+void PointSet::Setup( int W, const double* Xw, const double* Yw, const double* Qw, double Xo, double Yo )
+{
+   m_Basis.Resize( 6, m_N );
+   m_Phiw.Resize( 1, m_N );
+   m_Gradient.Resize( 2, m_N );
+
+   const double* x = m_XY.Base(0,0);
+   const double* y = m_XY.Base(1,0);
+
+   #pragma omp parallel for schedule(static)
+   for (int j=0; j<m_N; ++j)
+   {
+      double dX = x[j] - Xo;
+      double dY = y[j] - Yo;
+
+      m_Basis(0,j) = dX*dX;
+      m_Basis(1,j) = dY*dY;
+      m_Basis(2,j) = dX*dY;
+      m_Basis(3,j) = dX;
+      m_Basis(4,j) = dY;
+      m_Basis(5,j) = 1;
+
+      m_Phiw(0,j) = WellPotential( x[j], y[j], W, Xw, Yw, Qw );
+      WellGradient( x[j], y[j], W, Xw, Yw, Qw, m_Gradient(0,j), m_Gradient(1,j) );
+   }
+}
+
+//-----------------------------------------------------------------------------
+// Number of points.
+//-----------------------------------------------------------------------------
+int PointSet::nPoints() const
+{
+   return m_N;
+}
+
+//-----------------------------------------------------------------------------
+// Point x-coordinates.
+//-----------------------------------------------------------------------------
+const double* PointSet::X() const
+{
+   return m_XY.Base(0,0);
+}
+
+//-----------------------------------------------------------------------------
+// Point y-coordinates.
+//-----------------------------------------------------------------------------
+const double* PointSet::Y() const
+{
+   return m_XY.Base(1,0);
+}
+
+//-----------------------------------------------------------------------------
+// The k'th basis function evaluated at every point: k = 0,1,...,5 for
+// [dX^2, dY^2, dX dY, dX, dY, 1].
+//-----------------------------------------------------------------------------
+const double* PointSet::Basis( int k ) const
+{
+   return m_Basis.Base(k,0);
+}
+
+//-----------------------------------------------------------------------------
+// The combined well potential at every point.
+//-----------------------------------------------------------------------------
+const double* PointSet::Phiw() const
+{
+   return m_Phiw.Base(0,0);
+}
+
+//-----------------------------------------------------------------------------
+// The x-derivative of the combined well potential at every point.
+//-----------------------------------------------------------------------------
+const double* PointSet::dPhiwdX() const
+{
+   return m_Gradient.Base(0,0);
+}
+
+//-----------------------------------------------------------------------------
+// The y-derivative of the combined well potential at every point.
+//-----------------------------------------------------------------------------
+const double* PointSet::dPhiwdY() const
+{
+   return m_Gradient.Base(1,0);
+}
+
+
+} // namespace oneka
@@ -0,0 +1,99 @@
+//=============================================================================
+// point_set.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef POINT_SET_H
+#define POINT_SET_H
+
+#include "matrix.h"
+
+namespace oneka{
+
+//=============================================================================
+// PointSet
+//
+//    A set of evaluation points together with everything about the Oneka 
+//    model at those points that does not depend upon the coefficients: the
+//    six basis functions and the combined well potential.  The discharge
+//    potential at point j for coefficient vector a is then 
+//
+//       Phi(j) = sum_k a[k]*Basis(k)[j] + Phiw()[j]
+//
+//    The gradient of the well potential is also kept for evaluating the 
+//    discharge vector.  The data are stored by basis function (structure of
+//    arrays) so that the evaluation loops run over contiguous memory.
+//=============================================================================
+class PointSet
+{
+public:
+   // Life cycle
+   PointSet();                                        // null constructor
+
+   PointSet(                                          // scattered points
+      int N, const double* X, const double* Y,
+      int W, const double* Xw, const double* Yw, const double* Qw,
+      double Xo, double Yo );
+
+   PointSet(                                          // raster grid
+      double X0, double Y0, double DeltaX, double DeltaY, int nX, int nY,
+      int W, const double* Xw, const double* Yw, const double* Qw,
+      double Xo, double Yo );
+
+   // Inquiry.
+   int nPoints() const;                               // number of points
+
+   const double* X() const;                           // (N) x-coordinates
+   const double* Y() const;                           // (N) y-coordinates
+   const double* Basis( int k ) const;                // (N) k'th basis function
+   const double* Phiw() const;                        // (N) well potential
+   const double* dPhiwdX() const;                     // (N) x-derivative of Phiw
+   const double* dPhiwdY() const;                     // (N) y-derivative of Phiw
+
+private:
+   void Setup( int W, const double* Xw, const double* Yw, const double* Qw, double Xo, double Yo );
+
+   int    m_N;                                        // number of points
+   Matrix m_XY;                                       // (2 x N) coordinates
+   Matrix m_Basis;                                    // (6 x N) basis functions
+   Matrix m_Phiw;                                     // (1 x N) well potential
+   Matrix m_Gradient;                                 // (2 x N) well potential gradient
+};
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // POINT_SET_H
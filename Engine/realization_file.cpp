@@ -0,0 +1,397 @@
+//=============================================================================
+// realization_file.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "realization_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "trace.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && defined(__SSE2__)
+#include <emmintrin.h>
+#define ONEKA_STREAMING_STORES
+#endif
+
+namespace oneka{
+
+namespace{
+
+   //--------------------------------------------------------------------------
+   // The header block: the MatrixFileHeader, the RealizationHeader, and 
+   // zeros up to the data.
+   //--------------------------------------------------------------------------
+   void HeaderBlock( const EngineReturn& S, unsigned int Type, std::vector<char>& Block )
+   {
+      MatrixFileHeader M;
+      M.Type   = Type;
+      M.nRows  = S.nSims;
+      M.nCols  = 6;
+      M.Offset = REALIZATION_FILE_OFFSET;
+
+      RealizationHeader R;
+      R.Seed   = S.Seed;
+      R.Stream = S.Stream;
+      R.Xo = S.Xo;
+      R.Yo = S.Yo;
+      std::memcpy( R.Mu, S.Mu, sizeof(R.Mu) );
+      std::memcpy( R.Cov, S.Cov, sizeof(R.Cov) );
+
+      Block.assign( std::size_t( REALIZATION_FILE_OFFSET ), 0 );
+      std::memcpy( &Block[0], &M, sizeof(M) );
+      std::memcpy( &Block[sizeof(M)], &R, sizeof(R) );
+   }
+
+   //--------------------------------------------------------------------------
+   // Copy n bytes into the mapping; with streaming stores, the aligned 
+   // 16-byte blocks go around the cache.
+   //--------------------------------------------------------------------------
+   void Copy( char* dst, const char* src, std::size_t n, bool NonTemporal )
+   {
+   #ifdef ONEKA_STREAMING_STORES
+      if( NonTemporal )
+      {
+         while( n > 0 && (reinterpret_cast<std::size_t>( dst ) & 15) != 0 )
+         {
+            *dst++ = *src++;
+            --n;
+         }
+         for( ; n >= 16; n -= 16, dst += 16, src += 16 )
+            _mm_stream_si128( reinterpret_cast<__m128i*>( dst ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( src ) ) );
+      }
+   #else
+      (void)NonTemporal;
+   #endif
+      std::memcpy( dst, src, n );
+   }
+
+#ifndef _WIN32
+   bool WriteAll( int fd, const char* p, std::size_t n, off_t offset )
+   {
+      while( n > 0 )
+      {
+         ssize_t k = ::pwrite( fd, p, n, offset );
+         if( k < 0 && errno == EINTR ) continue;
+         if( k <= 0 ) return false;
+         p += k;
+         n -= std::size_t( k );
+         offset += k;
+      }
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // Reserve the file space [start, end): allocated where the file system
+   // supports it, so a full disk is an error here rather than a fault in 
+   // the mapping; otherwise by extending the file.
+   //--------------------------------------------------------------------------
+   bool Reserve( int fd, long long start, long long end )
+   {
+   #ifdef __linux__
+      int rc = ::posix_fallocate( fd, off_t( start ), off_t( end - start ) );
+      if( rc == 0 ) return true;
+      if( rc != EINVAL && rc != EOPNOTSUPP ) return false;
+   #endif
+      return ::ftruncate( fd, off_t( end ) ) == 0;
+   }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// RealizationHeader
+//-----------------------------------------------------------------------------
+RealizationHeader::RealizationHeader()
+:  Version( REALIZATION_FILE_VERSION ),
+   Reserved( 0 ),
+   Seed( 0 ),
+   Stream( 0 ),
+   Xo( 0 ),
+   Yo( 0 )
+{
+   std::memcpy( Magic, REALIZATION_FILE_MAGIC, sizeof(Magic) );
+   std::memset( Mu, 0, sizeof(Mu) );
+   std::memset( Cov, 0, sizeof(Cov) );
+}
+
+//-----------------------------------------------------------------------------
+// LoadRealizationHeader
+//
+//    Read the RealizationHeader of the realization file Name.
+//-----------------------------------------------------------------------------
+bool LoadRealizationHeader( const std::string& Name, RealizationHeader& R )
+{
+   MatrixFileHeader M;
+   if( !LoadMatrixHeader( Name, M ) || M.nCols != 6 || M.Offset < static_cast<long long>( sizeof(M) + sizeof(R) ) ) 
+      return false;
+
+   std::FILE* fp = std::fopen( Name.c_str(), "rb" );
+   if( fp == NULL ) return false;
+
+   bool ok = std::fseek( fp, long( sizeof(M) ), SEEK_SET ) == 0 
+          && std::fread( &R, sizeof(R), 1, fp ) == 1;
+   std::fclose( fp );
+
+   return ok 
+      && std::memcmp( R.Magic, REALIZATION_FILE_MAGIC, sizeof(R.Magic) ) == 0
+      && R.Version == REALIZATION_FILE_VERSION;
+}
+
+//=============================================================================
+// RealizationFile
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Constructor.
+//
+//    Extent is rounded up to a whole number of pages.  Nothing is written
+//    until Begin.
+//-----------------------------------------------------------------------------
+RealizationFile::RealizationFile( const std::string& Name, unsigned int Type, std::size_t Extent, bool NonTemporal )
+:  m_Name( Name ),
+   m_Type( Type ),
+   m_Extent( Extent ),
+   m_NonTemporal( NonTemporal ),
+   m_Begun( false ),
+   m_Complete( false ),
+   m_Next( 0 ),
+   m_Size( 0 ),
+#ifdef _WIN32
+   m_File( NULL )
+#else
+   m_fd( -1 ),
+   m_Map( NULL ),
+   m_MapStart( 0 ),
+   m_MapEnd( 0 )
+#endif
+{
+#ifndef _WIN32
+   const std::size_t page = std::size_t( ::sysconf( _SC_PAGESIZE ) );
+   m_Extent = std::max( page, (m_Extent + page - 1)/page*page );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Destructor.
+//-----------------------------------------------------------------------------
+RealizationFile::~RealizationFile()
+{
+#ifdef _WIN32
+   if( m_File != NULL ) std::fclose( m_File );
+#else
+   Unmap( false );
+   if( m_fd >= 0 ) ::close( m_fd );
+#endif
+
+   if( m_Begun && !m_Complete )
+      std::remove( m_Name.c_str() );
+}
+
+//-----------------------------------------------------------------------------
+bool RealizationFile::Complete() const
+{
+   return m_Complete;
+}
+
+//-----------------------------------------------------------------------------
+// Begin
+//
+//    Create the file, and write the header.
+//-----------------------------------------------------------------------------
+bool RealizationFile::Begin( const EngineReturn& S )
+{
+   if( m_Begun || MatrixFileElementSize( m_Type ) == 0 || S.nSims < 0 ) return false;
+   m_Begun = true;
+
+   std::vector<char> Block;
+   HeaderBlock( S, m_Type, Block );
+
+   m_Next = REALIZATION_FILE_OFFSET;
+   m_Size = REALIZATION_FILE_OFFSET + static_cast<long long>( S.nSims )*6*MatrixFileElementSize( m_Type );
+
+#ifdef _WIN32
+   m_File = std::fopen( m_Name.c_str(), "wb" );
+   return m_File != NULL && std::fwrite( &Block[0], Block.size(), 1, m_File ) == 1;
+#else
+   m_fd = ::open( m_Name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+   return m_fd >= 0 && WriteAll( m_fd, &Block[0], Block.size(), 0 );
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Write
+//
+//    Append realizations [first, first+n).  The chunks must arrive in order.
+//-----------------------------------------------------------------------------
+bool RealizationFile::Write( int first, int n, const double* X )
+{
+   ONEKA_TRACE_SCOPE( "RealizationFile::Write" );
+
+   const std::size_t size = MatrixFileElementSize( m_Type );
+   if( !m_Begun || m_Complete || n < 0 ) return false;
+   if( m_Next != REALIZATION_FILE_OFFSET + static_cast<long long>( first )*6*static_cast<long long>( size ) ) return false;
+
+   if( m_Type == MATRIX_FLOAT32 )
+   {
+      m_Floats.assign( X, X + 6*std::size_t( n ) );
+      return n == 0 || Append( reinterpret_cast<const char*>( &m_Floats[0] ), m_Floats.size()*size );
+   }
+   return Append( reinterpret_cast<const char*>( X ), 6*std::size_t( n )*size );
+}
+
+//-----------------------------------------------------------------------------
+// End
+//
+//    Check that every realization arrived, and make the file durable.
+//-----------------------------------------------------------------------------
+bool RealizationFile::End()
+{
+   ONEKA_TRACE_SCOPE( "RealizationFile::End" );
+
+   if( !m_Begun || m_Complete || m_Next != m_Size ) return false;
+
+#ifdef _WIN32
+   bool ok = std::fflush( m_File ) == 0 && ::_commit( ::_fileno( m_File ) ) == 0;
+   ok &= ( std::fclose( m_File ) == 0 );
+   m_File = NULL;
+#else
+   Unmap( true );
+   bool ok = ::ftruncate( m_fd, off_t( m_Size ) ) == 0 && ::fsync( m_fd ) == 0;
+   ok &= ( ::close( m_fd ) == 0 );
+   m_fd = -1;
+#endif
+
+   m_Complete = ok;
+   return ok;
+}
+
+//-----------------------------------------------------------------------------
+// Append
+//
+//    Copy n bytes to the end of the data, advancing through the extents.
+//-----------------------------------------------------------------------------
+bool RealizationFile::Append( const char* p, std::size_t n )
+{
+   if( m_Next + static_cast<long long>( n ) > m_Size ) return false;
+
+#ifdef _WIN32
+   if( n > 0 && std::fwrite( p, n, 1, m_File ) != 1 ) return false;
+   m_Next += n;
+   return true;
+#else
+   while( n > 0 )
+   {
+      if( (m_Map == NULL || m_Next == m_MapEnd) && !Advance() ) return false;
+
+      std::size_t k = std::size_t( std::min( static_cast<long long>( n ), m_MapEnd - m_Next ) );
+      Copy( m_Map + (m_Next - m_MapStart), p, k, m_NonTemporal );
+
+      p += k;
+      n -= k;
+      m_Next += k;
+   }
+   return true;
+#endif
+}
+
+#ifndef _WIN32
+//-----------------------------------------------------------------------------
+// Advance
+//
+//    Retire the full extent, and reserve and map the next one.
+//-----------------------------------------------------------------------------
+bool RealizationFile::Advance()
+{
+   ONEKA_TRACE_SCOPE( "RealizationFile::Advance" );
+
+   Unmap( false );
+
+   const long long page = ::sysconf( _SC_PAGESIZE );
+   const long long start = m_Next / page * page;
+   const long long end   = std::min( m_Next + static_cast<long long>( m_Extent ), m_Size );
+   if( end <= m_Next || !Reserve( m_fd, start, end ) ) return false;
+
+   void* p = ::mmap( NULL, std::size_t( end - start ), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, off_t( start ) );
+   if( p == MAP_FAILED ) return false;
+
+   m_Map = static_cast<char*>( p );
+   m_MapStart = start;
+   m_MapEnd = end;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// Unmap
+//
+//    Release the mapped extent.  Its write-back is started, and with Sync,
+//    waited for.
+//-----------------------------------------------------------------------------
+void RealizationFile::Unmap( bool Sync )
+{
+   if( m_Map == NULL ) return;
+
+#ifdef ONEKA_STREAMING_STORES
+   _mm_sfence();
+#endif
+
+   const std::size_t length = std::size_t( m_MapEnd - m_MapStart );
+   if( Sync )
+      ::msync( m_Map, length, MS_SYNC );
+   else
+   {
+   #if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+      ::sync_file_range( m_fd, off_t( m_MapStart ), off_t( length ), SYNC_FILE_RANGE_WRITE );
+   #else
+      ::msync( m_Map, length, MS_ASYNC );
+   #endif
+   }
+
+   ::munmap( m_Map, length );
+   m_Map = NULL;
+   m_MapStart = m_MapEnd = 0;
+}
+#endif
+
+
+} // namespace oneka
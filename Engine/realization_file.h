@@ -0,0 +1,153 @@
+//=============================================================================
+// realization_file.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef REALIZATION_FILE_H
+#define REALIZATION_FILE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "oneka_engine.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// A realization file is a binary matrix file (see matrix.h) of the 
+// (nSims x 6) realizations of one Engine run.  The RealizationHeader 
+// follows the MatrixFileHeader, and the data start at 
+// REALIZATION_FILE_OFFSET, a page boundary on common systems.
+//
+// LoadMatrix reads the realizations, and LoadRealizationHeader the rest.
+//-----------------------------------------------------------------------------
+struct RealizationHeader
+{
+   RealizationHeader();
+
+   char Magic[8];                // REALIZATION_FILE_MAGIC.
+   unsigned int Version;         // REALIZATION_FILE_VERSION.
+   unsigned int Reserved;
+
+   unsigned long long Seed;      // the realizations were drawn from
+   unsigned long long Stream;    // RandomStream( Seed, Stream ).
+
+   double Xo;                    // model origin.
+   double Yo;
+   double Mu[6];                 // conditional mean vector of the coefficients.
+   double Cov[6][6];             // conditional covariance matrix of the coefficients.
+};
+
+const char REALIZATION_FILE_MAGIC[8] = { 'O','N','E','K','A','R','L','Z' };
+const unsigned int REALIZATION_FILE_VERSION = 1;
+const long long REALIZATION_FILE_OFFSET = 4096;
+
+bool LoadRealizationHeader( const std::string& Name, RealizationHeader& R );
+
+//-----------------------------------------------------------------------------
+// RealizationFile
+//
+//    A RealizationSink that streams the realizations of one Engine run 
+//    into a realization file, as doubles or floats.
+//
+//    The file is grown Extent bytes at a time, and only the extent being
+//    filled is mapped, so the memory used does not grow with nSims.  When
+//    an extent is full its write-back is started, and proceeds while Engine
+//    generates the next chunks; End flushes the rest and fsyncs the file.
+//
+//    With NonTemporal set, and SSE2 available, the realizations are copied
+//    into the mapping with streaming stores, which bypass the cache.
+//
+//    A file that was begun but not completed -- the run failed, or was 
+//    cancelled -- is removed when the RealizationFile is destroyed.
+//
+// Notes:
+// o  A RealizationFile receives one run.
+// o  Where mmap is not available (Windows) the file is written with stdio.
+//-----------------------------------------------------------------------------
+class RealizationFile : public RealizationSink
+{
+public:
+   explicit RealizationFile( 
+      const std::string& Name, 
+      unsigned int Type = MATRIX_FLOAT64, 
+      std::size_t Extent = std::size_t( 64 ) << 20, 
+      bool NonTemporal = true );
+
+   ~RealizationFile();
+
+   bool Begin( const EngineReturn& S );
+   bool Write( int first, int n, const double* X );
+   bool End();
+
+   bool Complete() const;
+
+private:
+   RealizationFile( const RealizationFile& );
+   RealizationFile& operator=( const RealizationFile& );
+
+   bool Append( const char* p, std::size_t n );
+   bool Advance();
+   void Unmap( bool Sync );
+
+   std::string m_Name;
+   unsigned int m_Type;
+   std::size_t m_Extent;
+   bool m_NonTemporal;
+
+   bool m_Begun;
+   bool m_Complete;
+   long long m_Next;             // file offset of the next byte.
+   long long m_Size;             // file size when complete.
+   std::vector<float> m_Floats;  // a chunk narrowed for a FLOAT32 file.
+
+#ifdef _WIN32
+   std::FILE* m_File;
+#else
+   int m_fd;
+   char* m_Map;                  // the mapped extent ...
+   long long m_MapStart;         // ... from this page-aligned file offset ...
+   long long m_MapEnd;           // ... to here.
+#endif
+};
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // REALIZATION_FILE_H
@@ -0,0 +1,382 @@
+//=============================================================================
+// stagnation_points.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "stagnation_points.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace{
+   const double TWO_PI = 6.283185307179586476925287;
+
+   // Newton controls.  The convergence tolerance is relative to the initial
+   // distance between the well and its stagnation point.
+   const int    MAX_ITERATIONS = 50;
+   const int    MAX_HALVINGS   = 20;
+   const double TOLERANCE      = 1e-10;
+   const double SINGULAR       = 1e-14;
+
+   // Number of realizations processed together by one thread.
+   const int BLOCK = 256;
+
+   //--------------------------------------------------------------------------
+   // The wells and origin, as given to StagnationPoints.
+   //--------------------------------------------------------------------------
+   struct Wellfield
+   {
+      int W;
+      const double* Xw;
+      const double* Yw;
+      const double* Qw;
+      double Xo, Yo;
+   };
+
+   //--------------------------------------------------------------------------
+   // Gradient
+   //
+   //    Compute grad(Phi) and, if hxx is not NULL, the Hessian of Phi at n
+   //    points, where point i uses the coefficients a[i].  The well terms 
+   //    are accumulated well by well over the contiguous point arrays.
+   //
+   //       Phi_x  = 2A dX + C dY + D + sum c (x-Xw)/r^2
+   //       Phi_xx = 2A + sum c (r^2 - 2(x-Xw)^2)/r^4
+   //       Phi_xy = C  - sum c 2(x-Xw)(y-Yw)/r^4
+   //
+   //    and symmetrically in y, where c = Qw/(2 pi).
+   //--------------------------------------------------------------------------
+   void Gradient( 
+      const Wellfield& M, const double* const* a, int n, 
+      const double* x, const double* y, 
+      double* gx, double* gy, double* hxx, double* hxy, double* hyy )
+   {
+      for (int i=0; i<n; ++i)
+      {
+         double dX = x[i] - M.Xo;
+         double dY = y[i] - M.Yo;
+
+         gx[i] = 2*a[i][0]*dX + a[i][2]*dY + a[i][3];
+         gy[i] = 2*a[i][1]*dY + a[i][2]*dX + a[i][4];
+
+         if (hxx)
+         {
+            hxx[i] = 2*a[i][0];
+            hyy[i] = 2*a[i][1];
+            hxy[i] = a[i][2];
+         }
+      }
+
+      for (int w=0; w<M.W; ++w)
+      {
+         const double xw = M.Xw[w];
+         const double yw = M.Yw[w];
+         const double c  = M.Qw[w]/TWO_PI;
+
+         for (int i=0; i<n; ++i)
+         {
+            double dx = x[i] - xw;
+            double dy = y[i] - yw;
+            double r2 = dx*dx + dy*dy;
+
+            gx[i] += c*dx/r2;
+            gy[i] += c*dy/r2;
+
+            if (hxx)
+            {
+               double r4 = r2*r2;
+               hxx[i] += c*(r2 - 2*dx*dx)/r4;
+               hyy[i] += c*(r2 - 2*dy*dy)/r4;
+               hxy[i] -= c*2*dx*dy/r4;
+            }
+         }
+      }
+   }
+
+   //--------------------------------------------------------------------------
+   // SolveBlock
+   //
+   //    Find the stagnation point of well w for n realizations at once.
+   //--------------------------------------------------------------------------
+   void SolveBlock( 
+      const Wellfield& M, int w, const double* const* a, int n,
+      double* xs, double* ys, double* converged )
+   {
+      const double NaN = std::numeric_limits<double>::quiet_NaN();
+      const double xw = M.Xw[w];
+      const double yw = M.Yw[w];
+
+      std::vector<double> x( n ), y( n ), xt( n ), yt( n ), dx( n ), dy( n ), R( n );
+      std::vector<double> gx( n ), gy( n ), hxx( n ), hxy( n ), hyy( n ), g2( n );
+      std::vector<char> active( n ), searching( n );
+
+      // Initial guess: the stagnation point of the well in a uniform flow 
+      // equal to the discharge at the well from everything else,
+      //
+      //    s = Qw / (2 pi |q|),  downstream of the well along q.
+      for (int i=0; i<n; ++i)
+      {
+         double dX = xw - M.Xo;
+         double dY = yw - M.Yo;
+
+         double qx = -( 2*a[i][0]*dX + a[i][2]*dY + a[i][3] );
+         double qy = -( 2*a[i][1]*dY + a[i][2]*dX + a[i][4] );
+
+         for (int v=0; v<M.W; ++v)
+         {
+            if (v == w) continue;
+
+            double ex = xw - M.Xw[v];
+            double ey = yw - M.Yw[v];
+            double c  = M.Qw[v]/TWO_PI/(ex*ex + ey*ey);
+            qx -= c*ex;
+            qy -= c*ey;
+         }
+
+         double q = sqrt( qx*qx + qy*qy );
+         if (q > 0)
+         {
+            R[i] = M.Qw[w]/(TWO_PI*q);
+            x[i] = xw + R[i]*qx/q;
+            y[i] = yw + R[i]*qy/q;
+            active[i] = 1;
+         }
+         else
+         {
+            active[i] = 0;
+         }
+         converged[i] = 0;
+      }
+
+      for (int iteration=0; iteration<MAX_ITERATIONS; ++iteration)
+      {
+         Gradient( M, a, n, &x[0], &y[0], &gx[0], &gy[0], &hxx[0], &hxy[0], &hyy[0] );
+
+         // Newton directions, with a steepest-descent fallback on |g|^2 where
+         // the Jacobian is singular.  No step may cover more than half of 
+         // the distance to the well: this keeps the iterates away from the
+         // logarithmic singularity.
+         int nActive = 0;
+         for (int i=0; i<n; ++i)
+         {
+            searching[i] = 0;
+            if (!active[i]) continue;
+            ++nActive;
+
+            g2[i] = gx[i]*gx[i] + gy[i]*gy[i];
+
+            double det   = hxx[i]*hyy[i] - hxy[i]*hxy[i];
+            double scale = hxx[i]*hxx[i] + hyy[i]*hyy[i] + 2*hxy[i]*hxy[i];
+
+            if (fabs(det) > SINGULAR*scale)
+            {
+               dx[i] = -( hyy[i]*gx[i] - hxy[i]*gy[i])/det;
+               dy[i] = -(-hxy[i]*gx[i] + hxx[i]*gy[i])/det;
+            }
+            else
+            {
+               dx[i] = -( hxx[i]*gx[i] + hxy[i]*gy[i] );
+               dy[i] = -( hxy[i]*gx[i] + hyy[i]*gy[i] );
+
+               double d = sqrt( dx[i]*dx[i] + dy[i]*dy[i] );
+               if (d > 0)
+               {
+                  dx[i] *= 0.1*R[i]/d;
+                  dy[i] *= 0.1*R[i]/d;
+               }
+            }
+
+            double ex = x[i] - xw;
+            double ey = y[i] - yw;
+            double rw = sqrt( ex*ex + ey*ey );
+            double d  = sqrt( dx[i]*dx[i] + dy[i]*dy[i] );
+            if (d > 0.5*rw)
+            {
+               dx[i] *= 0.5*rw/d;
+               dy[i] *= 0.5*rw/d;
+               d = 0.5*rw;
+            }
+
+            if (d <= TOLERANCE*R[i])
+            {
+               x[i] += dx[i];
+               y[i] += dy[i];
+               converged[i] = 1;
+               active[i] = 0;
+               --nActive;
+            }
+            else
+            {
+               searching[i] = 1;
+            }
+         }
+
+         if (nActive == 0) break;
+
+         // Backtracking line search on |g|^2.  After MAX_HALVINGS the last
+         // (shortest) step is taken regardless.
+         for (int halving=0; halving<MAX_HALVINGS; ++halving)
+         {
+            int nSearching = 0;
+            for (int i=0; i<n; ++i)
+            {
+               xt[i] = x[i] + dx[i];
+               yt[i] = y[i] + dy[i];
+               nSearching += searching[i];
+            }
+            if (nSearching == 0) break;
+
+            Gradient( M, a, n, &xt[0], &yt[0], &gx[0], &gy[0], NULL, NULL, NULL );
+
+            for (int i=0; i<n; ++i)
+            {
+               if (!searching[i]) continue;
+
+               if (gx[i]*gx[i] + gy[i]*gy[i] < g2[i])
+               {
+                  searching[i] = 0;
+               }
+               else if (halving < MAX_HALVINGS-1)
+               {
+                  dx[i] *= 0.5;
+                  dy[i] *= 0.5;
+               }
+            }
+         }
+
+         for (int i=0; i<n; ++i)
+         {
+            if (!active[i]) continue;
+            x[i] += dx[i];
+            y[i] += dy[i];
+         }
+      }
+
+      for (int i=0; i<n; ++i)
+      {
+         xs[i] = converged[i] ? x[i] : NaN;
+         ys[i] = converged[i] ? y[i] : NaN;
+      }
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// StagnationPoints
+//
+// Arguments:
+//    W        number of discharge specified wells [#].
+//    Xw       (W x 1) array of well x-coordinates [L].
+//    Yw       (W x 1) array of well y-coordinates [L].
+//    Qw       (W x 1) array of well discharges [L^3/T].
+//
+//    Xo       x-coordinate of model origin [L].
+//    Yo       y-coordinate of model origin [L].
+//
+//    nSims    number of realizations [#].
+//    a        (nSims x 6) array of coefficient realizations [A,B,C,D,E,F].
+//
+//    Xs       on exit, the (nSims x W) stagnation point x-coordinates [L].
+//    Ys       on exit, the (nSims x W) stagnation point y-coordinates [L].
+//    Converged on exit, the (nSims x W) success flags.
+//
+// Notes:
+// o  The solver is a damped Newton iteration on grad(Phi) = 0 using the
+//    analytic Jacobian (the Hessian of Phi).  The initial guess is the 
+//    classical uniform-flow stagnation point, Qw/(2 pi |q|) downstream of 
+//    the well, where q is the discharge at the well from the quadratic and
+//    all other wells.
+//
+// o  Each Newton step is carried out for a block of realizations at once,
+//    so the arithmetic runs over contiguous arrays.  The blocks are spread
+//    over the available threads.
+//-----------------------------------------------------------------------------
+void StagnationPoints(
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo,
+   int nSims, const double* const* a,
+   Matrix& Xs, Matrix& Ys, Matrix& Converged )
+{
+   assert( W > 0 );
+   assert( nSims > 0 );
+
+   const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+   Wellfield M;
+   M.W = W;   M.Xw = Xw;   M.Yw = Yw;   M.Qw = Qw;
+   M.Xo = Xo; M.Yo = Yo;
+
+   Xs.Resize( nSims, W );
+   Ys.Resize( nSims, W );
+   Converged.Resize( nSims, W );
+
+   const int nBlocks = (nSims + BLOCK - 1)/BLOCK;
+
+   #pragma omp parallel for schedule(dynamic)
+   for (int b=0; b<nBlocks*W; ++b)
+   {
+      const int w  = b/nBlocks;
+      const int i0 = (b%nBlocks)*BLOCK;
+      const int n  = (i0 + BLOCK < nSims) ? BLOCK : nSims - i0;
+
+      std::vector<double> xs( n ), ys( n ), ok( n );
+
+      if (Qw[w] > 0)
+      {
+         SolveBlock( M, w, a+i0, n, &xs[0], &ys[0], &ok[0] );
+      }
+      else
+      {
+         for (int i=0; i<n; ++i)
+         {
+            xs[i] = NaN;
+            ys[i] = NaN;
+            ok[i] = 0;
+         }
+      }
+
+      for (int i=0; i<n; ++i)
+      {
+         Xs(i0+i,w) = xs[i];
+         Ys(i0+i,w) = ys[i];
+         Converged(i0+i,w) = ok[i];
+      }
+   }
+}
+
+
+} // namespace oneka
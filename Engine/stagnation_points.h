@@ -0,0 +1,64 @@
+//=============================================================================
+// stagnation_points.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef STAGNATION_POINTS_H
+#define STAGNATION_POINTS_H
+
+#include "matrix.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Locate the stagnation point, grad(Phi) = 0, associated with each pumping
+// well in every realization.
+//
+// On exit, Xs(i,w) and Ys(i,w) are the coordinates of the stagnation point
+// of well w in realization i, and Converged(i,w) is 1 if it was found and 0
+// if not (in which case the coordinates are NaN).  Injection wells, Qw <= 0,
+// have no stagnation point and are always marked as not converged.
+//-----------------------------------------------------------------------------
+void StagnationPoints(
+   int W, const double* Xw, const double* Yw, const double* Qw,
+   double Xo, double Yo,
+   int nSims, const double* const* a,
+   Matrix& Xs, Matrix& Ys, Matrix& Converged );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // STAGNATION_POINTS_H
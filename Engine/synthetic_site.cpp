@@ -0,0 +1,232 @@
+//=============================================================================
+// synthetic_site.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "synthetic_site.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "gaussian.h"
+#include "linear_systems.h"
+#include "matrix.h"
+#include "oneka_model.h"
+
+namespace oneka{
+
+namespace{
+
+   const double TWO_PI = 6.28318530717958647692;
+
+   //--------------------------------------------------------------------------
+   // A point uniform in the disk of radius r about (Xc,Yc).
+   //--------------------------------------------------------------------------
+   void Disk( RandomStream& R, double Xc, double Yc, double r, double& x, double& y )
+   {
+      double rho   = r * sqrt( R.Uniform() );
+      double theta = TWO_PI * R.Uniform();
+      x = Xc + rho*cos( theta );
+      y = Yc + rho*sin( theta );
+   }
+
+   //--------------------------------------------------------------------------
+   // The true discharge potential.
+   //--------------------------------------------------------------------------
+   double Potential( const SyntheticSpec& Spec, const EngineRequest& Site, double x, double y )
+   {
+      const double* a = Spec.a;
+      double dX = x - Spec.Xo;
+      double dY = y - Spec.Yo;
+
+      double Phi = a[0]*dX*dX + a[1]*dY*dY + a[2]*dX*dY + a[3]*dX + a[4]*dY + a[5];
+
+      if( !Site.Xw.empty() )
+         Phi += WellPotential( x, y, int( Site.Xw.size() ), &Site.Xw[0], &Site.Yw[0], &Site.Qw[0] );
+
+      return Phi;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// SyntheticSpec
+//-----------------------------------------------------------------------------
+SyntheticSpec::SyntheticSpec()
+:  k( 10 ), H( 20 ), Base( 0 ),
+   Xo( 0 ), Yo( 0 ),
+   W( 1 ), WellRadius( 250 ), Qtotal( 500 ),
+   P( 100 ), Radius( 1000 ), Noise( 0.05 ),
+   nSims( 1000 ),
+   Seed( 1 )
+{
+   a[0] = -2.5e-5;      // A and B: recharge of 1e-4 [L/T].
+   a[1] = -2.5e-5;
+   a[2] =  0;
+   a[3] = -0.2;         // D and E: regional discharge [L^2/T].
+   a[4] =  0.1;
+   a[5] =  4000;        // F: 30 m of head at the origin.
+}
+
+//-----------------------------------------------------------------------------
+// SyntheticSite
+//
+//    Build the synthetic site described by Spec.
+//-----------------------------------------------------------------------------
+void SyntheticSite( const SyntheticSpec& Spec, EngineRequest& Site )
+{
+   RandomStream R( Spec.Seed, SYNTHETIC_STREAM );
+
+   Site = EngineRequest();
+   Site.k    = Spec.k;
+   Site.H    = Spec.H;
+   Site.Base = Spec.Base;
+   Site.Xo   = Spec.Xo;
+   Site.Yo   = Spec.Yo;
+   Site.nSims  = Spec.nSims;
+   Site.Seed   = Spec.Seed;
+   Site.Stream = 0;
+
+   // The wells.
+   Site.Xw.resize( Spec.W );
+   Site.Yw.resize( Spec.W );
+   Site.Qw.assign( Spec.W, Spec.W > 0 ? Spec.Qtotal/Spec.W : 0.0 );
+
+   for( int w = 0; w < Spec.W; ++w )
+      Disk( R, Spec.Xo, Spec.Yo, Spec.WellRadius, Site.Xw[w], Site.Yw[w] );
+
+   // The piezometers, with noisy heads.  A location where the aquifer
+   // would be dry is drawn again, up to SYNTHETIC_MAX_DRAWS times.
+   Site.Xp.resize( Spec.P );
+   Site.Yp.resize( Spec.P );
+   Site.Ep.resize( Spec.P );
+   Site.Sp.assign( Spec.P, Spec.Noise );
+
+   for( int p = 0; p < Spec.P; ++p )
+   {
+      double x, y, Phi;
+      int draws = 0;
+      do
+      {
+         if( draws++ == SYNTHETIC_MAX_DRAWS )
+         {
+            char message[256];
+            std::sprintf( message, 
+               "SyntheticSite: no wet location in %d draws (Seed %llu, Xo %g, Yo %g, Radius %g, k %g, H %g, F %g, W %d, Qtotal %g)",
+               SYNTHETIC_MAX_DRAWS, Spec.Seed, Spec.Xo, Spec.Yo, Spec.Radius, Spec.k, Spec.H, Spec.a[5], Spec.W, Spec.Qtotal );
+            throw std::runtime_error( message );
+         }
+
+         Disk( R, Spec.Xo, Spec.Yo, Spec.Radius, x, y );
+         Phi = Potential( Spec, Site, x, y );
+      }
+      while( !(Phi > 0) );
+
+      Site.Xp[p] = x;
+      Site.Yp[p] = y;
+      Site.Ep[p] = PhiToHead( Phi, Spec.k, Spec.H, Spec.Base ) + Spec.Noise * R.Gaussian();
+   }
+}
+
+//-----------------------------------------------------------------------------
+// SyntheticHead
+//
+//    Return the true head at (x,y), without noise.
+//-----------------------------------------------------------------------------
+double SyntheticHead( const SyntheticSpec& Spec, const EngineRequest& Site, double x, double y )
+{
+   return PhiToHead( Potential( Spec, Site, x, y ), Spec.k, Spec.H, Spec.Base );
+}
+
+//-----------------------------------------------------------------------------
+// SyntheticAccuracy
+//-----------------------------------------------------------------------------
+SyntheticAccuracy::SyntheticAccuracy()
+:  MaxAbsError( 0 ), MaxZ( 0 ), Mahalanobis( 0 ), SampleZ( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+// Accuracy
+//
+//    Compare the Engine result S for a synthetic site with the true 
+//    coefficients.  The Mahalanobis distance is -1 if S.Cov is singular.
+//-----------------------------------------------------------------------------
+SyntheticAccuracy Accuracy( const SyntheticSpec& Spec, const EngineReturn& S )
+{
+   SyntheticAccuracy A;
+
+   double e[6];
+   for( int i = 0; i < 6; ++i )
+   {
+      e[i] = S.Mu[i] - Spec.a[i];
+      A.MaxAbsError = std::max( A.MaxAbsError, fabs( e[i] ) );
+      if( S.Cov[i][i] > 0 )
+         A.MaxZ = std::max( A.MaxZ, fabs( e[i] )/sqrt( S.Cov[i][i] ) );
+   }
+
+   Matrix Cov( 6, 6 ), Cinv;
+   for( int i = 0; i < 6; ++i )
+      for( int j = 0; j < 6; ++j )
+         Cov(i,j) = S.Cov[i][j];
+
+   if( RSPDInv( Cov, Cinv ) )
+   {
+      for( int i = 0; i < 6; ++i )
+         for( int j = 0; j < 6; ++j )
+            A.Mahalanobis += e[i] * Cinv(i,j) * e[j];
+   }
+   else
+      A.Mahalanobis = -1;
+
+   // The realizations should be centered on Mu.
+   if( S.a != NULL && S.nSims > 0 )
+   {
+      for( int i = 0; i < 6; ++i )
+      {
+         double sum = 0;
+         for( int n = 0; n < S.nSims; ++n )
+            sum += S.a[n][i];
+
+         if( S.Cov[i][i] > 0 )
+            A.SampleZ = std::max( A.SampleZ, fabs( sum/S.nSims - S.Mu[i] )/sqrt( S.Cov[i][i]/S.nSims ) );
+      }
+   }
+
+   return A;
+}
+
+
+} // namespace oneka
@@ -0,0 +1,117 @@
+//=============================================================================
+// synthetic_site.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef SYNTHETIC_SITE_H
+#define SYNTHETIC_SITE_H
+
+#include "engine_protocol.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The description of a synthetic site.
+//
+// The heads are computed from a known coefficient vector "a" with the
+// Oneka model (see oneka_model.h), and perturbed by independent Normal
+// errors with standard deviation Noise.  The defaults describe a confined
+// aquifer, 30 m of head over a 20 m thickness, with areal recharge, a 
+// regional gradient of about 0.001, and one pumping well.
+//-----------------------------------------------------------------------------
+struct SyntheticSpec
+{
+   SyntheticSpec();
+
+   double a[6];            // true coefficients [A..F] about (Xo,Yo).
+
+   double k;               // hydraulic conductivity [L/T].
+   double H;               // aquifer thickness [L].
+   double Base;            // elevation of the aquifer base [L].
+   double Xo;              // x-coordinate of the site center and model origin [L].
+   double Yo;              // y-coordinate of the site center and model origin [L].
+
+   int W;                  // number of wells [#].
+   double WellRadius;      // wells are uniform in a disk of this radius [L].
+   double Qtotal;          // total discharge, shared equally by the wells [L^3/T].
+
+   int P;                  // number of piezometers [#].
+   double Radius;          // piezometers are uniform in a disk of this radius [L].
+   double Noise;           // standard deviation of the head errors [L]; > 0.
+
+   int nSims;              // number of realizations requested of Engine [#].
+   unsigned long long Seed;   // seed for the site and for Engine.
+};
+
+//-----------------------------------------------------------------------------
+// Build the site as an EngineRequest; Site.Input() is ready for Engine.
+//
+// The site is a deterministic function of Spec: the geometry and the 
+// errors are drawn from RandomStream( Seed, SYNTHETIC_STREAM ), and the 
+// request asks Engine for RandomStream( Seed, 0 ).
+//
+// Notes:
+// o  Piezometers are not placed where the true potential is dry.  If 
+//    SYNTHETIC_MAX_DRAWS draws in a row are all dry, the site is mostly dry
+//    and SyntheticSite throws std::runtime_error, naming the parameters.
+// o  The work is O(P*W), as it is for Engine.
+//-----------------------------------------------------------------------------
+const unsigned long long SYNTHETIC_STREAM = ~0ULL;
+const int SYNTHETIC_MAX_DRAWS = 10000;
+
+void SyntheticSite( const SyntheticSpec& Spec, EngineRequest& Site );
+
+double SyntheticHead( const SyntheticSpec& Spec, const EngineRequest& Site, double x, double y );
+
+//-----------------------------------------------------------------------------
+// The accuracy of an Engine result against the true coefficients.
+//-----------------------------------------------------------------------------
+struct SyntheticAccuracy
+{
+   SyntheticAccuracy();
+
+   double MaxAbsError;     // max |Mu_i - a_i|.
+   double MaxZ;            // max |Mu_i - a_i| / sqrt(Cov_ii).
+   double Mahalanobis;     // (Mu-a)' inv(Cov) (Mu-a); chi-square(6) if the fit is consistent.
+   double SampleZ;         // max |mean_i - Mu_i| / sqrt(Cov_ii/nSims) over the realizations.
+};
+
+SyntheticAccuracy Accuracy( const SyntheticSpec& Spec, const EngineReturn& S );
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // SYNTHETIC_SITE_H
@@ -0,0 +1,244 @@
+//=============================================================================
+// trace.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "trace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+#include "now.h"
+
+namespace oneka{
+
+namespace{
+
+   struct Event
+   {
+      const char* Name;
+      double Begin;
+      double End;
+   };
+
+   //--------------------------------------------------------------------------
+   // The events of one thread.  Only the owning thread writes to it.
+   //--------------------------------------------------------------------------
+   struct TraceBuffer
+   {
+      TraceBuffer( int Id ) : Id( Id ), Name( NULL ), Events( TRACE_BUFFER_EVENTS ), Next( 0 ), Wrapped( false ) {}
+
+      int Id;
+      const char* Name;
+      std::vector<Event> Events;
+      int Next;
+      bool Wrapped;
+   };
+
+   // All of the buffers, in order of creation.  They are never freed, so a
+   // thread's events can be written after it has exited.
+   std::vector<TraceBuffer*> g_Buffers;
+
+   ONEKA_THREAD_LOCAL TraceBuffer* t_Buffer = NULL;
+
+   // Time stamps are written relative to the last TraceClear or, before
+   // the first TraceClear, to the creation of the first buffer.  Set and 
+   // read under the lock.
+   double g_Origin = 0;
+   bool g_HasOrigin = false;
+
+   TraceBuffer* ThreadBuffer()
+   {
+      if (t_Buffer == NULL)
+      {
+         #pragma omp critical( oneka_trace )
+         {
+            if (!g_HasOrigin)
+            {
+               g_Origin = WallClock();
+               g_HasOrigin = true;
+            }
+            t_Buffer = new TraceBuffer( int( g_Buffers.size() ) + 1 );
+            g_Buffers.push_back( t_Buffer );
+         }
+      }
+      return t_Buffer;
+   }
+
+   void WriteString( std::ostream& os, const char* s )
+   {
+      os << '"';
+      for (; *s; ++s)
+      {
+         if (*s == '"' || *s == '\\') os << '\\';
+         os << *s;
+      }
+      os << '"';
+   }
+}
+
+//-----------------------------------------------------------------------------
+// TraceEvent
+//
+//    Record a completed event on the calling thread.  Begin and End are 
+//    WallClock times.
+//-----------------------------------------------------------------------------
+void TraceEvent( const char* Name, double Begin, double End )
+{
+   TraceBuffer* B = ThreadBuffer();
+
+   Event& e = B->Events[B->Next];
+   e.Name = Name;
+   e.Begin = Begin;
+   e.End = End;
+
+   if (++B->Next == TRACE_BUFFER_EVENTS)
+   {
+      B->Next = 0;
+      B->Wrapped = true;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// TraceThreadName
+//
+//    Name the calling thread in the trace.
+//-----------------------------------------------------------------------------
+void TraceThreadName( const char* Name )
+{
+   ThreadBuffer()->Name = Name;
+}
+
+//-----------------------------------------------------------------------------
+// TraceClear
+//
+//    Discard the recorded events of all threads, and start the time stamps
+//    of the next trace from now.
+//-----------------------------------------------------------------------------
+void TraceClear()
+{
+   #pragma omp critical( oneka_trace )
+   {
+      for (std::size_t i=0; i<g_Buffers.size(); ++i)
+      {
+         g_Buffers[i]->Next = 0;
+         g_Buffers[i]->Wrapped = false;
+      }
+      g_Origin = WallClock();
+      g_HasOrigin = true;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// TraceWriteChrome
+//
+//    Write the recorded events as a Chrome trace: complete ("X") events 
+//    with microsecond time stamps, one "tid" per recording thread.
+//-----------------------------------------------------------------------------
+void TraceWriteChrome( std::ostream& os )
+{
+   bool first = true;
+
+   os << "{\"traceEvents\":[";
+   os << std::fixed << std::setprecision( 3 );
+
+   #pragma omp critical( oneka_trace )
+   for (std::size_t b=0; b<g_Buffers.size(); ++b)
+   {
+      const TraceBuffer& B = *g_Buffers[b];
+      const double origin = g_Origin;
+
+      if (B.Name != NULL)
+      {
+         os << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << B.Id << ",\"args\":{\"name\":";
+         WriteString( os, B.Name );
+         os << "}}";
+         first = false;
+      }
+
+      const int n = B.Wrapped ? TRACE_BUFFER_EVENTS : B.Next;
+      const int start = B.Wrapped ? B.Next : 0;
+
+      for (int i=0; i<n; ++i)
+      {
+         const Event& e = B.Events[(start + i) % TRACE_BUFFER_EVENTS];
+
+         os << (first ? "\n" : ",\n") << "{\"name\":";
+         WriteString( os, e.Name );
+         os << ",\"cat\":\"oneka\",\"ph\":\"X\",\"pid\":1,\"tid\":" << B.Id
+            << ",\"ts\":" << 1e6*(e.Begin - origin)
+            << ",\"dur\":" << 1e6*(e.End - e.Begin) << "}";
+         first = false;
+      }
+   }
+
+   os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+//-----------------------------------------------------------------------------
+bool TraceWriteChrome( const std::string& FileName )
+{
+   std::ofstream os( FileName.c_str() );
+   if( !os ) return false;
+
+   TraceWriteChrome( os );
+   return bool( os );
+}
+
+//=============================================================================
+// TraceScope
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// The thread's buffer, and so the origin, is in place before the clock is
+// read: the first event does not begin before the origin, and the lock 
+// taken for a thread's first event is not part of its duration.
+//-----------------------------------------------------------------------------
+TraceScope::TraceScope( const char* Name )
+:  m_Name( Name )
+{
+   ThreadBuffer();
+   m_Begin = WallClock();
+}
+
+//-----------------------------------------------------------------------------
+TraceScope::~TraceScope()
+{
+   TraceEvent( m_Name, m_Begin, WallClock() );
+}
+
+
+} // namespace oneka
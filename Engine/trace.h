@@ -0,0 +1,118 @@
+//=============================================================================
+// trace.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iosfwd>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// Thread-local storage class, for compilers without C++11 thread_local.
+//-----------------------------------------------------------------------------
+#if defined(_MSC_VER)
+#define ONEKA_THREAD_LOCAL __declspec( thread )
+#else
+#define ONEKA_THREAD_LOCAL __thread
+#endif
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Timeline tracing
+//
+//    Scoped events -- the Engine phases, the matrix kernels, the random 
+//    number fills, and the tasks of the thread pools -- are recorded into
+//    a ring buffer per thread, and written as Chrome trace JSON (viewable
+//    in chrome://tracing or Perfetto).
+//
+//    Tracing is compiled out unless ONEKA_TRACING is defined: the macros 
+//    expand to nothing, and TraceWriteChrome writes an empty trace.  When
+//    compiled in, recording an event costs two clock reads and a store; 
+//    there is no locking except when a thread records its first event.
+//
+//    Event names must be string literals (they are stored as pointers).
+//    Each thread keeps its most recent TRACE_BUFFER_EVENTS events.  The
+//    buffers should be written or cleared only while no thread is 
+//    recording.
+//
+//    Time stamps are relative to the last TraceClear, so call it to start
+//    a trace; without it they are relative to the first event recorded.
+//-----------------------------------------------------------------------------
+const int TRACE_BUFFER_EVENTS = 1 << 16;
+
+void TraceEvent( const char* Name, double Begin, double End );
+void TraceThreadName( const char* Name );
+
+void TraceClear();
+void TraceWriteChrome( std::ostream& os );
+bool TraceWriteChrome( const std::string& FileName );
+
+//-----------------------------------------------------------------------------
+// Records one event spanning the lifetime of the object.
+//-----------------------------------------------------------------------------
+class TraceScope
+{
+public:
+   explicit TraceScope( const char* Name );
+   ~TraceScope();
+
+private:
+   TraceScope( const TraceScope& );
+   TraceScope& operator=( const TraceScope& );
+
+   const char* m_Name;
+   double m_Begin;
+};
+
+} // namespace oneka
+
+#define ONEKA_TRACE_CONCAT_( a, b ) a##b
+#define ONEKA_TRACE_CONCAT( a, b ) ONEKA_TRACE_CONCAT_( a, b )
+
+#ifdef ONEKA_TRACING
+#define ONEKA_TRACE_SCOPE( name ) oneka::TraceScope ONEKA_TRACE_CONCAT( oneka_trace_, __LINE__ )( name )
+#define ONEKA_TRACE_EVENT( name, begin, end ) oneka::TraceEvent( name, begin, end )
+#define ONEKA_TRACE_THREAD( name ) oneka::TraceThreadName( name )
+#else
+#define ONEKA_TRACE_SCOPE( name ) ((void)0)
+#define ONEKA_TRACE_EVENT( name, begin, end ) ((void)0)
+#define ONEKA_TRACE_THREAD( name ) ((void)0)
+#endif
+
+//=============================================================================
+#endif  // TRACE_H
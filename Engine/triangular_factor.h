@@ -0,0 +1,160 @@
+//=============================================================================
+// triangular_factor.h
+//
+//    The Givens update and solution of a small upper triangular factor.
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef TRIANGULAR_FACTOR_H
+#define TRIANGULAR_FACTOR_H
+
+#include <cmath>
+#include <limits>
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// An (N x N) upper triangular factor R of a least squares problem, with the
+// rotated right-hand-side z, built one equation at a time: after inserting
+// the equations A x = b, R'R = A'A and R'z = A'b.  N is a compile-time 
+// constant, so the loops use fixed-size arrays.
+//
+// Used by FittedModel (N = 6) and by FitBasis (any basis list).
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// GivensInsert
+//
+//    Rotate the equation row' x = rhs into (R, z) using Givens rotations.
+//-----------------------------------------------------------------------------
+template< int N >
+void GivensInsert( double R[N][N], double z[N], const double* row, double rhs )
+{
+   double x[N];
+   for (int j=0; j<N; ++j) x[j] = row[j];
+   double beta = rhs;
+
+   for (int k=0; k<N; ++k)
+   {
+      if( x[k] == 0 ) continue;
+
+      double r = sqrt( R[k][k]*R[k][k] + x[k]*x[k] );
+      double c = R[k][k]/r;
+      double s = x[k]/r;
+
+      R[k][k] = r;
+      for (int j=k+1; j<N; ++j)
+      {
+         double t = c*R[k][j] + s*x[j];
+         x[j]     = c*x[j] - s*R[k][j];
+         R[k][j]  = t;
+      }
+
+      double t = c*z[k] + s*beta;
+      beta     = c*beta - s*z[k];
+      z[k]     = t;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// TriangularSolve
+//
+//    Compute the least squares solution and its covariance from (R, z):
+//
+//       R Mu = z,     Cov = inv(R'R) = inv(R) inv(R)'.
+//
+//    Returns false, and leaves Mu and Cov undefined, if R is rank deficient:
+//    if a diagonal element is not larger than N eps max|R(i,j)|.
+//-----------------------------------------------------------------------------
+template< int N >
+bool TriangularSolve( const double R[N][N], const double z[N], double Mu[N], double Cov[N][N] )
+{
+   // Check for rank deficiency.
+   double Rmax = 0;
+   for (int i=0; i<N; ++i)
+      for (int j=i; j<N; ++j)
+         if( fabs(R[i][j]) > Rmax ) Rmax = fabs(R[i][j]);
+
+   for (int i=0; i<N; ++i)
+      if( !(fabs(R[i][i]) > Rmax * N * std::numeric_limits<double>::epsilon()) ) 
+         return false;
+
+   // Back substitution for the mean.
+   for (int i=N-1; i>=0; --i)
+   {
+      double sum = z[i];
+      for (int j=i+1; j<N; ++j)
+         sum -= R[i][j]*Mu[j];
+      Mu[i] = sum/R[i][i];
+   }
+
+   // Invert the upper triangular factor, column by column.
+   double Rinv[N][N];
+   for (int j=0; j<N; ++j)
+   {
+      for (int i=j+1; i<N; ++i)
+         Rinv[i][j] = 0;
+
+      Rinv[j][j] = 1/R[j][j];
+      for (int i=j-1; i>=0; --i)
+      {
+         double sum = 0;
+         for (int l=i+1; l<=j; ++l)
+            sum += R[i][l]*Rinv[l][j];
+         Rinv[i][j] = -sum/R[i][i];
+      }
+   }
+
+   // Cov = inv(R) inv(R)'.
+   for (int i=0; i<N; ++i)
+   {
+      for (int j=i; j<N; ++j)
+      {
+         double sum = 0;
+         for (int l=j; l<N; ++l)
+            sum += Rinv[i][l]*Rinv[j][l];
+         Cov[i][j] = sum;
+         Cov[j][i] = sum;
+      }
+   }
+
+   return true;
+}
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // TRIANGULAR_FACTOR_H
@@ -0,0 +1,174 @@
+//=============================================================================
+// engine_client.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "engine_client.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+EngineClient::EngineClient()
+:  m_fd( -1 ), m_Id( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+EngineClient::~EngineClient()
+{
+   Close();
+}
+
+//-----------------------------------------------------------------------------
+bool EngineClient::Connect( const std::string& Path )
+{
+   Close();
+
+   sockaddr_un addr;
+   std::memset( &addr, 0, sizeof(addr) );
+   addr.sun_family = AF_UNIX;
+   if( Path.size() >= sizeof(addr.sun_path) ) return false;
+   std::strcpy( addr.sun_path, Path.c_str() );
+
+   m_fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+   if (m_fd < 0) return false;
+
+   if( ::connect( m_fd, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) != 0 )
+   {
+      Close();
+      return false;
+   }
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+void EngineClient::Close()
+{
+   if (m_fd >= 0) 
+      ::close( m_fd );
+   m_fd = -1;
+}
+
+//-----------------------------------------------------------------------------
+// EngineClient::Call
+//
+//    Send one request and decode its response.
+//
+// Notes:
+// o  A transport failure closes the connection and throws 
+//    Exception_ServiceFailure; a singular system throws 
+//    Exception_SingularSystem, exactly as Engine does.
+//
+// o  Realizations sent through shared memory are mapped into A from the
+//    descriptor passed with the response, which is then closed.
+//
+// o  Options.UseSeed is not part of a request, so a site that sets it is 
+//    rejected here with std::invalid_argument, as Engine( In ) would.
+//-----------------------------------------------------------------------------
+EngineReturn EngineClient::Call( const EngineInput& In, MappedRealizations& A )
+{
+   if( In.Options.UseSeed ) 
+      throw std::invalid_argument( "EngineInput: set Seed and Stream, not Options.UseSeed" );
+   if( !Connected() ) throw Exception_ServiceFailure();
+
+   std::vector<char> Body;
+   EncodeRequest( In, Body );
+
+   const unsigned int id = ++m_Id;
+   MessageHeader Header;
+   int Passed = -1;
+   bool ok = WriteMessage( m_fd, MESSAGE_REQUEST, id, Body ) && 
+      ReadMessage( m_fd, Header, Body, &Passed ) &&
+      Header.Type == MESSAGE_RESPONSE && Header.Id == id;
+
+   int Status;
+   EngineReturn S;
+   std::string Segment;
+   if (ok)
+      ok = DecodeResponse( Body.empty() ? NULL : &Body[0], Body.size(), Status, S, Segment );
+   if (ok && !Segment.empty())
+      ok = A.Map( Passed, S.nSims );
+
+   if (Passed >= 0) 
+      ::close( Passed );
+
+   if (!ok)
+   {
+      Close();
+      throw Exception_ServiceFailure();
+   }
+
+   if (Status == ENGINE_SINGULAR) throw Exception_SingularSystem();
+   if (Status != ENGINE_OK) throw Exception_ServiceFailure();
+
+   return S;
+}
+
+//-----------------------------------------------------------------------------
+// EngineClient::Engine
+//-----------------------------------------------------------------------------
+EngineReturn EngineClient::Engine( const EngineInput& In )
+{
+   MappedRealizations A;
+   EngineReturn S = Engine( In, A );
+
+   if (S.a == NULL && A.nSims() > 0)
+   {
+      S.a = new double*[S.nSims];
+      for (int i=0; i<S.nSims; ++i)
+      {
+         S.a[i] = new double[6];
+         std::memcpy( S.a[i], A.Row(i), 6*sizeof(double) );
+      }
+   }
+   return S;
+}
+
+//-----------------------------------------------------------------------------
+EngineReturn EngineClient::Engine( const EngineInput& In, MappedRealizations& A )
+{
+   A.Unmap();
+   return Call( In, A );
+}
+
+
+} // namespace oneka
@@ -0,0 +1,91 @@
+//=============================================================================
+// engine_client.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef ENGINE_CLIENT_H
+#define ENGINE_CLIENT_H
+
+#include <string>
+
+#include "service_io.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// A connection to the local Engine service.
+//
+// Each call sends one request and waits for its response; the service 
+// coalesces the requests of all of its clients into batches.  A client 
+// is not thread safe: use one client per thread.
+//-----------------------------------------------------------------------------
+class EngineClient
+{
+public:
+   EngineClient();
+   ~EngineClient();
+
+   bool Connect( const std::string& Path );
+   void Close();
+   bool Connected() const { return m_fd >= 0; }
+
+   // As Engine( In ): the caller owns the realizations in the result.
+   EngineReturn Engine( const EngineInput& In );
+
+   // As above, except that realizations sent through shared memory are 
+   // mapped into A and read in place, and the result's "a" is NULL.  
+   // Realizations sent inline are returned in "a" as usual.
+   EngineReturn Engine( const EngineInput& In, MappedRealizations& A );
+
+private:
+   EngineClient( const EngineClient& );
+   EngineClient& operator=( const EngineClient& );
+
+   EngineReturn Call( const EngineInput& In, MappedRealizations& A );
+
+   int m_fd;
+   unsigned int m_Id;
+};
+
+//-----------------------------------------------------------------------------
+// Exception classes.
+//-----------------------------------------------------------------------------
+class Exception_ServiceFailure{};
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // ENGINE_CLIENT_H
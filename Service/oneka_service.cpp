@@ -0,0 +1,370 @@
+//=============================================================================
+// oneka_service.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+// A local Engine service.
+//
+// usage:
+//    oneka_service [-t threads] [-w window_us] [-b max_batch] [-z shm_bytes] [-T trace] socket
+//
+// The service listens on the Unix domain socket "socket" for Engine 
+// requests (see engine_protocol.h).  Each connection has a reader thread
+// that decodes requests onto one shared queue.  A single dispatcher takes
+// the requests off the queue in batches -- waiting up to window_us after
+// the first request for others to arrive, up to max_batch requests -- and
+// runs each batch with EngineLanes on one OpenMP thread team.  
+//
+// Results whose realizations occupy at least shm_bytes are returned 
+// through a shared memory segment, whose descriptor is passed with the 
+// response; smaller results are sent inline.
+//
+// With -T, a Chrome trace is written when the service stops; it holds 
+// events only if the service was built with ONEKA_TRACING (make TRACE=1).
+//-----------------------------------------------------------------------------
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../Engine/lane_engine.h"
+#include "../Engine/trace.h"
+#include "../Engine/version.h"
+#include "service_io.h"
+
+using namespace oneka;
+
+namespace{
+
+   volatile std::sig_atomic_t g_Stop = 0;
+
+   void OnSignal( int ) 
+   { 
+      g_Stop = 1; 
+   }
+
+   struct ServiceOptions
+   {
+      ServiceOptions() : nThreads( 0 ), WindowUs( 500 ), MaxBatch( 256 ), ShmBytes( 1 << 20 ) {}
+
+      std::string Path;
+      std::string Trace;
+      int nThreads;
+      int WindowUs;
+      int MaxBatch;
+      long ShmBytes;
+   };
+
+   //--------------------------------------------------------------------------
+   // One client connection.  The socket is closed when the last reference 
+   // -- the reader thread, or a request still in the queue -- is dropped.
+   //--------------------------------------------------------------------------
+   struct Connection
+   {
+      explicit Connection( int fd ) : fd( fd ) {}
+      ~Connection() { ::close( fd ); }
+
+      int fd;
+      std::mutex write_mutex;
+   };
+
+   struct Pending
+   {
+      std::shared_ptr<Connection> conn;
+      unsigned int id;
+      EngineRequest request;
+   };
+
+   //--------------------------------------------------------------------------
+   // Send one response, passing the descriptor of its segment, if any, 
+   // along with it.  The service's copy of the descriptor is closed: once 
+   // the client has it, the segment is the client's, and if the response 
+   // is never read the kernel releases it with the connection.
+   //--------------------------------------------------------------------------
+   void Respond( Connection& conn, unsigned int id, int Status, const EngineReturn& S, 
+      const std::string& Segment = std::string(), int SegmentFd = -1 )
+   {
+      std::vector<char> Body;
+      EncodeResponse( Status, S, Segment, Body );
+
+      {
+         std::lock_guard<std::mutex> lock( conn.write_mutex );
+         WriteMessage( conn.fd, MESSAGE_RESPONSE, id, Body, SegmentFd );
+      }
+
+      if (SegmentFd >= 0)
+         ::close( SegmentFd );
+   }
+
+   //--------------------------------------------------------------------------
+   // Dispatcher
+   //
+   //    Coalesces the queued requests of all connections into batches.
+   //--------------------------------------------------------------------------
+   class Dispatcher
+   {
+   public:
+      explicit Dispatcher( const ServiceOptions& Options ) : m_Options( Options ), m_Stop( false ) {}
+
+      void Push( Pending&& p )
+      {
+         {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_Queue.push_back( std::move( p ) );
+         }
+         m_Ready.notify_one();
+      }
+
+      void Stop()
+      {
+         {
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_Stop = true;
+         }
+         m_Ready.notify_all();
+      }
+
+      void Run()
+      {
+         ONEKA_TRACE_THREAD( "dispatcher" );
+         const std::size_t max_batch = std::size_t( m_Options.MaxBatch );
+
+         for(;;)
+         {
+            std::vector<Pending> Batch;
+            {
+               std::unique_lock<std::mutex> lock( m_Mutex );
+               m_Ready.wait( lock, [this]{ return m_Stop || !m_Queue.empty(); } );
+               if (m_Stop && m_Queue.empty()) return;
+
+               // Give concurrent requests a short window to join the batch.
+               const std::chrono::steady_clock::time_point deadline = 
+                  std::chrono::steady_clock::now() + std::chrono::microseconds( m_Options.WindowUs );
+               while (!m_Stop && m_Queue.size() < max_batch && 
+                      m_Ready.wait_until( lock, deadline ) != std::cv_status::timeout) {}
+
+               const std::size_t n = std::min( m_Queue.size(), max_batch );
+               Batch.reserve( n );
+               for (std::size_t i=0; i<n; ++i)
+               {
+                  Batch.push_back( std::move( m_Queue.front() ) );
+                  m_Queue.pop_front();
+               }
+            }
+            Execute( Batch );
+         }
+      }
+
+   private:
+      void Execute( std::vector<Pending>& Batch )
+      {
+         ONEKA_TRACE_SCOPE( "Service batch" );
+         const int n = int( Batch.size() );
+
+         std::vector<EngineInput> Inputs( n );
+         for (int i=0; i<n; ++i)
+            Inputs[i] = Batch[i].request.Input();
+
+         std::vector<EngineReturn> Results;
+         std::vector<int> Status;
+         EngineLanes( Inputs, Results, Status, m_Options.nThreads );
+
+         for (int i=0; i<n; ++i)
+         {
+            EngineReturn& S = Results[i];
+
+            std::string Segment;
+            int SegmentFd = -1;
+            if (Status[i] == ENGINE_OK && 6.0*sizeof(double)*S.nSims >= double( m_Options.ShmBytes ))
+               SegmentFd = PublishRealizations( S, Segment );
+
+            Respond( *Batch[i].conn, Batch[i].id, Status[i], S, Segment, SegmentFd );
+
+            if (S.a != NULL)
+            {
+               for (int j=0; j<S.nSims; ++j)
+                  delete [] S.a[j];
+               delete [] S.a;
+               S.a = NULL;
+            }
+         }
+      }
+
+      const ServiceOptions& m_Options;
+
+      std::mutex m_Mutex;
+      std::condition_variable m_Ready;
+      std::deque<Pending> m_Queue;
+      bool m_Stop;
+   };
+
+   //--------------------------------------------------------------------------
+   // Read the requests of one connection until it closes.  Malformed 
+   // requests are answered at once; a malformed frame drops the connection.
+   //--------------------------------------------------------------------------
+   void Serve( std::shared_ptr<Connection> conn, Dispatcher* D )
+   {
+      MessageHeader Header;
+      std::vector<char> Body;
+
+      while( ReadMessage( conn->fd, Header, Body ) && Header.Type == MESSAGE_REQUEST )
+      {
+         Pending p;
+         p.conn = conn;
+         p.id = Header.Id;
+
+         if( DecodeRequest( Body.empty() ? NULL : &Body[0], Body.size(), p.request ) )
+            D->Push( std::move( p ) );
+         else
+            Respond( *conn, Header.Id, ENGINE_BAD_REQUEST, EngineReturn() );
+      }
+
+      ::shutdown( conn->fd, SHUT_RD );
+   }
+
+   //--------------------------------------------------------------------------
+   int Listen( const std::string& Path )
+   {
+      sockaddr_un addr;
+      std::memset( &addr, 0, sizeof(addr) );
+      addr.sun_family = AF_UNIX;
+      if( Path.size() >= sizeof(addr.sun_path) ) return -1;
+      std::strcpy( addr.sun_path, Path.c_str() );
+
+      int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+      if (fd < 0) return -1;
+
+      ::unlink( Path.c_str() );
+      if( ::bind( fd, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) != 0 || 
+          ::listen( fd, 64 ) != 0 )
+      {
+         ::close( fd );
+         return -1;
+      }
+      return fd;
+   }
+
+   //--------------------------------------------------------------------------
+   bool ParseOptions( int argc, char* argv[], ServiceOptions& Options )
+   {
+      int c;
+      while ((c = ::getopt( argc, argv, "t:w:b:z:T:" )) != -1)
+      {
+         switch (c)
+         {
+         case 't': Options.nThreads = std::atoi( optarg ); break;
+         case 'w': Options.WindowUs = std::atoi( optarg ); break;
+         case 'b': Options.MaxBatch = std::atoi( optarg ); break;
+         case 'z': Options.ShmBytes = std::atol( optarg ); break;
+         case 'T': Options.Trace = optarg; break;
+         default:  return false;
+         }
+      }
+      if (optind != argc - 1) return false;
+
+      Options.Path = argv[optind];
+      return Options.WindowUs >= 0 && Options.MaxBatch > 0;
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+   static ServiceOptions Options;
+   if( !ParseOptions( argc, argv, Options ) )
+   {
+      std::fprintf( stderr, "usage: %s [-t threads] [-w window_us] [-b max_batch] [-z shm_bytes] [-T trace] socket\n", argv[0] );
+      return 2;
+   }
+
+   int listen_fd = Listen( Options.Path );
+   if (listen_fd < 0)
+   {
+      std::perror( Options.Path.c_str() );
+      return 1;
+   }
+
+   std::signal( SIGINT, OnSignal );
+   std::signal( SIGTERM, OnSignal );
+   std::signal( SIGPIPE, SIG_IGN );
+
+   std::fprintf( stderr, "oneka_service %s listening on %s\n", EngineVersion().c_str(), Options.Path.c_str() );
+
+   // The dispatcher is never destroyed: detached reader threads may still
+   // refer to it while the process exits.
+   Dispatcher* D = new Dispatcher( Options );
+   std::thread dispatcher( &Dispatcher::Run, D );
+
+   while (!g_Stop)
+   {
+      pollfd pfd;
+      pfd.fd = listen_fd;
+      pfd.events = POLLIN;
+      if( ::poll( &pfd, 1, 200 ) <= 0 ) continue;
+
+      int fd = ::accept( listen_fd, NULL, NULL );
+      if (fd < 0) continue;
+
+      std::thread( Serve, std::make_shared<Connection>( fd ), D ).detach();
+   }
+
+   ::close( listen_fd );
+   ::unlink( Options.Path.c_str() );
+
+   D->Stop();
+   dispatcher.join();
+
+   if( !Options.Trace.empty() && !TraceWriteChrome( Options.Trace ) )
+   {
+      std::perror( Options.Trace.c_str() );
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,269 @@
+//=============================================================================
+// service_check.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+// A check of a running Engine service.
+//
+// usage:
+//    service_check socket
+//
+// Several client threads send small requests concurrently, so that the 
+// service batches them, and compare each result with a local Engine run.
+// Then a large request is returned through shared memory, a client that
+// never maps its segment leaves nothing behind, and a singular request is
+// refused.
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "engine_client.h"
+
+using namespace oneka;
+
+namespace{
+
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   EngineInput Site( int i, int P, int nSims )
+   {
+      EngineInput In;
+      In.k    = 1.0 + 0.01*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = 2;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = P;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.Xo   = 10;
+      In.Yo   = -20;
+      In.nSims  = nSims;
+      In.Seed   = 11;
+      In.Stream = i;
+      return In;
+   }
+
+   bool Close( double a, double b )
+   {
+      return std::fabs( a - b ) <= 1e-8 * (1.0 + std::fabs( a ) + std::fabs( b ));
+   }
+
+   void FreeRealizations( EngineReturn& S )
+   {
+      if (S.a == NULL) return;
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+
+   // Compare a service result with a local run; the rows come from Row(i).
+   template <typename Rows>
+   bool Agree( const EngineReturn& R, const Rows& Row, const EngineInput& In )
+   {
+      EngineReturn S = Engine( In );
+      bool flag = ( R.nSims == S.nSims );
+
+      for (int i=0; i<6; ++i)
+      {
+         flag &= Close( R.Mu[i], S.Mu[i] );
+         for (int j=0; j<6; ++j)
+            flag &= Close( R.Cov[i][j], S.Cov[i][j] );
+      }
+      for (int s=0; flag && s<S.nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= Close( Row(s)[j], S.a[s][j] );
+
+      FreeRealizations( S );
+      return flag;
+   }
+
+   struct InlineRows
+   {
+      explicit InlineRows( const EngineReturn& S ) : S( S ) {}
+      const double* operator()( int i ) const { return S.a[i]; }
+      const EngineReturn& S;
+   };
+
+   struct MappedRows
+   {
+      explicit MappedRows( const MappedRealizations& A ) : A( A ) {}
+      const double* operator()( int i ) const { return A.Row(i); }
+      const MappedRealizations& A;
+   };
+
+   // The number of Engine segments with a name in /dev/shm.
+   int NamedSegments()
+   {
+      DIR* d = ::opendir( "/dev/shm" );
+      if (d == NULL) return 0;
+
+      int n = 0;
+      while (dirent* e = ::readdir( d ))
+         n += ( std::strncmp( e->d_name, "oneka-", 6 ) == 0 ) ? 1 : 0;
+      ::closedir( d );
+      return n;
+   }
+
+   // Send one request, and read the response without mapping its segment.
+   bool Ignore( const std::string& Path, const EngineInput& In )
+   {
+      sockaddr_un addr;
+      std::memset( &addr, 0, sizeof(addr) );
+      addr.sun_family = AF_UNIX;
+      std::strncpy( addr.sun_path, Path.c_str(), sizeof(addr.sun_path) - 1 );
+
+      int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+      if (fd < 0) return false;
+
+      std::vector<char> Body;
+      EncodeRequest( In, Body );
+      MessageHeader Header;
+      bool ok = ::connect( fd, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) == 0 &&
+         WriteMessage( fd, MESSAGE_REQUEST, 1, Body ) && 
+         ReadMessage( fd, Header, Body ) && Header.Type == MESSAGE_RESPONSE;
+      ::close( fd );
+      return ok;
+   }
+
+   void Client( const std::string& Path, int c, int nRequests, bool* ok )
+   {
+      EngineClient Service;
+      if( !Service.Connect( Path ) ) { *ok = false; return; }
+
+      for (int r=0; r<nRequests; ++r)
+      {
+         EngineInput In = Site( 100*c + r, 6 + (r % 5), 50 + r );
+         EngineReturn R = Service.Engine( In );
+         *ok &= Agree( R, InlineRows( R ), In );
+         FreeRealizations( R );
+      }
+   }
+}
+
+//-----------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+   if (argc != 2)
+   {
+      std::fprintf( stderr, "usage: %s socket\n", argv[0] );
+      return 2;
+   }
+   const std::string Path = argv[1];
+   bool flag = true;
+
+   // Concurrent small requests.
+   {
+      const int nClients = 8;
+      bool ok[nClients];
+      std::vector<std::thread> Threads;
+      for (int c=0; c<nClients; ++c)
+      {
+         ok[c] = true;
+         Threads.push_back( std::thread( Client, Path, c, 25, &ok[c] ) );
+      }
+      for (int c=0; c<nClients; ++c)
+      {
+         Threads[c].join();
+         flag &= ok[c];
+      }
+      std::fprintf( stderr, "small requests: %s\n", flag ? "ok" : "FAILED" );
+   }
+
+   EngineClient Service;
+   if( !Service.Connect( Path ) )
+   {
+      std::fprintf( stderr, "cannot connect to %s\n", Path.c_str() );
+      return 1;
+   }
+
+   // A large request, returned through shared memory.
+   {
+      EngineInput In = Site( 7, 10, 50000 );
+      MappedRealizations A;
+      EngineReturn R = Service.Engine( In, A );
+
+      bool ok = ( R.a == NULL && A.nSims() == In.nSims ) && Agree( R, MappedRows( A ), In );
+      ok &= ( NamedSegments() == 0 );
+      std::fprintf( stderr, "shared memory: %s\n", ok ? "ok" : "FAILED" );
+      flag &= ok;
+   }
+
+   // A large response whose segment is never mapped.
+   {
+      bool ok = Ignore( Path, Site( 9, 10, 50000 ) ) && ( NamedSegments() == 0 );
+      std::fprintf( stderr, "unmapped: %s\n", ok ? "ok" : "FAILED" );
+      flag &= ok;
+   }
+
+   // A singular request.
+   {
+      bool singular = false;
+      try
+      {
+         Service.Engine( Site( 8, 4, 10 ) );
+      }
+      catch( Exception_SingularSystem& )
+      {
+         singular = true;
+      }
+      std::fprintf( stderr, "singular: %s\n", singular ? "ok" : "FAILED" );
+      flag &= singular;
+   }
+
+   std::fprintf( stderr, flag ? "SERVICE CHECK PASSED\n" : "SERVICE CHECK FAILED\n" );
+   return flag ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+//=============================================================================
+// service_io.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "service_io.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneka{
+
+namespace{
+
+   //--------------------------------------------------------------------------
+   // Read or write exactly n bytes, retrying after interruptions.
+   //
+   // WriteAll sends the descriptor Passed, if not -1, with the first byte.
+   // ReadAll keeps the first descriptor received in *Passed, if it is -1,
+   // and closes any other.
+   //--------------------------------------------------------------------------
+   bool ReadAll( int fd, char* p, std::size_t n, int* Passed )
+   {
+      while (n > 0)
+      {
+         iovec iov;
+         iov.iov_base = p;
+         iov.iov_len = n;
+
+         char control[CMSG_SPACE( sizeof(int) )];
+         msghdr msg;
+         std::memset( &msg, 0, sizeof(msg) );
+         msg.msg_iov = &iov;
+         msg.msg_iovlen = 1;
+         msg.msg_control = control;
+         msg.msg_controllen = sizeof(control);
+
+         ssize_t r = ::recvmsg( fd, &msg, MSG_CMSG_CLOEXEC );
+         if (r < 0 && errno == EINTR) continue;
+         if (r <= 0) return false;
+
+         for (cmsghdr* c = CMSG_FIRSTHDR( &msg ); c != NULL; c = CMSG_NXTHDR( &msg, c ))
+         {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+
+            int received;
+            std::memcpy( &received, CMSG_DATA( c ), sizeof(int) );
+            if (Passed != NULL && *Passed < 0)
+               *Passed = received;
+            else
+               ::close( received );
+         }
+
+         p += r;
+         n -= std::size_t( r );
+      }
+      return true;
+   }
+
+   bool WriteAll( int fd, const char* p, std::size_t n, int Passed )
+   {
+      while (n > 0)
+      {
+         iovec iov;
+         iov.iov_base = const_cast<char*>( p );
+         iov.iov_len = n;
+
+         char control[CMSG_SPACE( sizeof(int) )];
+         msghdr msg;
+         std::memset( &msg, 0, sizeof(msg) );
+         msg.msg_iov = &iov;
+         msg.msg_iovlen = 1;
+         if (Passed >= 0)
+         {
+            std::memset( control, 0, sizeof(control) );
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            cmsghdr* c = CMSG_FIRSTHDR( &msg );
+            c->cmsg_level = SOL_SOCKET;
+            c->cmsg_type = SCM_RIGHTS;
+            c->cmsg_len = CMSG_LEN( sizeof(int) );
+            std::memcpy( CMSG_DATA( c ), &Passed, sizeof(int) );
+         }
+
+         ssize_t r = ::sendmsg( fd, &msg, MSG_NOSIGNAL );
+         if (r < 0 && errno == EINTR) continue;
+         if (r <= 0) return false;
+         p += r;
+         n -= std::size_t( r );
+         Passed = -1;
+      }
+      return true;
+   }
+
+   //--------------------------------------------------------------------------
+   // A process-unique segment name.
+   //--------------------------------------------------------------------------
+   std::string SegmentName()
+   {
+      static unsigned long counter = 0;
+      unsigned long n = __sync_fetch_and_add( &counter, 1 );
+
+      char name[64];
+      std::snprintf( name, sizeof(name), "/oneka-%ld-%lu", long( ::getpid() ), n );
+      return name;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// ReadMessage
+//-----------------------------------------------------------------------------
+bool ReadMessage( int fd, MessageHeader& Header, std::vector<char>& Body, int* Passed )
+{
+   int received = -1;
+
+   bool ok = ReadAll( fd, reinterpret_cast<char*>( &Header ), sizeof(Header), &received ) &&
+      Header.Magic == PROTOCOL_MAGIC && 
+      Header.Version == PROTOCOL_VERSION && 
+      Header.Length <= PROTOCOL_MAX_LENGTH;
+
+   if (ok)
+   {
+      Body.resize( Header.Length );
+      ok = Header.Length == 0 || ReadAll( fd, &Body[0], Header.Length, &received );
+   }
+
+   if (received >= 0 && (!ok || Passed == NULL))
+   {
+      ::close( received );
+      received = -1;
+   }
+   if (Passed != NULL) *Passed = received;
+   return ok;
+}
+
+//-----------------------------------------------------------------------------
+// WriteMessage
+//-----------------------------------------------------------------------------
+bool WriteMessage( int fd, unsigned int Type, unsigned int Id, const std::vector<char>& Body, int Passed )
+{
+   MessageHeader Header;
+   Header.Magic   = PROTOCOL_MAGIC;
+   Header.Version = PROTOCOL_VERSION;
+   Header.Type    = Type;
+   Header.Id      = Id;
+   Header.Length  = static_cast<unsigned int>( Body.size() );
+
+   if( !WriteAll( fd, reinterpret_cast<const char*>( &Header ), sizeof(Header), Passed ) ) return false;
+   return Body.empty() || WriteAll( fd, &Body[0], Body.size(), -1 );
+}
+
+//-----------------------------------------------------------------------------
+// PublishRealizations
+//
+// Notes:
+// o  The name is unlinked as soon as the segment is open, so a segment is
+//    never left behind by a client that does not read its response, by a 
+//    failed write, or by a crash of either process.
+//
+// o  The realizations are copied, rather than generated in the segment: 
+//    the Engine allocates them row by row (see EngineReturn), and the 
+//    copy is a single pass that costs little next to drawing them.
+//-----------------------------------------------------------------------------
+int PublishRealizations( const EngineReturn& S, std::string& Segment )
+{
+   const std::size_t row = 6*sizeof(double);
+   const std::size_t bytes = row * std::size_t( S.nSims );
+   if (bytes == 0) return -1;
+
+   const std::string name = SegmentName();
+   int fd = ::shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600 );
+   if (fd < 0) return -1;
+   ::shm_unlink( name.c_str() );
+
+   void* p = MAP_FAILED;
+   if( ::ftruncate( fd, off_t( bytes ) ) == 0 )
+      p = ::mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+   if (p == MAP_FAILED)
+   {
+      ::close( fd );
+      return -1;
+   }
+
+   char* q = static_cast<char*>( p );
+   for (int i=0; i<S.nSims; ++i)
+      std::memcpy( q + row*i, S.a[i], row );
+
+   ::munmap( p, bytes );
+   Segment = name;
+   return fd;
+}
+
+//=============================================================================
+// MappedRealizations
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+MappedRealizations::MappedRealizations()
+:  m_Data( NULL ), m_Bytes( 0 ), m_nSims( 0 )
+{
+}
+
+//-----------------------------------------------------------------------------
+MappedRealizations::~MappedRealizations()
+{
+   Unmap();
+}
+
+//-----------------------------------------------------------------------------
+bool MappedRealizations::Map( int Segment, int nSims )
+{
+   Unmap();
+
+   if (Segment < 0) return false;
+
+   const std::size_t bytes = 6*sizeof(double)*std::size_t( nSims );
+
+   struct stat st;
+   void* p = MAP_FAILED;
+   if( ::fstat( Segment, &st ) == 0 && std::size_t( st.st_size ) == bytes && bytes > 0 )
+      p = ::mmap( NULL, bytes, PROT_READ, MAP_SHARED, Segment, 0 );
+
+   if (p == MAP_FAILED) return false;
+
+   m_Data  = static_cast<const double*>( p );
+   m_Bytes = bytes;
+   m_nSims = nSims;
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+void MappedRealizations::Unmap()
+{
+   if (m_Data != NULL)
+      ::munmap( const_cast<double*>( m_Data ), m_Bytes );
+
+   m_Data  = NULL;
+   m_Bytes = 0;
+   m_nSims = 0;
+}
+
+
+} // namespace oneka
@@ -0,0 +1,103 @@
+//=============================================================================
+// service_io.h
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#ifndef SERVICE_IO_H
+#define SERVICE_IO_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../Engine/engine_protocol.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// Framed messages on a connected Unix domain socket.  Both return false if
+// the peer has closed the connection or the message is malformed.
+//
+// WriteMessage passes the descriptor Passed, if not -1, along with the 
+// message (SCM_RIGHTS); the caller keeps its own copy.  ReadMessage returns
+// a descriptor passed with the message in *Passed, or -1 if there is none.
+// The caller must close it.  A descriptor that is not asked for, or that 
+// comes with a message that cannot be read, is closed.
+//-----------------------------------------------------------------------------
+bool ReadMessage( int fd, MessageHeader& Header, std::vector<char>& Body, int* Passed = NULL );
+bool WriteMessage( int fd, unsigned int Type, unsigned int Id, const std::vector<char>& Body, int Passed = -1 );
+
+//-----------------------------------------------------------------------------
+// Realizations in POSIX shared memory.
+//
+// PublishRealizations copies the (nSims x 6) realizations of S into a new
+// segment and returns a descriptor for it, or -1 on failure.  The name of
+// the segment is returned in Segment, but it is already unlinked: the 
+// segment lives only as long as a descriptor or a mapping refers to it.  
+// It is handed to the client with the response, and released by the 
+// kernel whether or not the client ever reads it.
+//
+// MappedRealizations maps a segment descriptor read-only.  The memory is
+// released when the mapping is destroyed and the descriptor closed.  The 
+// rows are read in place.
+//-----------------------------------------------------------------------------
+int PublishRealizations( const EngineReturn& S, std::string& Segment );
+
+class MappedRealizations
+{
+public:
+   MappedRealizations();
+   ~MappedRealizations();
+
+   bool Map( int Segment, int nSims );
+   void Unmap();
+
+   int nSims() const { return m_nSims; }
+   const double* Row( int i ) const { return m_Data + 6*i; }
+
+private:
+   MappedRealizations( const MappedRealizations& );
+   MappedRealizations& operator=( const MappedRealizations& );
+
+   const double* m_Data;
+   std::size_t m_Bytes;
+   int m_nSims;
+};
+
+
+} // namespace oneka
+
+//=============================================================================
+#endif  // SERVICE_IO_H
@@ -0,0 +1,147 @@
+//=============================================================================
+// test_analytic_field.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_analytic_field.h"
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "..\Engine\analytic_field.h"
+#include "..\Engine\gaussian.h"
+#include "..\Engine\head_field.h"
+#include "..\Engine\oneka_model.h"
+#include "..\Engine\point_set.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestAnalyticHeads
+//-----------------------------------------------------------------------------
+bool TestAnalyticHeads()
+{
+   bool flag = true;
+
+   const double k = 1.0;
+   const double H = 50.0;
+   const double Base = 0.0;
+
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30.0 };
+
+   // A grid that straddles the confined/unconfined boundary (Phi = 1250).
+   PointSet S( -94.0, -96.0, 19.0, 19.0, 11, 11, 1, Xw, Yw, Qw, 0.0, 0.0 );
+
+   const double Mu[6] = { -0.01, -0.01, 0.001, -2.0, 1.0, 1300.0 };
+   double Cov[6][6] = { {0} };
+   const double Std[6] = { 4e-3, 4e-3, 2e-3, 0.2, 0.2, 50.0 };
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         Cov[i][j] = ((i == j) ? 1.0 : 0.2) * Std[i]*Std[j];
+
+   const double thresholds[] = { 45.0, 50.0, 52.0 };
+
+   AnalyticField F;
+   AnalyticHeads( S, k, H, Base, Mu, Cov, 3, thresholds, F );
+
+   // Compare the mean and variance of Phi with the explicit quadratic form.
+   Matrix mu( 6, 1, Mu );
+   Matrix C( 6, 6, &Cov[0][0] );
+
+   for (int j=0; j<S.nPoints(); ++j)
+   {
+      Matrix g( 6, 1 );
+      for (int r=0; r<6; ++r) g(r,0) = S.Basis(r)[j];
+
+      double mean = 0;
+      for (int r=0; r<6; ++r) mean += g(r,0)*mu(r,0);
+      mean += S.Phiw()[j];
+
+      double var = QuadraticForm_MtMM( g, C, g );
+
+      flag &= RelativeEqual( F.MeanPhi(0,j), mean, 1e-12 );
+      flag &= RelativeEqual( F.StdPhi(0,j), sqrt(var), 1e-9 );
+      flag &= ApproxEqual( F.MeanHead(0,j), PhiToHead( mean, k, H, Base ), 1e-9 );
+   }
+
+   // Compare the exceedance probabilities with a Monte Carlo estimate.
+   const int nSims = 20000;
+   Matrix Mut( 1, 6, Mu );
+   Matrix X;
+   InitializeRNG( 2468 );
+   MVNormalRNG( nSims, Mut, C, X );
+
+   std::vector< double* > a( nSims );
+   for (int i=0; i<nSims; ++i) a[i] = X.Base(i,0);
+
+   Matrix Heads;
+   EvaluateHeads( S, k, H, Base, nSims, &a[0], Heads );
+
+   for (int j=0; j<S.nPoints(); ++j)
+   {
+      for (int t=0; t<3; ++t)
+      {
+         int count = 0;
+         for (int i=0; i<nSims; ++i)
+            count += (Heads(i,j) > thresholds[t]) ? 1 : 0;
+
+         flag &= ApproxEqual( F.Exceedance(t,j), double(count)/nSims, 0.015 );
+      }
+   }
+
+   // A threshold at exactly Base is exceeded only where the aquifer is wet.
+   // Lower the mean so that some of the grid is likely to be dry.
+   double Dry[6];
+   for (int i=0; i<6; ++i) Dry[i] = Mu[i];
+   Dry[5] = 0;
+
+   AnalyticHeads( S, k, H, Base, Dry, Cov, 1, &Base, F );
+
+   int nUncertain = 0;
+   for (int j=0; j<S.nPoints(); ++j)
+   {
+      double p = 1 - GaussianCDF( -F.MeanPhi(0,j)/F.StdPhi(0,j) );
+      flag &= ApproxEqual( F.Exceedance(0,j), p, 1e-12 );
+      nUncertain += (p < 0.9) ? 1 : 0;
+   }
+   flag &= (nUncertain > 0);
+
+   return flag;
+}
+
+} // namespace oneka
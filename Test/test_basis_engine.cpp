@@ -0,0 +1,166 @@
+//=============================================================================
+// test_basis_engine.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_basis_engine.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\basis_engine.h"
+#include "..\Engine\oneka_engine.h"
+#include "utility.h"
+
+namespace{
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   const int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   const int P = 12;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30, 170, -60 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45,  20, 150 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80, 43.20, 53.90 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0, 1.2, 0.9 };
+
+   double Xo = 10;
+   double Yo = -20;
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestFitBasis
+//-----------------------------------------------------------------------------
+bool TestFitBasis()
+{
+   bool flag = true;
+
+   // The sizes.
+   flag &= ( BasisSize<OnekaBasis>::value == 6 );
+   flag &= ( BasisSize<UniformFlowBasis>::value == 3 );
+   flag &= ( BasisSize<CubicBasis>::value == 10 );
+
+   // The Oneka instantiation reproduces Engine.
+   EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, 1 );
+   BasisFit<OnekaBasis> F = FitBasis<OnekaBasis>( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo );
+
+   for (int i=0; i<6; ++i)
+   {
+      flag &= ApproxEqual( F.Mu[i], S.Mu[i], 1e-8*(1 + fabs(S.Mu[i])) );
+      for (int j=0; j<6; ++j)
+         flag &= ApproxEqual( F.Cov[i][j], S.Cov[i][j], 1e-8*sqrt(S.Cov[i][i]*S.Cov[j][j]) );
+   }
+
+   delete [] S.a[0];
+   delete [] S.a;
+
+   // Uniform flow: no curvature.  With exact data the fit is exact.
+   double a[] = { -0.5, 0.25, 1200.0 };
+   double E[P], Z[P];
+   for (int p=0; p<P; ++p)
+   {
+      double Phi = a[0]*(Xp[p]-Xo) + a[1]*(Yp[p]-Yo) + a[2] 
+                 + WellPotential( Xp[p], Yp[p], W, Xw, Yw, Qw );
+      E[p] = PhiToHead( Phi, k, H, Base );
+      Z[p] = 1e-3;
+   }
+
+   BasisFit<UniformFlowBasis> U = FitBasis<UniformFlowBasis>( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, E, Z, Xo, Yo );
+   for (int i=0; i<3; ++i)
+      flag &= ApproxEqual( U.Mu[i], a[i], 1e-3*(1 + fabs(a[i])) );
+
+   // The cubic, with all twelve piezometers.
+   BasisFit<CubicBasis> C = FitBasis<CubicBasis>( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo );
+   for (int i=0; i<10; ++i)
+      flag &= ( C.Cov[i][i] > 0 );
+
+   // Too few piezometers for the cubic.
+   bool singular = false;
+   try
+   {
+      FitBasis<CubicBasis>( k, H, Base, W, Xw, Yw, Qw, 8, Xp, Yp, Ep, Sp, Xo, Yo );
+   }
+   catch( Exception_SingularSystem& )
+   {
+      singular = true;
+   }
+   flag &= singular;
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestSimulateBasis
+//-----------------------------------------------------------------------------
+bool TestSimulateBasis()
+{
+   bool flag = true;
+
+   BasisFit<OnekaBasis> F = FitBasis<OnekaBasis>( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo );
+
+   const int nSims = 20000;
+   Matrix X;
+   RandomStream R( 2011, 1 );
+   SimulateBasis( F, nSims, R, X );
+
+   flag &= ( X.nRows() == nSims && X.nCols() == 6 );
+
+   // The sample mean is within a few standard errors.
+   for (int j=0; j<6; ++j)
+   {
+      double sum = 0;
+      for (int s=0; s<nSims; ++s)
+         sum += X(s,j);
+
+      flag &= ApproxEqual( sum/nSims, F.Mu[j], 4*sqrt(F.Cov[j][j]/nSims) );
+   }
+
+   // The realizations are reproduced by the same stream.
+   Matrix Y;
+   RandomStream Again( 2011, 1 );
+   SimulateBasis( F, 10, Again, Y );
+   for (int s=0; s<10; ++s)
+      for (int j=0; j<6; ++j)
+         flag &= ( Y(s,j) == X(s,j) );
+
+   return flag;
+}
+
+} // namespace oneka
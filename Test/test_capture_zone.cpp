@@ -0,0 +1,182 @@
+//=============================================================================
+// test_capture_zone.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_capture_zone.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\capture_zone.h"
+#include "..\Engine\oneka_model.h"
+#include "..\Engine\point_set.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestDischarge
+//
+//    Compare the analytic discharge with central differences of Phi.
+//-----------------------------------------------------------------------------
+bool TestDischarge()
+{
+   bool flag = true;
+
+   double Xw[] = { 0.0, 40.0 };
+   double Yw[] = { 0.0, -30.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   const double a[] = { -0.01, -0.02, 0.003, -2.0, 1.0, 1300.0 };
+   const double Xo = 5.0;
+   const double Yo = -5.0;
+
+   const double x[] = { 17.0, -60.0, 33.0 };
+   const double y[] = { 23.0, 41.0, -80.0 };
+
+   for (int i=0; i<3; ++i)
+   {
+      double Qx, Qy;
+      Discharge( a, x[i], y[i], 2, Xw, Yw, Qw, Xo, Yo, Qx, Qy );
+
+      const double h = 1e-4;
+      double Phi[4];
+      const double px[] = { x[i]+h, x[i]-h, x[i], x[i] };
+      const double py[] = { y[i], y[i], y[i]+h, y[i]-h };
+
+      for (int j=0; j<4; ++j)
+      {
+         double dX = px[j] - Xo;
+         double dY = py[j] - Yo;
+         Phi[j] = a[0]*dX*dX + a[1]*dY*dY + a[2]*dX*dY + a[3]*dX + a[4]*dY + a[5]
+                + WellPotential( px[j], py[j], 2, Xw, Yw, Qw );
+      }
+
+      flag &= ApproxEqual( Qx, -(Phi[0]-Phi[1])/(2*h), 1e-6 );
+      flag &= ApproxEqual( Qy, -(Phi[2]-Phi[3])/(2*h), 1e-6 );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestCaptureProbability
+//
+//    A single well in a uniform flow field in the +x direction.  The 
+//    capture zone is bounded by the dividing streamline
+//
+//       y = Q/(2 pi q0) theta
+//
+//    which passes through the stagnation point x = Q/(2 pi q0) and 
+//    approaches y = +/- Q/(2 q0) far upstream.
+//-----------------------------------------------------------------------------
+bool TestCaptureProbability()
+{
+   bool flag = true;
+
+   const double k = 1.0;
+   const double H = 50.0;
+   const double Porosity = 0.3;
+
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30.0 };
+
+   // Two realizations: q0 = 1 (half width 15) and q0 = 0.5 (half width 30).
+   double a0[] = { 0.0, 0.0, 0.0, -1.0, 0.0, 1300.0 };
+   double a1[] = { 0.0, 0.0, 0.0, -0.5, 0.0, 1300.0 };
+   double* a[] = { a0, a1 };
+
+   // Release points: upstream on the axis, inside both zones, inside the
+   // wider zone only, outside both, and downstream of both stagnation 
+   // points (at 4.8 and 9.5).
+   double X[] = { -50.0, -50.0, -50.0, -50.0,  6.0, 50.0 };
+   double Y[] = {   0.0,  10.0,  20.0,  35.0,  0.0,  0.0 };
+   double Ans[] = { 1.0, 1.0, 0.5, 0.0, 0.5, 0.0 };
+
+   PointSet S( 6, X, Y, 1, Xw, Yw, Qw, 0.0, 0.0 );
+
+   Matrix P;
+   CaptureProbability( S, k, H, Porosity, 1, Xw, Yw, Qw, 0.0, 0.0, 2, a, 0, 0.5, 1e6, P );
+
+   for (int j=0; j<6; ++j)
+      flag &= ApproxEqual( P(0,j), Ans[j], 1e-12 );
+
+   // A short time of travel captures nothing far upstream.
+   CaptureProbability( S, k, H, Porosity, 1, Xw, Yw, Qw, 0.0, 0.0, 2, a, -1, 0.5, 10.0, P );
+   flag &= ApproxEqual( P(0,0), 0.0, 1e-12 );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestCaptureNoWells
+//
+//    Without a pumping well nothing is captured, and every particle travels
+//    for the full Duration rather than stalling: first with no wells, then
+//    with a single injection well.
+//-----------------------------------------------------------------------------
+bool TestCaptureNoWells()
+{
+   bool flag = true;
+
+   const double k = 1.0;
+   const double H = 50.0;
+   const double Porosity = 0.3;
+
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { -30.0 };
+
+   double a0[] = { 0.0, 0.0, 0.0, -1.0, 0.0, 1300.0 };
+   double a1[] = { 0.0, 0.0, 0.0, -0.5, 0.2, 1300.0 };
+   double* a[] = { a0, a1 };
+
+   for (int W=0; W<2; ++W)
+   {
+      PointSet S( -190.0, -190.0, 20.0, 20.0, 20, 20, W, Xw, Yw, Qw, 0.0, 0.0 );
+
+      Matrix P;
+      CaptureProbability( S, k, H, Porosity, W, Xw, Yw, Qw, 0.0, 0.0, 2, a, -1, 0.5, 1e5, P );
+
+      flag &= ( P.nCols() == S.nPoints() );
+      for (int j=0; j<S.nPoints(); ++j)
+         flag &= ( P(0,j) == 0.0 );
+   }
+
+   return flag;
+}
+
+} // namespace oneka
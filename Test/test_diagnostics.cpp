@@ -0,0 +1,152 @@
+//=============================================================================
+// test_diagnostics.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_diagnostics.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\diagnostics.h"
+#include "..\Engine\linear_systems.h"
+#include "..\Engine\oneka_engine.h"
+#include "..\Engine\oneka_model.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestLeaveOneOutDiagnostics
+//
+//    Compare against explicitly refitting without each piezometer.
+//-----------------------------------------------------------------------------
+bool TestLeaveOneOutDiagnostics()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   const int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   const int P = 10;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   double Xo = 10;
+   double Yo = -20;
+
+   LeaveOneOut D;
+   LeaveOneOutDiagnostics( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, D );
+
+   // The full fit.
+   EngineReturn All = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, 1 );
+
+   Matrix Cov( 6, 6, &All.Cov[0][0] );
+   Matrix Info;
+   RSPDInv( Cov, Info );
+
+   double RSS = 0;
+   double sumh = 0;
+   for (int p=0; p<P; ++p)
+   {
+      double row[6], rhs;
+      ObservationEquation( k, H, Base, W, Xw, Yw, Qw, Xp[p], Yp[p], Ep[p], Sp[p], Xo, Yo, row, rhs );
+
+      double fit = 0;
+      for (int j=0; j<6; ++j) fit += row[j]*All.Mu[j];
+
+      flag &= ApproxEqual( D.Residual(0,p), rhs - fit, 1e-8 );
+      RSS  += (rhs - fit)*(rhs - fit);
+      sumh += D.Leverage(0,p);
+   }
+
+   // The trace of the hat matrix is the number of coefficients.
+   flag &= ApproxEqual( sumh, 6.0, 1e-10 );
+
+   double s2 = RSS/(P - 6);
+
+   // Refit without each piezometer in turn.
+   for (int p=0; p<P; ++p)
+   {
+      double xp[P], yp[P], ep[P], sp[P];
+      int n = 0;
+      for (int i=0; i<P; ++i)
+      {
+         if( i == p ) continue;
+         xp[n] = Xp[i];
+         yp[n] = Yp[i];
+         ep[n] = Ep[i];
+         sp[n] = Sp[i];
+         ++n;
+      }
+
+      EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, n, xp, yp, ep, sp, Xo, Yo, 1 );
+
+      double row[6], rhs;
+      ObservationEquation( k, H, Base, W, Xw, Yw, Qw, Xp[p], Yp[p], Ep[p], Sp[p], Xo, Yo, row, rhs );
+
+      double fit = 0;
+      for (int j=0; j<6; ++j) fit += row[j]*S.Mu[j];
+      flag &= ApproxEqual( D.Deleted(0,p), rhs - fit, 1e-6*(1 + fabs(rhs - fit)) );
+
+      // Cook's distance: the change in the fit, in the metric of A'A.
+      double d[6];
+      for (int j=0; j<6; ++j) d[j] = All.Mu[j] - S.Mu[j];
+
+      double q = 0;
+      for (int i=0; i<6; ++i)
+         for (int j=0; j<6; ++j)
+            q += d[i]*Info(i,j)*d[j];
+
+      flag &= RelativeEqual( D.CooksDistance(0,p), q/(6*s2), 1e-5 );
+
+      delete [] S.a[0];
+      delete [] S.a;
+   }
+
+   delete [] All.a[0];
+   delete [] All.a;
+
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,352 @@
+//=============================================================================
+// test_engine_batch.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_engine_batch.h"
+
+#include <cassert>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "..\Engine\engine_batch.h"
+#include "..\Engine\lane_engine.h"
+#include "utility.h"
+
+namespace{
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   void FreeRealizations( oneka::EngineReturn& S )
+   {
+      if( S.a == NULL ) return;
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+
+   class CancelAtOnce : public oneka::EngineMonitor
+   {
+   public:
+      bool Cancelled() { return true; }
+   };
+
+   // Runs out of memory once the first realizations are drawn.
+   class FailAtOnce : public oneka::EngineMonitor
+   {
+   public:
+      void Progress( int, int ) { throw std::bad_alloc(); }
+   };
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestEngineBatch
+//-----------------------------------------------------------------------------
+bool TestEngineBatch()
+{
+   bool flag = true;
+
+   // A batch of sites that differ in size, conductivity, and origin.  Every
+   // seventh site has too few piezometers.
+   const int nSites = 40;
+   std::vector<EngineInput> Inputs( nSites );
+
+   for (int i=0; i<nSites; ++i)
+   {
+      EngineInput& In = Inputs[i];
+      In.k    = 1.0 + 0.1*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = 1 + i % 2;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = (i % 7 == 3) ? 4 : 6 + i % 5;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.Xo   = 5.0*i;
+      In.Yo   = -20;
+      In.nSims  = 10 + 37*(i % 4);
+      In.Seed   = 2011;
+      In.Stream = i;
+   }
+
+   std::vector<EngineReturn> Results;
+   std::vector<int> Status;
+   EngineBatch( Inputs, Results, Status );
+
+   flag &= ( int(Results.size()) == nSites && int(Status.size()) == nSites );
+
+   // Each result matches a serial run of the same site.
+   for (int i=0; i<nSites; ++i)
+   {
+      if( Inputs[i].P < 6 )
+      {
+         flag &= ( Status[i] == ENGINE_SINGULAR && Results[i].a == NULL );
+         continue;
+      }
+
+      flag &= ( Status[i] == ENGINE_OK );
+
+      EngineReturn S = Engine( Inputs[i] );
+
+      flag &= ( Results[i].nSims == S.nSims && Results[i].Xo == S.Xo );
+      for (int j=0; j<6; ++j)
+         flag &= ( Results[i].Mu[j] == S.Mu[j] );
+
+      for (int s=0; s<S.nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= ( Results[i].a[s][j] == S.a[s][j] );
+
+      FreeRealizations( S );
+   }
+
+   // The site's Seed and Stream are those of the argument-list Engine.
+   {
+      EngineInput In = Inputs[0];
+      EngineOptions Options = In.Options;
+      Options.UseSeed = true;
+      Options.Seed = In.Seed;
+      Options.Stream = In.Stream;
+
+      EngineReturn S = Engine( In );
+      EngineReturn T = Engine( In.k, In.H, In.Base, In.W, In.Xw, In.Yw, In.Qw,
+         In.P, In.Xp, In.Yp, In.Ep, In.Sp, In.Xo, In.Yo, In.nSims, Options );
+
+      flag &= ( S.Seed == T.Seed && S.Stream == T.Stream && S.nSims == T.nSims );
+      for (int s=0; s<S.nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= ( S.a[s][j] == T.a[s][j] );
+
+      FreeRealizations( S );
+      FreeRealizations( T );
+   }
+
+   // A site that sets Options.UseSeed is rejected, not run with the wrong
+   // seed.
+   {
+      std::vector<EngineInput> Seeded( Inputs.begin(), Inputs.begin() + 2 );
+      Seeded[1].Options.UseSeed = true;
+
+      bool thrown = false;
+      try { Engine( Seeded[1] ); } catch( std::invalid_argument& ) { thrown = true; }
+      flag &= thrown;
+
+      std::vector<EngineReturn> R;
+      std::vector<int> St;
+      EngineBatch( Seeded, R, St );
+      flag &= ( St[0] == ENGINE_OK && St[1] == ENGINE_FAILED && R[1].a == NULL );
+      FreeRealizations( R[0] );
+
+      EngineLanes( Seeded, R, St );
+      flag &= ( St[0] == ENGINE_OK && St[1] == ENGINE_FAILED && R[1].a == NULL );
+      FreeRealizations( R[0] );
+   }
+
+   // The results do not depend upon the number of threads.
+   std::vector<EngineReturn> Serial;
+   EngineBatch( Inputs, Serial, Status, 1 );
+
+   for (int i=0; i<nSites; ++i)
+   {
+      for (int s=0; s<Serial[i].nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= ( Results[i].a[s][j] == Serial[i].a[s][j] );
+
+      FreeRealizations( Serial[i] );
+      FreeRealizations( Results[i] );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEngineLanes
+//-----------------------------------------------------------------------------
+bool TestEngineLanes()
+{
+   bool flag = true;
+
+   // Sites of mixed sizes: a group is padded, every seventh site is 
+   // singular, and every fifth site keeps its derived quantities, so it is
+   // run by the scalar Engine.
+   const int nSites = 23;
+   std::vector<EngineInput> Inputs( nSites );
+
+   for (int i=0; i<nSites; ++i)
+   {
+      EngineInput& In = Inputs[i];
+      In.k    = 1.0 + 0.1*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = i % 3;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = (i % 7 == 3) ? 5 : 6 + (3*i) % 5;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.Xo   = 5.0*i;
+      In.Yo   = -20;
+      In.nSims  = 1 + 13*(i % 4);
+      In.Seed   = 1959;
+      In.Stream = 100 + i;
+      In.Options.KeepDerived = (i % 5 == 0);
+   }
+
+   std::vector<EngineReturn> Results;
+   std::vector<int> Status;
+   EngineLanes( Inputs, Results, Status );
+
+   flag &= ( int(Results.size()) == nSites && int(Status.size()) == nSites );
+
+   for (int i=0; i<nSites; ++i)
+   {
+      if( Inputs[i].P < 6 )
+      {
+         flag &= ( Status[i] == ENGINE_SINGULAR && Results[i].a == NULL );
+         continue;
+      }
+
+      flag &= ( Status[i] == ENGINE_OK );
+
+      EngineReturn S = Engine( Inputs[i] );
+      const EngineReturn& T = Results[i];
+
+      flag &= ( T.nSims == S.nSims && T.Xo == S.Xo && T.Yo == S.Yo );
+      flag &= ( T.Derived.nRows() == S.Derived.nRows() );
+
+      for (int j=0; j<6; ++j)
+      {
+         flag &= ApproxEqual( T.Mu[j], S.Mu[j], 1e-7*(1 + fabs(S.Mu[j])) );
+         for (int m=0; m<6; ++m)
+            flag &= ApproxEqual( T.Cov[j][m], S.Cov[j][m], 1e-7*sqrt(S.Cov[j][j]*S.Cov[m][m]) );
+      }
+
+      // The same deviates, transformed by the same factor.
+      for (int s=0; s<S.nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= ApproxEqual( T.a[s][j], S.a[s][j], 1e-6*(sqrt(S.Cov[j][j]) + fabs(S.Mu[j])) );
+
+      FreeRealizations( S );
+      FreeRealizations( Results[i] );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEngineBatchCancel
+//
+//    A cancelled or failed site is reported, and does not disturb the others.
+//-----------------------------------------------------------------------------
+bool TestEngineBatchCancel()
+{
+   bool flag = true;
+
+   CancelAtOnce Monitor;
+   FailAtOnce Failure;
+   const int nSites = 12;
+   std::vector<EngineInput> Inputs( nSites );
+
+   for (int i=0; i<nSites; ++i)
+   {
+      EngineInput& In = Inputs[i];
+      In.k    = 1.0 + 0.1*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = 1;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = 10;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.nSims  = 100;
+      In.Seed   = 7;
+      In.Stream = i;
+      if (i % 3 == 1) In.Options.Monitor = &Monitor;
+      if (i % 6 == 2) In.Options.Monitor = &Failure;
+   }
+
+   for (int mode=0; mode<2; ++mode)
+   {
+      std::vector<EngineReturn> Results;
+      std::vector<int> Status;
+      if (mode == 0)
+         EngineBatch( Inputs, Results, Status );
+      else
+         EngineLanes( Inputs, Results, Status );
+
+      for (int i=0; i<nSites; ++i)
+      {
+         if (i % 3 == 1)
+            flag &= ( Status[i] == ENGINE_CANCELLED && Results[i].a == NULL );
+         else if (i % 6 == 2)
+            flag &= ( Status[i] == ENGINE_FAILED && Results[i].a == NULL );
+         else
+            flag &= ( Status[i] == ENGINE_OK && Results[i].a != NULL && Results[i].nSims == 100 );
+
+         FreeRealizations( Results[i] );
+      }
+   }
+
+   // Each status has its own name.
+   flag &= ( std::string( StatusName( ENGINE_SINGULAR ) ) == "singular" );
+   flag &= ( std::string( StatusName( ENGINE_CANCELLED ) ) == "cancelled" );
+   flag &= ( std::string( StatusName( ENGINE_FAILED ) ) == "failed" );
+
+   return flag;
+}
+
+
+} // namespace oneka
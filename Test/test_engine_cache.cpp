@@ -0,0 +1,264 @@
+//=============================================================================
+// test_engine_cache.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_engine_cache.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\engine_cache.h"
+#include "..\Engine\engine_jobs.h"
+#include "utility.h"
+
+namespace{
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   oneka::EngineInput Site( int i, int P = 10, int nSims = 200 )
+   {
+      oneka::EngineInput In;
+      In.k    = 1.0 + 0.1*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = 2;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = P;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.Xo   = 10;
+      In.Yo   = -20;
+      In.nSims  = nSims;
+      In.Seed   = 3;
+      In.Stream = i;
+      return In;
+   }
+
+   bool Same( const oneka::EngineReturn& R, const oneka::EngineReturn& S )
+   {
+      bool flag = ( R.nSims == S.nSims && R.Xo == S.Xo && R.Yo == S.Yo );
+      for (int i=0; i<6; ++i)
+      {
+         flag &= ( R.Mu[i] == S.Mu[i] );
+         for (int j=0; j<6; ++j)
+            flag &= ( R.Cov[i][j] == S.Cov[i][j] );
+      }
+      for (int s=0; flag && s<S.nSims; ++s)
+         for (int j=0; j<6; ++j)
+            flag &= ( R.a[s][j] == S.a[s][j] );
+      return flag;
+   }
+
+   void FreeRealizations( oneka::EngineReturn& S )
+   {
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestEngineCache
+//-----------------------------------------------------------------------------
+bool TestEngineCache()
+{
+   bool flag = true;
+
+   // Hits return exactly the computed result.
+   {
+      EngineCache Cache( 1 << 24 );
+      EngineInput In = Site( 0 );
+
+      EngineReturn S  = Engine( In );
+      EngineReturn R1 = Cache.Engine( In );
+      EngineReturn R2 = Cache.Engine( In );
+
+      flag &= Same( R1, S ) && Same( R2, S ) && ( R1.a != R2.a );
+
+      EngineCacheStats Stats = Cache.Stats();
+      flag &= ( Stats.Misses == 1 && Stats.Hits == 1 && Stats.Entries == 1 );
+
+      FreeRealizations( S );
+      FreeRealizations( R1 );
+      FreeRealizations( R2 );
+
+      // Any change to the input is a different key.
+      In.Seed = 4;
+      flag &= ( EngineInputHash( In ) != EngineInputHash( Site( 0 ) ) );
+      EngineReturn R3 = Cache.Engine( In );
+      FreeRealizations( R3 );
+      flag &= ( Cache.Stats().Misses == 2 );
+
+      // Kept derived quantities are not cached.
+      In.Options.KeepDerived = true;
+      EngineReturn R4 = Cache.Engine( In );
+      FreeRealizations( R4 );
+      flag &= ( Cache.Stats().Bypassed == 1 && Cache.Stats().Entries == 2 );
+
+      // Nor are instrumented runs: each measures itself.
+      In.Options.KeepDerived = false;
+      In.Seed = 3;
+      In.Options.Instrument = true;
+      EngineReturn R5 = Cache.Engine( In );
+      flag &= R5.Instrumentation.Valid && ( Cache.Stats().Bypassed == 2 && Cache.Stats().Hits == 1 );
+      FreeRealizations( R5 );
+
+      // Failures are not cached.
+      bool singular = false;
+      try { Cache.Engine( Site( 1, 4 ) ); } catch( Exception_SingularSystem& ) { singular = true; }
+      flag &= singular && ( Cache.Stats().Misses == 2 && Cache.Stats().Entries == 2 );
+
+      flag &= Cache.Erase( Site( 0 ) ) && !Cache.Erase( Site( 0 ) );
+      flag &= ( Cache.Stats().Entries == 1 );
+   }
+
+   // Least recently used eviction: room for two entries.
+   {
+      EngineCache Probe( 1 << 24 );
+      EngineReturn R = Probe.Engine( Site( 0 ) );
+      FreeRealizations( R );
+      const std::size_t one = Probe.Stats().Bytes;
+
+      EngineCache Cache( 2*one + one/2 );
+      int order[] = { 0, 1, 2, 1, 0, 1, 2 };
+      bool hit[]  = { false, false, false, true, false, true, false };
+
+      for (int i=0; i<7; ++i)
+      {
+         long hits = Cache.Stats().Hits;
+         EngineReturn R = Cache.Engine( Site( order[i] ) );
+         FreeRealizations( R );
+         flag &= ( (Cache.Stats().Hits > hits) == hit[i] );
+      }
+
+      EngineCacheStats Stats = Cache.Stats();
+      flag &= ( Stats.Entries == 2 && Stats.Evictions == 3 && Stats.Bytes <= 2*one + one/2 );
+
+      Cache.Clear();
+      flag &= ( Cache.Stats().Entries == 0 && Cache.Stats().Bytes == 0 );
+   }
+
+#ifdef ONEKA_ENGINE_JOBS
+   // Shared by plain threads: every call is counted exactly once, and the
+   // tier holds each input once.
+   {
+      EngineCache Cache( 1 << 24 );
+      const int nThreads = 4;
+      const int nCalls = 30;
+
+      std::vector<std::thread> Threads;
+      for (int t=0; t<nThreads; ++t)
+         Threads.push_back( std::thread( [&Cache, t]()
+         {
+            for (int i=0; i<nCalls; ++i)
+            {
+               oneka::EngineInput In = Site( (i + t) % 3 );
+               In.Options.KeepDerived = ( i % 5 == 4 );
+               EngineReturn R = Cache.Engine( In );
+               FreeRealizations( R );
+            }
+         } ) );
+      for (int t=0; t<nThreads; ++t)
+         Threads[t].join();
+
+      EngineCacheStats Stats = Cache.Stats();
+      flag &= ( Stats.Hits + Stats.Misses + Stats.Bypassed == nThreads*nCalls );
+      flag &= ( Stats.Bypassed == nThreads*nCalls/5 && Stats.Entries == 3 );
+   }
+#endif
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEngineCacheDisk
+//-----------------------------------------------------------------------------
+bool TestEngineCacheDisk()
+{
+   bool flag = true;
+
+   EngineInput In = Site( 5, 10, 1000 );
+   EngineReturn S = Engine( In );
+
+   // Written through by a cache with no memory tier ...
+   {
+      EngineCache Cache( 0, "." );
+      EngineReturn R = Cache.Engine( In );
+      flag &= Same( R, S ) && ( Cache.Stats().Misses == 1 && Cache.Stats().Entries == 0 );
+      FreeRealizations( R );
+   }
+
+   // ... read back, and promoted to memory, by another.
+   {
+      EngineCache Cache( 1 << 24, "." );
+      EngineReturn R1 = Cache.Engine( In );
+      EngineReturn R2 = Cache.Engine( In );
+      flag &= Same( R1, S ) && Same( R2, S );
+
+      EngineCacheStats Stats = Cache.Stats();
+      flag &= ( Stats.DiskHits == 1 && Stats.Hits == 1 && Stats.Misses == 0 );
+
+      FreeRealizations( R1 );
+      FreeRealizations( R2 );
+
+      flag &= Cache.Erase( In );
+   }
+
+   // Erased from disk too.
+   {
+      EngineCache Cache( 0, "." );
+      EngineReturn R = Cache.Engine( In );
+      flag &= ( Cache.Stats().Misses == 1 && Cache.Stats().DiskHits == 0 );
+      FreeRealizations( R );
+      flag &= Cache.Erase( In );
+   }
+
+   FreeRealizations( S );
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,231 @@
+//=============================================================================
+// test_engine_jobs.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_engine_jobs.h"
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "..\Engine\engine_jobs.h"
+#include "utility.h"
+
+#ifdef ONEKA_ENGINE_JOBS
+namespace{
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   oneka::EngineInput Site( int i, int nSims )
+   {
+      oneka::EngineInput In;
+      In.k    = 1.0 + 0.1*i;
+      In.H    = 50;
+      In.Base = 0;
+      In.W    = 2;
+      In.Xw   = Xw;
+      In.Yw   = Yw;
+      In.Qw   = Qw;
+      In.P    = (i == 3) ? 4 : 10;
+      In.Xp   = Xp;
+      In.Yp   = Yp;
+      In.Ep   = Ep;
+      In.Sp   = Sp;
+      In.Xo   = 10;
+      In.Yo   = -20;
+      In.nSims  = nSims;
+      In.Seed   = 7;
+      In.Stream = i;
+      return In;
+   }
+
+   void FreeRealizations( oneka::EngineReturn& S )
+   {
+      for (int i=0; i<S.nSims; ++i)
+         delete [] S.a[i];
+      delete [] S.a;
+   }
+
+   // The caller's own monitor: records the progress, and may cancel.
+   class CallerMonitor : public oneka::EngineMonitor
+   {
+   public:
+      explicit CallerMonitor( bool cancel ) : m_Cancel( cancel ), m_nDone( 0 ) {}
+
+      bool Cancelled() { return m_Cancel; }
+      void Progress( int nDone, int /*nSims*/ ) { m_nDone = nDone; }
+
+      bool m_Cancel;
+      int m_nDone;
+   };
+}
+#endif
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestEnginePool
+//-----------------------------------------------------------------------------
+bool TestEnginePool()
+{
+   bool flag = true;
+
+#ifdef ONEKA_ENGINE_JOBS
+   // Results match the synchronous Engine; failures are delivered by Get.
+   {
+      EnginePool Pool( 3 );
+      flag &= ( Pool.nThreads() == 3 );
+
+      const int nJobs = 8;
+      std::vector<EngineJob> Jobs;
+      for (int i=0; i<nJobs; ++i)
+         Jobs.push_back( Pool.Submit( Site( i, 100 + 10*i ) ) );
+
+      for (int i=0; i<nJobs; ++i)
+      {
+         if( i == 3 )
+         {
+            bool singular = false;
+            try { Jobs[i].Get(); } catch( Exception_SingularSystem& ) { singular = true; }
+            flag &= singular;
+            continue;
+         }
+
+         EngineReturn R = Jobs[i].Get();
+         EngineReturn S = Engine( Site( i, 100 + 10*i ) );
+
+         flag &= Jobs[i].Ready() && ( Jobs[i].Progress() == 1.0 );
+         flag &= ( R.nSims == S.nSims );
+         for (int s=0; s<S.nSims; ++s)
+            for (int j=0; j<6; ++j)
+               flag &= ( R.a[s][j] == S.a[s][j] );
+
+         FreeRealizations( R );
+         FreeRealizations( S );
+      }
+   }
+
+   // Cancellation: a queued job never starts; a running job stops at its 
+   // next chunk, or finishes.
+   {
+      EnginePool Pool( 1 );
+
+      EngineJob Big    = Pool.Submit( Site( 0, 400000 ) );
+      EngineJob Queued = Pool.Submit( Site( 1, 10 ) );
+      Queued.Cancel();
+
+      while( !Big.Ready() && Big.Progress() == 0.0 ) 
+         std::this_thread::yield();
+      Big.Cancel();
+
+      try 
+      { 
+         EngineReturn R = Big.Get(); 
+         flag &= ( R.nSims == 400000 );
+         FreeRealizations( R );
+      } 
+      catch( Exception_Cancelled& ) 
+      {
+         flag &= ( Big.Progress() < 1.0 );
+      }
+
+      bool cancelled = false;
+      try { Queued.Get(); } catch( Exception_Cancelled& ) { cancelled = true; }
+      flag &= cancelled && ( Queued.Progress() == 0.0 );
+   }
+
+   // The caller's monitor is kept: it receives the progress, and it can 
+   // cancel the job.
+   {
+      EnginePool Pool( 1 );
+
+      CallerMonitor Reports( false );
+      EngineInput In = Site( 0, 50000 );
+      In.Options.Monitor = &Reports;
+
+      EngineReturn R = Pool.Submit( In ).Get();
+      flag &= ( R.nSims == 50000 && Reports.m_nDone == 50000 );
+      FreeRealizations( R );
+
+      CallerMonitor Stop( true );
+      In.Options.Monitor = &Stop;
+
+      bool cancelled = false;
+      try { Pool.Submit( In ).Get(); } catch( Exception_Cancelled& ) { cancelled = true; }
+      flag &= cancelled;
+   }
+
+   // The result is taken once; a result never taken is freed with the job.
+   {
+      EnginePool Pool( 2 );
+
+      EngineJob Job = Pool.Submit( Site( 0, 100 ) );
+      EngineJob Copy = Job;
+      EngineReturn R = Job.Get();
+      flag &= ( R.nSims == 100 && R.a != NULL );
+      FreeRealizations( R );
+
+      bool retrieved = false;
+      try { Copy.Get(); } 
+      catch( std::future_error& e ) { retrieved = ( e.code() == std::future_errc::future_already_retrieved ); }
+      flag &= retrieved;
+
+      EngineJob Dropped = Pool.Submit( Site( 1, 100 ) );
+      Dropped.Wait();
+      Dropped.Cancel();
+   }
+
+   // A handle that refers to no job.
+   {
+      EngineJob None;
+      None.Cancel();
+      flag &= !None.Valid() && !None.Ready() && ( None.Progress() == 0.0 );
+
+      bool thrown = false;
+      try { None.Get(); } catch( std::future_error& ) { thrown = true; }
+      flag &= thrown;
+   }
+#endif
+
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,238 @@
+//=============================================================================
+// test_engine_protocol.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_engine_protocol.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "..\Engine\engine_protocol.h"
+#include "utility.h"
+
+namespace{
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5 };
+
+   bool SameArray( const double* a, const double* b, int n )
+   {
+      for (int i=0; i<n; ++i)
+         if (a[i] != b[i]) return false;
+      return true;
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestEngineRequestCoding
+//-----------------------------------------------------------------------------
+bool TestEngineRequestCoding()
+{
+   bool flag = true;
+
+   EngineInput In;
+   In.k    = 1.5;
+   In.H    = 50;
+   In.Base = -3;
+   In.W    = 2;
+   In.Xw   = Xw;
+   In.Yw   = Yw;
+   In.Qw   = Qw;
+   In.P    = 8;
+   In.Xp   = Xp;
+   In.Yp   = Yp;
+   In.Ep   = Ep;
+   In.Sp   = Sp;
+   In.Xo   = 10;
+   In.Yo   = -20;
+   In.nSims  = 250;
+   In.Seed   = 0x123456789abcdefULL;
+   In.Stream = 17;
+   In.Options.CollapseReadings = true;
+   In.Options.UsePrior = true;
+   for (int i=0; i<6; ++i)
+   {
+      In.Options.PriorMu[i] = i + 0.5;
+      for (int j=0; j<6; ++j)
+         In.Options.PriorCov[i][j] = (i == j) ? 4.0 : 0.25;
+   }
+
+   std::vector<char> Body;
+   EncodeRequest( In, Body );
+
+   EngineRequest Request;
+   flag &= DecodeRequest( &Body[0], Body.size(), Request );
+
+   EngineInput Out = Request.Input();
+   flag &= ( Out.k == In.k && Out.H == In.H && Out.Base == In.Base );
+   flag &= ( Out.W == In.W && Out.P == In.P );
+   flag &= SameArray( Out.Xw, Xw, 2 ) && SameArray( Out.Yw, Yw, 2 ) && SameArray( Out.Qw, Qw, 2 );
+   flag &= SameArray( Out.Xp, Xp, 8 ) && SameArray( Out.Yp, Yp, 8 );
+   flag &= SameArray( Out.Ep, Ep, 8 ) && SameArray( Out.Sp, Sp, 8 );
+   flag &= ( Out.Xo == In.Xo && Out.Yo == In.Yo && Out.nSims == In.nSims );
+   flag &= ( Out.Seed == In.Seed && Out.Stream == In.Stream );
+   flag &= ( Out.Options.CollapseReadings && Out.Options.UsePrior );
+   flag &= SameArray( Out.Options.PriorMu, In.Options.PriorMu, 6 );
+   flag &= SameArray( &Out.Options.PriorCov[0][0], &In.Options.PriorCov[0][0], 36 );
+
+   // Without the prior, the prior is not sent.
+   std::vector<char> Short;
+   In.Options.UsePrior = false;
+   EncodeRequest( In, Short );
+   flag &= ( Short.size() + 42*sizeof(double) == Body.size() );
+
+   // Malformed bodies are rejected.
+   flag &= !DecodeRequest( &Body[0], Body.size() - 1, Request );
+
+   Body.push_back( 0 );
+   flag &= !DecodeRequest( &Body[0], Body.size(), Request );
+
+   std::vector<char> Huge;
+   In.W = 1 << 28;
+   EncodeRequest( EngineInput(), Huge );
+   std::memcpy( &Huge[3*sizeof(double)], &In.W, sizeof(int) );
+   flag &= !DecodeRequest( &Huge[0], Huge.size(), Request );
+
+   // So are requests beyond the limits.
+   EngineInput Big;
+   Big.nSims = PROTOCOL_MAX_SIMS + 1;
+   EncodeRequest( Big, Huge );
+   flag &= !DecodeRequest( &Huge[0], Huge.size(), Request );
+
+   Big.nSims = PROTOCOL_MAX_SIMS;
+   EncodeRequest( Big, Huge );
+   flag &= DecodeRequest( &Huge[0], Huge.size(), Request );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEngineResponseCoding
+//-----------------------------------------------------------------------------
+bool TestEngineResponseCoding()
+{
+   bool flag = true;
+
+   EngineReturn S;
+   S.Version = "18 July 2011";
+   S.RunTime = "Sat Oct 17 12:00:00 2026";
+   S.Xo = 10;
+   S.Yo = -20;
+   S.Seed = 0xfedcba9876543210ULL;
+   S.Stream = 42;
+   for (int i=0; i<6; ++i)
+   {
+      S.Mu[i] = 1.0/(i+1);
+      for (int j=0; j<6; ++j)
+         S.Cov[i][j] = (i == j) ? 2.0 : 0.1*(i+j);
+   }
+   S.nSims = 5;
+   S.a = new double*[S.nSims];
+   for (int i=0; i<S.nSims; ++i)
+   {
+      S.a[i] = new double[6];
+      for (int j=0; j<6; ++j)
+         S.a[i][j] = 10*i + j;
+   }
+
+   // Inline realizations.
+   {
+      std::vector<char> Body;
+      EncodeResponse( ENGINE_OK, S, "", Body );
+
+      int Status = -99;
+      EngineReturn R;
+      std::string Segment;
+      flag &= DecodeResponse( &Body[0], Body.size(), Status, R, Segment );
+
+      flag &= ( Status == ENGINE_OK && Segment.empty() );
+      flag &= ( R.Version == S.Version && R.RunTime == S.RunTime );
+      flag &= ( R.Xo == S.Xo && R.Yo == S.Yo );
+      flag &= ( R.Seed == S.Seed && R.Stream == S.Stream );
+      flag &= SameArray( R.Mu, S.Mu, 6 ) && SameArray( &R.Cov[0][0], &S.Cov[0][0], 36 );
+      flag &= ( R.nSims == S.nSims && R.a != NULL );
+      for (int i=0; i<R.nSims; ++i)
+      {
+         flag &= SameArray( R.a[i], S.a[i], 6 );
+         delete [] R.a[i];
+      }
+      delete [] R.a;
+
+      flag &= !DecodeResponse( &Body[0], Body.size() - 8, Status, R, Segment );
+   }
+
+   // Realizations in a shared memory segment.
+   {
+      std::vector<char> Body;
+      EncodeResponse( ENGINE_OK, S, "/oneka-test", Body );
+
+      int Status = -99;
+      EngineReturn R;
+      std::string Segment;
+      flag &= DecodeResponse( &Body[0], Body.size(), Status, R, Segment );
+      flag &= ( Status == ENGINE_OK && Segment == "/oneka-test" );
+      flag &= ( R.nSims == S.nSims && R.a == NULL );
+   }
+
+   // A failed run carries no realizations.
+   {
+      std::vector<char> Body;
+      EncodeResponse( ENGINE_SINGULAR, EngineReturn(), "", Body );
+
+      int Status = -99;
+      EngineReturn R;
+      std::string Segment;
+      flag &= DecodeResponse( &Body[0], Body.size(), Status, R, Segment );
+      flag &= ( Status == ENGINE_SINGULAR && R.nSims == 0 && R.a == NULL );
+   }
+
+   for (int i=0; i<S.nSims; ++i)
+      delete [] S.a[i];
+   delete [] S.a;
+
+   return flag;
+}
+
+} // namespace oneka
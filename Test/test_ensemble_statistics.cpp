@@ -0,0 +1,297 @@
+//=============================================================================
+// test_ensemble_statistics.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_ensemble_statistics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "..\Engine\ensemble_statistics.h"
+#include "..\Engine\gaussian.h"
+#include "..\Engine\head_field.h"
+#include "..\Engine\point_set.h"
+#include "utility.h"
+
+namespace{
+   const double TOLERANCE = 1e-9;
+
+   //--------------------------------------------------------------------------
+   // An (M x N) ensemble of Gaussian fields, with a different mean and 
+   // standard deviation at each point.
+   //--------------------------------------------------------------------------
+   void MakeEnsemble( int M, int N, oneka::Matrix& X )
+   {
+      oneka::InitializeRNG( 1234 );
+      oneka::GaussianRNG( M, N, X );
+
+      for (int i=0; i<M; ++i)
+         for (int j=0; j<N; ++j)
+            X(i,j) = 10.0*j + (1.0 + j)*X(i,j);
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestEnsembleStatistics
+//-----------------------------------------------------------------------------
+bool TestEnsembleStatistics()
+{
+   bool flag = true;
+
+   const int M = 4000;
+   const int N = 3;
+   Matrix X;
+   MakeEnsemble( M, N, X );
+
+   const double thresholds[] = { 0.0, 12.0 };
+   const double probabilities[] = { 0.1, 0.5, 0.9 };
+   EnsembleStatistics S( N, 2, thresholds, 3, probabilities );
+
+   for (int i=0; i<M; i+=1000)
+   {
+      Matrix Chunk( 1000, N, X.Base(i,0) );
+      S.Add( Chunk );
+   }
+
+   flag &= (S.Count() == M);
+
+   Matrix Mean, Var, Lo, Hi, Exceed, Q;
+   S.Mean( Mean );
+   S.Variance( Var );
+   S.Min( Lo );
+   S.Max( Hi );
+   S.Exceedance( Exceed );
+   S.Quantiles( Q );
+
+   for (int j=0; j<N; ++j)
+   {
+      std::vector<double> x( M );
+      double sum = 0, sumsq = 0;
+      int count0 = 0, count1 = 0;
+
+      for (int i=0; i<M; ++i)
+      {
+         x[i] = X(i,j);
+         sum += x[i];
+         count0 += (x[i] > thresholds[0]) ? 1 : 0;
+         count1 += (x[i] > thresholds[1]) ? 1 : 0;
+      }
+      double mean = sum/M;
+      for (int i=0; i<M; ++i) sumsq += (x[i]-mean)*(x[i]-mean);
+
+      std::sort( x.begin(), x.end() );
+
+      flag &= RelativeEqual( Mean(0,j), mean, TOLERANCE );
+      flag &= RelativeEqual( Var(0,j), sumsq/(M-1), TOLERANCE );
+      flag &= (Lo(0,j) == x[0]);
+      flag &= (Hi(0,j) == x[M-1]);
+      flag &= ApproxEqual( Exceed(0,j), double(count0)/M, TOLERANCE );
+      flag &= ApproxEqual( Exceed(1,j), double(count1)/M, TOLERANCE );
+
+      // The P-squared estimates are approximate: compare them to the sample
+      // quantiles relative to the spread of the data.
+      for (int k=0; k<3; ++k)
+      {
+         double exact = x[ static_cast<int>(probabilities[k]*(M-1)) ];
+         flag &= ApproxEqual( Q(k,j), exact, 0.05*(1.0 + j) );
+      }
+   }
+
+   // Fewer than five realizations gives the exact sample quantiles.
+   EnsembleStatistics T( N, 0, 0, 1, probabilities+1 );
+   for (int i=0; i<3; ++i) T.Add( X.Base(i,0) );
+   T.Quantiles( Q );
+
+   for (int j=0; j<N; ++j)
+   {
+      double v[] = { X(0,j), X(1,j), X(2,j) };
+      std::sort( v, v+3 );
+      flag &= (Q(0,j) == v[1]);
+   }
+
+   // So do exactly five.
+   const double tails[] = { 0.05, 0.95 };
+   const double five[] = { 3, 1, 5, 2, 4 };
+   EnsembleStatistics F( 1, 0, 0, 2, tails );
+   for (int i=0; i<5; ++i) F.Add( five+i );
+   F.Quantiles( Q );
+   flag &= ApproxEqual( Q(0,0), 1.2, 1e-12 ) && ApproxEqual( Q(1,0), 4.8, 1e-12 );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEnsembleStatisticsMerge
+//-----------------------------------------------------------------------------
+bool TestEnsembleStatisticsMerge()
+{
+   bool flag = true;
+
+   const int M = 3000;
+   const int N = 4;
+   Matrix X;
+   MakeEnsemble( M, N, X );
+
+   const double thresholds[] = { 15.0 };
+   const double probabilities[] = { 0.25, 0.75 };
+
+   EnsembleStatistics All( N, 1, thresholds, 2, probabilities );
+   EnsembleStatistics First( All ), Second( All ), Tiny( All );
+
+   for (int i=0; i<M; ++i)
+   {
+      All.Add( X.Base(i,0) );
+      if (i < 1000) 
+         First.Add( X.Base(i,0) );
+      else if (i < M-2)
+         Second.Add( X.Base(i,0) );
+      else
+         Tiny.Add( X.Base(i,0) );
+   }
+
+   First.Merge( Second );
+   First.Merge( Tiny );
+
+   flag &= (First.Count() == M);
+
+   Matrix A, B;
+
+   All.Mean( A );  First.Mean( B );
+   flag &= ApproxEqual( A, B, 1e-9 );
+
+   All.Variance( A );  First.Variance( B );
+   flag &= ApproxEqual( A, B, 1e-7 );
+
+   All.Min( A );  First.Min( B );
+   flag &= ApproxEqual( A, B, 0 );
+
+   All.Max( A );  First.Max( B );
+   flag &= ApproxEqual( A, B, 0 );
+
+   All.Exceedance( A );  First.Exceedance( B );
+   flag &= ApproxEqual( A, B, TOLERANCE );
+
+   All.Quantiles( A );  First.Quantiles( B );
+   for (int j=0; j<N; ++j)
+   {
+      flag &= ApproxEqual( A(0,j), B(0,j), 0.2*(1.0 + j) );
+      flag &= ApproxEqual( A(1,j), B(1,j), 0.2*(1.0 + j) );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestAccumulateHeads
+//-----------------------------------------------------------------------------
+bool TestAccumulateHeads()
+{
+   bool flag = true;
+
+   const double k = 1.0;
+   const double H = 50.0;
+   const double Base = 0.0;
+
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30.0 };
+
+   PointSet S( -95.0, -95.0, 10.0, 10.0, 20, 20, 1, Xw, Yw, Qw, 0.0, 0.0 );
+
+   // Realizations about the coefficients of TestEngine.
+   const int nSims = 500;
+   Matrix Mu( "-0.01, -0.01, 0.001, -2.0, 1.0, 1300.0" );
+   Matrix Sigma( 6, 6 );
+   Sigma(0,0) = 1e-5;   Sigma(1,1) = 1e-5;   Sigma(2,2) = 1e-6;
+   Sigma(3,3) = 0.04;   Sigma(4,4) = 0.04;   Sigma(5,5) = 2500.0;
+
+   Matrix X;
+   InitializeRNG( 4321 );
+   MVNormalRNG( nSims, Mu, Sigma, X );
+
+   std::vector< double* > a( nSims );
+   for (int i=0; i<nSims; ++i) a[i] = X.Base(i,0);
+
+   const double thresholds[] = { 44.0 };
+   const double probabilities[] = { 0.5 };
+
+   EnsembleStatistics Stats( S.nPoints(), 1, thresholds, 1, probabilities );
+   AccumulateHeads( S, k, H, Base, nSims, &a[0], Stats, 3 );
+
+   EnsembleStatistics Direct( Stats );
+   Direct.Clear();
+
+   Matrix Heads;
+   EvaluateHeads( S, k, H, Base, nSims, &a[0], Heads );
+   Direct.Add( Heads );
+
+   flag &= (Stats.Count() == nSims);
+
+   Matrix A, B;
+
+   Stats.Mean( A );  Direct.Mean( B );
+   flag &= ApproxEqual( A, B, 1e-9 );
+
+   Stats.Variance( A );  Direct.Variance( B );
+   flag &= ApproxEqual( A, B, 1e-9 );
+
+   Stats.Exceedance( A );  Direct.Exceedance( B );
+   flag &= ApproxEqual( A, B, TOLERANCE );
+
+   // The result is reproducible.
+   EnsembleStatistics Again( Direct );
+   Again.Clear();
+   AccumulateHeads( S, k, H, Base, nSims, &a[0], Again, 3 );
+
+   Stats.Quantiles( A );  Again.Quantiles( B );
+   flag &= ApproxEqual( A, B, 0 );
+
+   // So is the default, which uses 16 blocks on any machine.
+   Stats.Clear();
+   Again.Clear();
+   AccumulateHeads( S, k, H, Base, nSims, &a[0], Stats );
+   AccumulateHeads( S, k, H, Base, nSims, &a[0], Again, 16 );
+
+   Stats.Quantiles( A );  Again.Quantiles( B );
+   flag &= ApproxEqual( A, B, 0 );
+
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,239 @@
+//=============================================================================
+// test_fitted_model.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_fitted_model.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\fitted_model.h"
+#include "..\Engine\oneka_engine.h"
+#include "utility.h"
+
+namespace{
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   const int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   const int P = 10;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   double Xo = 10;
+   double Yo = -20;
+
+   // Compare the fitted model against Engine using the listed piezometers.
+   bool Compare( const oneka::FittedModel& M, int n, const int* ids, const double* E )
+   {
+      double xp[P], yp[P], ep[P], sp[P];
+      for (int i=0; i<n; ++i)
+      {
+         xp[i] = Xp[ids[i]];
+         yp[i] = Yp[ids[i]];
+         ep[i] = E[ids[i]];
+         sp[i] = Sp[ids[i]];
+      }
+
+      oneka::EngineReturn S = oneka::Engine( k, H, Base, W, Xw, Yw, Qw, n, xp, yp, ep, sp, Xo, Yo, 1 );
+      delete [] S.a[0];
+      delete [] S.a;
+
+      double Mu[6], Cov[6][6];
+      M.Solve( Mu, Cov );
+
+      bool flag = true;
+      for (int i=0; i<6; ++i)
+      {
+         flag &= oneka::ApproxEqual( Mu[i], S.Mu[i], 1e-8*(1 + fabs(S.Mu[i])) );
+         for (int j=0; j<6; ++j)
+            flag &= oneka::ApproxEqual( Cov[i][j], S.Cov[i][j], 1e-8*sqrt(S.Cov[i][i]*S.Cov[j][j]) );
+      }
+      return flag;
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestFittedModel
+//-----------------------------------------------------------------------------
+bool TestFittedModel()
+{
+   bool flag = true;
+
+   FittedModel M( k, H, Base, W, Xw, Yw, Qw, Xo, Yo );
+
+   // Too few piezometers.
+   for (int p=0; p<5; ++p)
+      flag &= M.Add( p, Xp[p], Yp[p], Ep[p], Sp[p] );
+
+   bool singular = false;
+   try
+   {
+      double Mu[6], Cov[6][6];
+      M.Solve( Mu, Cov );
+   }
+   catch( Exception_SingularSystem& )
+   {
+      singular = true;
+   }
+   flag &= singular;
+
+   // Add the rest, one at a time.
+   for (int p=5; p<P; ++p)
+      flag &= M.Add( p, Xp[p], Yp[p], Ep[p], Sp[p] );
+
+   flag &= ( M.nPiezometers() == P );
+   flag &= !M.Add( 3, 0, 0, 0, 1 );
+
+   const int all[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+   flag &= Compare( M, P, all, Ep );
+
+   // Remove two piezometers.
+   flag &= M.Remove( 2 );
+   flag &= M.Remove( 8 );
+   flag &= !M.Remove( 8 );
+
+   const int some[] = { 0, 1, 3, 4, 5, 6, 7, 9 };
+   flag &= Compare( M, 8, some, Ep );
+
+   // Correct a reading.
+   double E[P];
+   for (int p=0; p<P; ++p) E[p] = Ep[p];
+   E[4] = 52.90;
+
+   flag &= M.Update( 4, E[4], Sp[4] );
+   flag &= !M.Update( 2, E[2], Sp[2] );
+   flag &= Compare( M, 8, some, E );
+
+   // Put one back, and compare with a fresh factorization.
+   flag &= M.Add( 2, Xp[2], Yp[2], E[2], Sp[2] );
+
+   const int back[] = { 0, 1, 2, 3, 4, 5, 6, 7, 9 };
+   flag &= Compare( M, 9, back, E );
+
+   M.Refactor();
+   flag &= Compare( M, 9, back, E );
+
+   // Removing down to rank deficiency, and back up again.
+   for (int p=0; p<P; ++p) 
+      M.Remove( p );
+   flag &= ( M.nPiezometers() == 0 );
+
+   for (int p=0; p<P; ++p)
+      flag &= M.Add( p, Xp[p], Yp[p], Ep[p], Sp[p] );
+   flag &= Compare( M, P, all, Ep );
+
+   // Realizations.
+   Matrix X;
+   M.Simulate( 10, X );
+   flag &= ( X.nRows() == 10 && X.nCols() == 6 );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestFittedModelPrior
+//
+//    Fitting a first round of readings, and then using that posterior as 
+//    the prior for a second round, must agree with fitting both rounds at
+//    once.
+//-----------------------------------------------------------------------------
+bool TestFittedModelPrior()
+{
+   bool flag = true;
+
+   // First round.
+   FittedModel First( k, H, Base, W, Xw, Yw, Qw, Xo, Yo );
+   for (int p=0; p<6; ++p)
+      First.Add( p, Xp[p], Yp[p], Ep[p], Sp[p] );
+
+   double Mu0[6], Cov0[6][6];
+   First.Solve( Mu0, Cov0 );
+
+   // Second round, with the prior.
+   FittedModel M( k, H, Base, W, Xw, Yw, Qw, Xo, Yo );
+   flag &= M.SetPrior( Mu0, Cov0 );
+   flag &= M.HasPrior();
+
+   for (int p=6; p<P; ++p)
+      M.Add( p, Xp[p], Yp[p], Ep[p], Sp[p] );
+
+   const int all[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+   flag &= Compare( M, P, all, Ep );
+
+   M.Refactor();
+   flag &= Compare( M, P, all, Ep );
+
+   // Replacing the prior by itself changes nothing.
+   flag &= M.SetPrior( Mu0, Cov0 );
+   flag &= Compare( M, P, all, Ep );
+
+   // An invalid prior is refused.
+   double Bad[6][6];
+   for (int i=0; i<6; ++i)
+      for (int j=0; j<6; ++j)
+         Bad[i][j] = 1.0;
+   flag &= !M.SetPrior( Mu0, Bad );
+   flag &= Compare( M, P, all, Ep );
+
+   // Without the prior, four readings do not determine the model.
+   M.ClearPrior();
+   flag &= !M.HasPrior();
+
+   bool singular = false;
+   try
+   {
+      double Mu[6], Cov[6][6];
+      M.Solve( Mu, Cov );
+   }
+   catch( Exception_SingularSystem& )
+   {
+      singular = true;
+   }
+   flag &= singular;
+
+   return flag;
+}
+
+} // namespace oneka
@@ -192,5 +192,66 @@ bool TestMVNormalRNG()
    return flag;
 }
 
+//-----------------------------------------------------------------------------
+// TestRandomStream
+//-----------------------------------------------------------------------------
+bool TestRandomStream()
+{
+   bool flag = true;
+
+   // Reproducible, and independent of other streams.
+   {
+      RandomStream A( 1234, 7 ), B( 1234, 7 ), C( 1234, 8 ), D( 1235, 7 );
+      flag &= ( A.Seed() == 1234 && A.Stream() == 7 );
+
+      int nSameC = 0, nSameD = 0;
+      for (int i=0; i<1000; ++i)
+      {
+         unsigned int a = A.Next();
+         flag &= ( a == B.Next() );
+         nSameC += ( a == C.Next() );
+         nSameD += ( a == D.Next() );
+      }
+      flag &= ( nSameC < 3 && nSameD < 3 );
+   }
+
+   // Uniform moments.
+   {
+      RandomStream R( 42, 0 );
+      const int M = 100000;
+
+      double sum = 0, sum2 = 0;
+      for (int i=0; i<M; ++i)
+      {
+         double u = R.Uniform();
+         flag &= ( u >= 0 && u < 1 );
+         sum  += u;
+         sum2 += u*u;
+      }
+      flag &= ApproxEqual( sum/M, 0.5, 3.29*sqrt(1.0/12/M) );
+      flag &= ApproxEqual( sum2/M, 1.0/3, 3.29*sqrt(4.0/45/M) );
+   }
+
+   // MVNormalRNG from a stream is reproducible, with the right mean.
+   {
+      const int M = 100000;
+      Matrix Mu("1,2,3");
+      Matrix Sigma("4,1,-1; 1,3,0; -1,0,2");
+
+      RandomStream R1( 99, 3 ), R2( 99, 3 );
+      Matrix X1, X2;
+      flag &= MVNormalRNG( R1, M, Mu, Sigma, X1 );
+      flag &= MVNormalRNG( R2, M, Mu, Sigma, X2 );
+      flag &= ApproxEqual( X1, X2, 0.0 );
+
+      Matrix Xbar(1,3);
+      ColumnSum(X1,Xbar);
+      for (int j=0; j<3; ++j)
+         flag &= ApproxEqual( Xbar(0,j)/M, Mu(0,j), 3.29*sqrt(Sigma(j,j)/M) );
+   }
+
+   return flag;
+}
+
 
-} // namespace oneka
\ No newline at end of file
+} // namespace oneka
@@ -45,6 +45,7 @@ namespace oneka{
 bool TestGaussianCDF();
 bool TestGaussianRNG();
 bool TestMVNormalRNG();
+bool TestRandomStream();
 
 
 } // namespace onkea
@@ -0,0 +1,205 @@
+//=============================================================================
+// test_head_field.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_head_field.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\head_field.h"
+#include "..\Engine\oneka_model.h"
+#include "..\Engine\point_set.h"
+#include "utility.h"
+
+namespace{
+   const double TOLERANCE = 1e-9;
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestPhiToHead
+//-----------------------------------------------------------------------------
+bool TestPhiToHead()
+{
+   bool flag = true;
+
+   const double k = 2.0;
+   const double H = 50.0;
+   const double Base = 100.0;
+
+   // Unconfined, confined, and exactly at the top of the aquifer.
+   const double heads[] = { 110.0, 149.0, 150.0, 175.0 };
+
+   for (int i=0; i<4; ++i)
+   {
+      double Phi = HeadToPhi( heads[i], k, H, Base );
+      flag &= ApproxEqual( PhiToHead( Phi, k, H, Base ), heads[i], TOLERANCE );
+   }
+
+   flag &= ApproxEqual( HeadToPhi( 110.0, k, H, Base ), 100.0, TOLERANCE );
+   flag &= ApproxEqual( HeadToPhi( 175.0, k, H, Base ), 5000.0, TOLERANCE );
+
+   // A dry aquifer.
+   flag &= ApproxEqual( PhiToHead( -1.0, k, H, Base ), Base, TOLERANCE );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestPointSet
+//-----------------------------------------------------------------------------
+bool TestPointSet()
+{
+   bool flag = true;
+
+   double Xw[] = { 10.0 };
+   double Yw[] = { 20.0 };
+   double Qw[] = { 30.0 };
+
+   PointSet S( -100.0, 50.0, 25.0, 10.0, 3, 2, 1, Xw, Yw, Qw, 5.0, -5.0 );
+
+   flag &= (S.nPoints() == 6);
+
+   // Node in row 1, column 2.
+   flag &= ApproxEqual( S.X()[5], -50.0, TOLERANCE );
+   flag &= ApproxEqual( S.Y()[5],  60.0, TOLERANCE );
+
+   flag &= ApproxEqual( S.Basis(0)[5], 55.0*55.0, TOLERANCE );
+   flag &= ApproxEqual( S.Basis(1)[5], 65.0*65.0, TOLERANCE );
+   flag &= ApproxEqual( S.Basis(2)[5], -55.0*65.0, TOLERANCE );
+   flag &= ApproxEqual( S.Basis(3)[5], -55.0, TOLERANCE );
+   flag &= ApproxEqual( S.Basis(4)[5],  65.0, TOLERANCE );
+   flag &= ApproxEqual( S.Basis(5)[5],   1.0, TOLERANCE );
+   flag &= ApproxEqual( S.Phiw()[5], WellPotential( -50.0, 60.0, 1, Xw, Yw, Qw ), TOLERANCE );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEvaluateHeads
+//-----------------------------------------------------------------------------
+bool TestEvaluateHeads()
+{
+   bool flag = true;
+
+   const double k = 1.0;
+   const double H = 50.0;
+   const double Base = 0.0;
+
+   double Xw[] = { 0.0, 40.0 };
+   double Yw[] = { 0.0, -30.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double a0[] = { -0.01, -0.01, 0.001, -2.0, 1.0, 1300.0 };
+   double a1[] = { -0.02,  0.01, 0.000, -1.0, 2.0, 1250.0 };
+   double a2[] = {  0.00,  0.00, 0.000,  0.0, 0.0,  400.0 };
+   double* a[] = { a0, a1, a2 };
+
+   const int nX = 30;
+   const int nY = 25;
+   PointSet S( -145.0, -123.0, 10.0, 10.0, nX, nY, 2, Xw, Yw, Qw, 5.0, 5.0 );
+
+   Matrix Phi, Heads, Chunk;
+   EvaluatePotential( S, 3, a, Phi );
+   EvaluateHeads( S, k, H, Base, 3, a, Heads );
+   EvaluateHeads( S, k, H, Base, 2, a+1, Chunk );
+
+   flag &= (Heads.nRows() == 3 && Heads.nCols() == nX*nY);
+   flag &= (Chunk.nRows() == 2 && Chunk.nCols() == nX*nY);
+
+   for (int i=0; i<3; ++i)
+   {
+      for (int j=0; j<S.nPoints(); ++j)
+      {
+         double dX = S.X()[j] - 5.0;
+         double dY = S.Y()[j] - 5.0;
+
+         double phi = a[i][0]*dX*dX + a[i][1]*dY*dY + a[i][2]*dX*dY + a[i][3]*dX + a[i][4]*dY + a[i][5]
+                    + WellPotential( S.X()[j], S.Y()[j], 2, Xw, Yw, Qw );
+
+         flag &= ApproxEqual( Phi(i,j), phi, 1e-8 );
+         flag &= ApproxEqual( Heads(i,j), PhiToHead( phi, k, H, Base ), 1e-6 );
+
+         if (i > 0)
+            flag &= (Chunk(i-1,j) == Heads(i,j));
+      }
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// TestEvaluateDischarge
+//-----------------------------------------------------------------------------
+bool TestEvaluateDischarge()
+{
+   bool flag = true;
+
+   double Xw[] = { 0.0, 40.0 };
+   double Yw[] = { 0.0, -30.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   double a0[] = { -0.01, -0.01, 0.001, -2.0, 1.0, 1300.0 };
+   double a1[] = { -0.02,  0.01, 0.004, -1.0, 2.0, 1250.0 };
+   double* a[] = { a0, a1 };
+
+   double X[] = { 17.0, -60.0, 33.0, 0.5 };
+   double Y[] = { 23.0, 41.0, -80.0, 0.5 };
+   PointSet S( 4, X, Y, 2, Xw, Yw, Qw, 5.0, -5.0 );
+
+   Matrix Qx, Qy;
+   EvaluateDischarge( S, 2, a, Qx, Qy );
+
+   flag &= (Qx.nRows() == 2 && Qx.nCols() == 4);
+   flag &= (Qy.nRows() == 2 && Qy.nCols() == 4);
+
+   for (int i=0; i<2; ++i)
+   {
+      for (int j=0; j<4; ++j)
+      {
+         double qx, qy;
+         Discharge( a[i], X[j], Y[j], 2, Xw, Yw, Qw, 5.0, -5.0, qx, qy );
+
+         flag &= ApproxEqual( Qx(i,j), qx, 1e-10 );
+         flag &= ApproxEqual( Qy(i,j), qy, 1e-10 );
+      }
+   }
+
+   return flag;
+}
+
+} // namespace oneka
@@ -40,10 +40,26 @@
 #include <assert.h>
 #include <iostream>
 
+#include "test_analytic_field.h"
+#include "test_basis_engine.h"
+#include "test_capture_zone.h"
+#include "test_diagnostics.h"
+#include "test_engine_batch.h"
+#include "test_engine_cache.h"
+#include "test_engine_jobs.h"
+#include "test_engine_protocol.h"
+#include "test_ensemble_statistics.h"
+#include "test_fitted_model.h"
 #include "test_gaussian.h"
+#include "test_head_field.h"
 #include "test_matrix.h"
 #include "test_linear_systems.h"
 #include "test_oneka_engine.h"
+#include "test_origin_shift.h"
+#include "test_realization_file.h"
+#include "test_stagnation_points.h"
+#include "test_synthetic_site.h"
+#include "test_trace.h"
 
 #include "..\Engine\now.h"
 #include "..\Engine\version.h"
@@ -96,6 +112,7 @@ int _tmain(int argc, _TCHAR* argv[])
    flag &= RUN_TEST( TestMatrixMultiply_MtM() );
    flag &= RUN_TEST( TestMatrixMultiply_MMt() );
    flag &= RUN_TEST( TestMatrixMultiply_MtMt() );
+   flag &= RUN_TEST( TestMatrixFile() );
 
    // Test oneka::linear_systems
    flag &= RUN_TEST( TestCholeskyDecomposition() );
@@ -107,9 +124,79 @@ int _tmain(int argc, _TCHAR* argv[])
    flag &= RUN_TEST( TestGaussianCDF() );
    flag &= RUN_TEST( TestGaussianRNG() );
    flag &= RUN_TEST( TestMVNormalRNG() );
+   flag &= RUN_TEST( TestRandomStream() );
 
    // Test oneka::oneka_engine
    flag &= RUN_TEST( TestEngine() );
+   flag &= RUN_TEST( TestEngineDerived() );
+   flag &= RUN_TEST( TestEnginePrior() );
+   flag &= RUN_TEST( TestEngineCollapse() );
+   flag &= RUN_TEST( TestEngineMonitor() );
+   flag &= RUN_TEST( TestEngineSeed() );
+   flag &= RUN_TEST( TestEngineInstrumentation() );
+
+   // Test oneka::head_field
+   flag &= RUN_TEST( TestPhiToHead() );
+   flag &= RUN_TEST( TestPointSet() );
+   flag &= RUN_TEST( TestEvaluateHeads() );
+   flag &= RUN_TEST( TestEvaluateDischarge() );
+
+   // Test oneka::ensemble_statistics
+   flag &= RUN_TEST( TestEnsembleStatistics() );
+   flag &= RUN_TEST( TestEnsembleStatisticsMerge() );
+   flag &= RUN_TEST( TestAccumulateHeads() );
+
+   // Test oneka::analytic_field
+   flag &= RUN_TEST( TestAnalyticHeads() );
+
+   // Test oneka::capture_zone
+   flag &= RUN_TEST( TestDischarge() );
+   flag &= RUN_TEST( TestCaptureProbability() );
+   flag &= RUN_TEST( TestCaptureNoWells() );
+
+   // Test oneka::stagnation_points
+   flag &= RUN_TEST( TestStagnationPoints() );
+
+   // Test oneka::fitted_model
+   flag &= RUN_TEST( TestFittedModel() );
+   flag &= RUN_TEST( TestFittedModelPrior() );
+
+   // Test oneka::diagnostics
+   flag &= RUN_TEST( TestLeaveOneOutDiagnostics() );
+
+   // Test oneka::origin_shift
+   flag &= RUN_TEST( TestShiftOrigin() );
+
+   // Test oneka::basis_engine
+   flag &= RUN_TEST( TestFitBasis() );
+   flag &= RUN_TEST( TestSimulateBasis() );
+
+   // Test oneka::engine_batch
+   flag &= RUN_TEST( TestEngineBatch() );
+   flag &= RUN_TEST( TestEngineLanes() );
+   flag &= RUN_TEST( TestEngineBatchCancel() );
+
+   // Test oneka::engine_jobs
+   flag &= RUN_TEST( TestEnginePool() );
+
+   // Test oneka::engine_protocol
+   flag &= RUN_TEST( TestEngineRequestCoding() );
+   flag &= RUN_TEST( TestEngineResponseCoding() );
+
+   // Test oneka::engine_cache
+   flag &= RUN_TEST( TestEngineCache() );
+   flag &= RUN_TEST( TestEngineCacheDisk() );
+
+   // Test oneka::trace
+   flag &= RUN_TEST( TestTrace() );
+
+   // Test oneka::synthetic_site
+   flag &= RUN_TEST( TestSyntheticSite() );
+   flag &= RUN_TEST( TestSyntheticRecovery() );
+
+   // Test oneka::realization_file
+   flag &= RUN_TEST( TestRealizationFile() );
+   flag &= RUN_TEST( TestRealizationFileFailure() );
 
    // A happy message...
    if (flag)
@@ -39,6 +39,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 
 #include "..\Engine\matrix.h"
 #include "utility.h"
@@ -478,4 +479,42 @@ bool TestMatrixQuadraticForm_MMM()
 }
 
 
+//-----------------------------------------------------------------------------
+// TestMatrixFile
+//-----------------------------------------------------------------------------
+bool TestMatrixFile()
+{
+   bool flag = true;
+   const char* name = "test_matrix_file.omx";
+
+   Matrix A("1,2,3; 4,5,6; 7.25,-8.5,1e-300; 0.1,0.2,0.3");
+   Matrix B;
+
+   flag &= SaveMatrix( name, A ) && LoadMatrix( name, B );
+   flag &= ( B.nRows() == 4 && B.nCols() == 3 );
+   for (int i=0; i<A.nRows(); ++i)
+      for (int j=0; j<A.nCols(); ++j)
+         flag &= ( A(i,j) == B(i,j) );
+
+   // Floats are widened on loading.
+   Matrix C("1.5,-2.25; 3.1,4.2");
+   flag &= SaveMatrix( name, C, MATRIX_FLOAT32 ) && LoadMatrix( name, B );
+   flag &= ( B(0,0) == 1.5 && B(0,1) == -2.25 && B(1,0) == double( 3.1f ) && B(1,1) == double( 4.2f ) );
+
+   MatrixFileHeader H;
+   flag &= LoadMatrixHeader( name, H ) && H.Type == MATRIX_FLOAT32 && H.nRows == 2 && H.nCols == 2;
+
+   // A truncated file is rejected.
+   std::FILE* fp = std::fopen( name, "wb" );
+   std::fwrite( &H, sizeof(H), 1, fp );
+   std::fclose( fp );
+   flag &= !LoadMatrix( name, B ) && B.nRows() == 0;
+
+   std::remove( name );
+   flag &= !LoadMatrix( name, B );
+
+   return flag;
+}
+
+
 } // namespace oneka
@@ -89,6 +89,8 @@ bool TestMatrixMultiply_MtMt();
 bool TestMatrixQuadraticForm_MtMM();
 bool TestMatrixQuadraticForm_MMM();
 
+bool TestMatrixFile();
+
 } // namespace onkea_bayes
 
 //=============================================================================
@@ -38,10 +38,13 @@
 //=============================================================================
 #include "test_oneka_engine.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 #include "..\Engine\oneka_engine.h"
+#include "..\Engine\oneka_model.h"
 #include "utility.h"
 
 namespace oneka{
@@ -179,4 +182,461 @@ bool TestEngine()
    return flag;
 }
 
+//-----------------------------------------------------------------------------
+bool TestEngineDerived()
+{
+   bool flag = true;
+
+   // The same test case as TestEngine.
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 1;
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30 };
+
+   int P = 8;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double Ep[] = { 45.2103543000137, 45.4674132751695, 51.4397613593277, 53.2728566993506,
+                   53.4397613593277, 49.6717794118054, 47.3706252432113, 40.3396290257491 };
+   double Sp[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+   double Xo = 10;
+   double Yo = -20;
+
+   int nSims = 2000;
+
+   EngineOptions Options;
+   Options.KeepDerived = true;
+   Options.SummarizeDerived = true;
+
+   EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, nSims, Options );
+
+   // The kept values match the realizations.
+   if( S.Derived.nRows() != nSims || S.Derived.nCols() != N_DERIVED ) return false;
+
+   for (int i=0; i<nSims; ++i)
+   {
+      const double* a = S.a[i];
+
+      flag &= ApproxEqual( S.Derived(i,DERIVED_RECHARGE), -2*(a[0] + a[1]), 1e-12 );
+      flag &= ApproxEqual( S.Derived(i,DERIVED_GRADIENT), sqrt(a[3]*a[3] + a[4]*a[4]), 1e-12 );
+      flag &= ApproxEqual( S.Derived(i,DERIVED_DIRECTION), atan2(-a[4], -a[3]), 1e-12 );
+
+      // The gradient of the quadratic vanishes at the stationary point.
+      double dX = S.Derived(i,DERIVED_STATIONARY_X) - Xo;
+      double dY = S.Derived(i,DERIVED_STATIONARY_Y) - Yo;
+      double tol = 1e-10*(1 + fabs(dX) + fabs(dY));
+      flag &= ApproxEqual( 2*a[0]*dX + a[2]*dY + a[3], 0.0, tol );
+      flag &= ApproxEqual( a[2]*dX + 2*a[1]*dY + a[4], 0.0, tol );
+   }
+
+   // The summary agrees with the kept values.
+   if( S.DerivedStats.Count() != nSims ) return false;
+
+   Matrix Mean, Min, Max, Q;
+   S.DerivedStats.Mean( Mean );
+   S.DerivedStats.Min( Min );
+   S.DerivedStats.Max( Max );
+   S.DerivedStats.Quantiles( Q );
+
+   for (int j=0; j<N_DERIVED; ++j)
+   {
+      double sum = 0;
+      double lo  = S.Derived(0,j);
+      double hi  = S.Derived(0,j);
+      for (int i=0; i<nSims; ++i)
+      {
+         sum += S.Derived(i,j);
+         lo = std::min( lo, S.Derived(i,j) );
+         hi = std::max( hi, S.Derived(i,j) );
+      }
+
+      flag &= RelativeEqual( Mean(0,j), sum/nSims, 1e-10 );
+      flag &= ( Min(0,j) == lo && Max(0,j) == hi );
+      flag &= ( Q(0,j) <= Q(1,j) && Q(1,j) <= Q(2,j) );
+   }
+
+   // The recharge is linear in the coefficients.
+   flag &= ApproxEqual( Mean(0,DERIVED_RECHARGE), -2*(S.Mu[0] + S.Mu[1]), 
+      0.1*2*sqrt( S.Cov[0][0] + S.Cov[1][1] + 2*S.Cov[0][1] ) );
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+bool TestEnginePrior()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   int P = 10;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   double Xo = 10;
+   double Yo = -20;
+
+   // All of the readings at once.
+   EngineReturn All = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, 1 );
+
+   // The first six, and then the last four using the first as the prior.
+   EngineReturn First = Engine( k, H, Base, W, Xw, Yw, Qw, 6, Xp, Yp, Ep, Sp, Xo, Yo, 1 );
+
+   EngineOptions Options;
+   Options.UsePrior = true;
+   for (int i=0; i<6; ++i)
+   {
+      Options.PriorMu[i] = First.Mu[i];
+      for (int j=0; j<6; ++j)
+         Options.PriorCov[i][j] = First.Cov[i][j];
+   }
+
+   EngineReturn Second = Engine( k, H, Base, W, Xw, Yw, Qw, 4, Xp+6, Yp+6, Ep+6, Sp+6, Xo, Yo, 1, Options );
+
+   for (int i=0; i<6; ++i)
+   {
+      flag &= ApproxEqual( Second.Mu[i], All.Mu[i], 1e-8*(1 + fabs(All.Mu[i])) );
+      for (int j=0; j<6; ++j)
+         flag &= ApproxEqual( Second.Cov[i][j], All.Cov[i][j], 1e-8*sqrt(All.Cov[i][i]*All.Cov[j][j]) );
+   }
+
+   // A singular prior is refused.
+   Options.PriorCov[0][0] = 0;
+
+   bool singular = false;
+   try
+   {
+      Engine( k, H, Base, W, Xw, Yw, Qw, 4, Xp+6, Yp+6, Ep+6, Sp+6, Xo, Yo, 1, Options );
+   }
+   catch( Exception_SingularSystem& )
+   {
+      singular = true;
+   }
+   flag &= singular;
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+bool TestEngineCollapse()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   // Eight locations; repeated readings at most of them, interleaved.
+   double X8[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Y8[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double E8[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34 };
+
+   const int P = 40;
+   double Xp[P], Yp[P], Ep[P], Sp[P];
+   for (int p=0; p<P; ++p)
+   {
+      int g = (3*p + p/8) % 8;
+      if( p >= 32 && g == 5 ) g = 4;      // location 5 is read only a few times.
+      Xp[p] = X8[g];
+      Yp[p] = Y8[g];
+      Ep[p] = E8[g] + 0.3*sin( 1.7*p );
+      Sp[p] = 0.5 + 0.25*(p % 5);
+   }
+
+   double Xo = 10;
+   double Yo = -20;
+
+   // The grouping.
+   std::vector<int> Group;
+   int nGroups = CollapseObservations( P, Xp, Yp, Group );
+
+   int next = 0;
+   for (int p=0; p<P; ++p)
+   {
+      if( Group[p] == next ) ++next;
+      flag &= ( Group[p] < next );
+      for (int q=0; q<p; ++q)
+         flag &= ( Xp[p] == Xp[q] && Yp[p] == Yp[q] ) == ( Group[p] == Group[q] );
+   }
+   flag &= ( next == nGroups && nGroups == 8 );
+
+   // Distinct locations are their own groups.
+   flag &= ( CollapseObservations( 8, X8, Y8, Group ) == 8 );
+   for (int p=0; p<8; ++p)
+      flag &= ( Group[p] == p );
+
+   // The fits with and without collapsing; collapsing is off by default.
+   EngineOptions Full;
+   EngineOptions Collapsed;
+   Collapsed.CollapseReadings = true;
+   flag &= !Full.CollapseReadings;
+
+   EngineReturn A = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, 1, Full );
+   EngineReturn B = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, 1, Collapsed );
+
+   for (int i=0; i<6; ++i)
+   {
+      flag &= ApproxEqual( B.Mu[i], A.Mu[i], 1e-9*(1 + fabs(A.Mu[i])) );
+      for (int j=0; j<6; ++j)
+         flag &= ApproxEqual( B.Cov[i][j], A.Cov[i][j], 1e-9*sqrt(A.Cov[i][i]*A.Cov[j][j]) );
+   }
+
+   // Distinct locations are not affected at all.
+   EngineReturn C = Engine( k, H, Base, W, Xw, Yw, Qw, 8, X8, Y8, E8, Sp, Xo, Yo, 1, Collapsed );
+   EngineReturn D = Engine( k, H, Base, W, Xw, Yw, Qw, 8, X8, Y8, E8, Sp, Xo, Yo, 1, Full );
+
+   for (int i=0; i<6; ++i)
+   {
+      flag &= ( C.Mu[i] == D.Mu[i] );
+      for (int j=0; j<6; ++j)
+         flag &= ( C.Cov[i][j] == D.Cov[i][j] );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+namespace{
+
+   // Count the progress reports, and cancel after the first nAllowed.
+   class CountingMonitor : public oneka::EngineMonitor
+   {
+   public:
+      CountingMonitor( int nAllowed ) : m_nAllowed( nAllowed ), m_nReports( 0 ), m_nDone( 0 ) {}
+
+      bool Cancelled() { return m_nReports >= m_nAllowed; }
+      void Progress( int nDone, int /*nSims*/ ) { ++m_nReports; m_nDone = nDone; }
+
+      int m_nAllowed;
+      int m_nReports;
+      int m_nDone;
+   };
+}
+
+bool TestEngineMonitor()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 1;
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30 };
+
+   int P = 8;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double Ep[] = { 45.2103543000137, 45.4674132751695, 51.4397613593277, 53.2728566993506,
+                   53.4397613593277, 49.6717794118054, 47.3706252432113, 40.3396290257491 };
+   double Sp[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+   const int nSims = 10000;
+
+   // Progress is reported up to completion.
+   {
+      CountingMonitor Monitor( 1000 );
+      EngineOptions Options;
+      Options.Monitor = &Monitor;
+
+      EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options );
+      flag &= ( Monitor.m_nReports > 1 && Monitor.m_nDone == nSims );
+
+      for (int i=0; i<nSims; ++i) delete [] S.a[i];
+      delete [] S.a;
+   }
+
+   // Cancelled after the first chunk.
+   {
+      CountingMonitor Monitor( 1 );
+      EngineOptions Options;
+      Options.Monitor = &Monitor;
+
+      bool cancelled = false;
+      try
+      {
+         Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options );
+      }
+      catch( Exception_Cancelled& )
+      {
+         cancelled = true;
+      }
+      flag &= cancelled && ( Monitor.m_nReports == 1 && Monitor.m_nDone < nSims );
+   }
+
+   // Cancelled before starting.
+   {
+      CountingMonitor Monitor( 0 );
+      EngineOptions Options;
+      Options.Monitor = &Monitor;
+
+      bool cancelled = false;
+      try
+      {
+         Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options );
+      }
+      catch( Exception_Cancelled& )
+      {
+         cancelled = true;
+      }
+      flag &= cancelled && ( Monitor.m_nReports == 0 );
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+bool TestEngineSeed()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 1;
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30 };
+
+   int P = 8;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double Ep[] = { 45.2103543000137, 45.4674132751695, 51.4397613593277, 53.2728566993506,
+                   53.4397613593277, 49.6717794118054, 47.3706252432113, 40.3396290257491 };
+   double Sp[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+   const int nSims = 500;
+
+   // Without a seed, each run draws one from the global generator ...
+   InitializeRNG( 97 );
+   EngineReturn S1 = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims );
+   EngineReturn S2 = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims );
+   flag &= ( S1.Seed != S2.Seed && S1.Stream == 0 && S1.a[0][0] != S2.a[0][0] );
+
+   InitializeRNG( 97 );
+   EngineReturn S3 = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims );
+   flag &= ( S3.Seed == S1.Seed );
+
+   // ... and the recorded seed and stream reproduce the realizations.
+   EngineOptions Options;
+   Options.UseSeed = true;
+   Options.Seed = S2.Seed;
+   Options.Stream = S2.Stream;
+
+   EngineReturn R = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options );
+   flag &= ( R.Seed == S2.Seed && R.Stream == S2.Stream );
+   for (int i=0; i<nSims; ++i)
+      for (int j=0; j<6; ++j)
+         flag &= ( R.a[i][j] == S2.a[i][j] );
+
+   // Different streams of one seed are different realizations.
+   Options.Stream = S2.Stream + 1;
+   EngineReturn T = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options );
+   flag &= ( T.Stream == S2.Stream + 1 && T.a[0][0] != S2.a[0][0] );
+
+   EngineReturn* all[] = { &S1, &S2, &S3, &R, &T };
+   for (int s=0; s<5; ++s)
+   {
+      for (int i=0; i<nSims; ++i) delete [] all[s]->a[i];
+      delete [] all[s]->a;
+   }
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+bool TestEngineInstrumentation()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   int W = 1;
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30 };
+
+   int P = 9;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100, 100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100,   0 };
+   double Ep[] = { 45.2103543000137, 45.4674132751695, 51.4397613593277, 53.2728566993506,
+                   53.4397613593277, 49.6717794118054, 47.3706252432113, 40.3396290257491, 45.3 };
+   double Sp[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+   const int nSims = 5000;
+
+   // Not requested.
+   {
+      EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims );
+      flag &= !S.Instrumentation.Valid;
+
+      for (int i=0; i<nSims; ++i) delete [] S.a[i];
+      delete [] S.a;
+   }
+
+   // Requested, twice on one workspace; the repeated reading is collapsed.
+   EngineOptions Options;
+   Options.Instrument = true;
+   Options.CollapseReadings = true;
+   RandomStream Stream( 1 );
+   EngineWorkspace Work;
+   EngineInstrumentation first;
+
+   for (int run=0; run<2; ++run)
+   {
+      EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, 0, 0, nSims, Options, Stream, &Work );
+      const EngineInstrumentation& I = S.Instrumentation;
+
+      flag &= I.Valid;
+      flag &= ( I.W == W && I.P == P && I.nRows == P-1 && I.nSims == nSims );
+
+      double sum = 0;
+      for (int i=0; i<N_PHASES; ++i)
+      {
+         flag &= ( I.Seconds[i] >= 0 );
+         sum += I.Seconds[i];
+      }
+      flag &= ( I.TotalSeconds > 0 && ApproxEqual( sum, I.TotalSeconds, 1e-9 ) );
+
+      // The realizations are always allocated; the workspace only on the
+      // first run.
+      const long long sims_bytes = static_cast<long long>( nSims )*( sizeof(double*) + 6*sizeof(double) );
+      flag &= ( I.Allocations > 1 + nSims && I.AllocatedBytes > sims_bytes );
+
+      if (run == 0)
+         first = I;
+      else
+         flag &= ( I.Allocations < first.Allocations && I.AllocatedBytes < first.AllocatedBytes );
+
+      for (int i=0; i<nSims; ++i) delete [] S.a[i];
+      delete [] S.a;
+   }
+
+   return flag;
+}
+
 } // namespace oneka
@@ -43,6 +43,12 @@
 namespace oneka{
 
 bool TestEngine();
+bool TestEngineDerived();
+bool TestEnginePrior();
+bool TestEngineCollapse();
+bool TestEngineMonitor();
+bool TestEngineSeed();
+bool TestEngineInstrumentation();
 
 } // namespace onkea
 
@@ -0,0 +1,147 @@
+//=============================================================================
+// test_origin_shift.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_origin_shift.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\oneka_engine.h"
+#include "..\Engine\origin_shift.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestShiftOrigin
+//
+//    Shifting the fit must agree with refitting about the new origins, and
+//    shifted realizations must describe the same potential field.
+//-----------------------------------------------------------------------------
+bool TestShiftOrigin()
+{
+   bool flag = true;
+
+   double k = 1;
+   double H = 50;
+   double Base = 0;
+
+   const int W = 2;
+   double Xw[] = { 0.0, 150.0 };
+   double Yw[] = { 0.0, 40.0 };
+   double Qw[] = { 30.0, -10.0 };
+
+   const int P = 10;
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100,  50, -30 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100, -60,  45 };
+   double Ep[] = { 45.21, 45.47, 51.44, 53.27, 53.44, 49.67, 47.37, 40.34, 44.10, 50.80 };
+   double Sp[] = { 1.0, 1.0, 0.5, 1.0, 2.0, 1.0, 1.0, 1.5, 0.8, 1.0 };
+
+   double Xo = 10;
+   double Yo = -20;
+
+   const int nSims = 50;
+   EngineReturn S = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xo, Yo, nSims );
+
+   flag &= ( S.Xo == Xo && S.Yo == Yo );
+
+   const int nOrigins = 3;
+   double Xn[] = { 0.0, 250.0, -75.0 };
+   double Yn[] = { 0.0, 130.0, -310.0 };
+
+   // Mean and covariance.
+   Matrix MuN, CovN;
+   ShiftOrigins( Xo, Yo, nOrigins, Xn, Yn, S.Mu, S.Cov, MuN, CovN );
+
+   for (int n=0; n<nOrigins; ++n)
+   {
+      EngineReturn R = Engine( k, H, Base, W, Xw, Yw, Qw, P, Xp, Yp, Ep, Sp, Xn[n], Yn[n], 1 );
+
+      for (int i=0; i<6; ++i)
+      {
+         flag &= ApproxEqual( MuN(n,i), R.Mu[i], 1e-7*(1 + fabs(R.Mu[i])) );
+         for (int j=0; j<6; ++j)
+            flag &= ApproxEqual( CovN(n,6*i+j), R.Cov[i][j], 1e-7*sqrt(R.Cov[i][i]*R.Cov[j][j]) );
+      }
+
+      delete [] R.a[0];
+      delete [] R.a;
+   }
+
+   // Realizations.
+   Matrix X;
+   ShiftOrigins( Xo, Yo, nOrigins, Xn, Yn, nSims, S.a, X );
+   flag &= ( X.nRows() == nSims && X.nCols() == 6*nOrigins );
+
+   const double x = 37.0;
+   const double y = -81.0;
+
+   for (int i=0; i<nSims; ++i)
+   {
+      const double* a = S.a[i];
+      double dX = x - Xo;
+      double dY = y - Yo;
+      double Phi = a[0]*dX*dX + a[1]*dY*dY + a[2]*dX*dY + a[3]*dX + a[4]*dY + a[5];
+
+      for (int n=0; n<nOrigins; ++n)
+      {
+         const double* b = X.Base(i,6*n);
+         dX = x - Xn[n];
+         dY = y - Yn[n];
+         double PhiN = b[0]*dX*dX + b[1]*dY*dY + b[2]*dX*dY + b[3]*dX + b[4]*dY + b[5];
+
+         flag &= ApproxEqual( PhiN, Phi, 1e-9*(1 + fabs(Phi)) );
+      }
+   }
+
+   // The identity shift.
+   double Mu1[6], Cov1[6][6];
+   ShiftOrigin( Xo, Yo, Xo, Yo, S.Mu, S.Cov, Mu1, Cov1 );
+   for (int i=0; i<6; ++i)
+   {
+      flag &= ( Mu1[i] == S.Mu[i] );
+      for (int j=0; j<6; ++j)
+         flag &= ( Cov1[i][j] == S.Cov[i][j] );
+   }
+
+   for (int i=0; i<nSims; ++i)
+      delete [] S.a[i];
+   delete [] S.a;
+
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,190 @@
+//=============================================================================
+// test_realization_file.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_realization_file.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include "..\Engine\realization_file.h"
+#include "..\Engine\synthetic_site.h"
+#include "utility.h"
+
+namespace{
+   const char* NAME = "test_realizations.orz";
+
+   void FreeRealizations( oneka::EngineReturn& S )
+   {
+      for( int i = 0; i < S.nSims; ++i )
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+
+   // Cancel after the first chunk.
+   class CancelAtOnce : public oneka::EngineMonitor
+   {
+   public:
+      bool Cancelled() { return true; }
+   };
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The file holds exactly the realizations Engine would have returned, and
+// the moments of the run.
+//-----------------------------------------------------------------------------
+bool TestRealizationFile()
+{
+   bool flag = true;
+
+   SyntheticSpec Spec;
+   Spec.nSims = 10000;          // several chunks ...
+   EngineRequest Site;
+   SyntheticSite( Spec, Site );
+
+   EngineInput In = Site.Input();
+   EngineReturn S = Engine( In );
+
+   // ... across many small extents, some splitting a row.
+   {
+      RealizationFile File( NAME, MATRIX_FLOAT64, 40000 );
+      In.Options.Sink = &File;
+      In.Options.SummarizeDerived = true;
+      EngineReturn R = Engine( In );
+
+      flag &= File.Complete() && ( R.a == NULL && R.nSims == Spec.nSims );
+      flag &= ( R.DerivedStats.Count() == Spec.nSims );
+   }
+
+   Matrix X;
+   RealizationHeader H;
+   flag &= LoadMatrix( NAME, X ) && LoadRealizationHeader( NAME, H );
+   flag &= ( X.nRows() == Spec.nSims && X.nCols() == 6 );
+   flag &= ( H.Seed == S.Seed && H.Stream == S.Stream );
+
+   for( int i = 0; flag && i < 6; ++i )
+   {
+      flag &= ( H.Mu[i] == S.Mu[i] );
+      for( int j = 0; j < 6; ++j )
+         flag &= ( H.Cov[i][j] == S.Cov[i][j] );
+   }
+   for( int n = 0; flag && n < S.nSims; ++n )
+      for( int j = 0; j < 6; ++j )
+         flag &= ( X(n,j) == S.a[n][j] );
+
+   // Single precision, without streaming stores.
+   {
+      RealizationFile File( NAME, MATRIX_FLOAT32, 1 << 20, false );
+      In.Options.Sink = &File;
+      Engine( In );
+      flag &= File.Complete();
+   }
+   flag &= LoadMatrix( NAME, X ) && ( X.nRows() == Spec.nSims );
+   for( int n = 0; flag && n < S.nSims; ++n )
+      for( int j = 0; j < 6; ++j )
+         flag &= ( X(n,j) == double( float( S.a[n][j] ) ) );
+
+   std::remove( NAME );
+   FreeRealizations( S );
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// A run that does not complete leaves no file, and a sink that fails 
+// stops the run.
+//-----------------------------------------------------------------------------
+bool TestRealizationFileFailure()
+{
+   bool flag = true;
+
+   SyntheticSpec Spec;
+   Spec.nSims = 10000;
+   EngineRequest Site;
+   SyntheticSite( Spec, Site );
+   EngineInput In = Site.Input();
+
+   // Cancelled.
+   {
+      CancelAtOnce Monitor;
+      RealizationFile File( NAME );
+      In.Options.Sink = &File;
+      In.Options.Monitor = &Monitor;
+
+      bool cancelled = false;
+      try
+      {
+         Engine( In );
+      }
+      catch( Exception_Cancelled& )
+      {
+         cancelled = true;
+      }
+      flag &= cancelled && !File.Complete();
+   }
+   std::FILE* fp = std::fopen( NAME, "rb" );
+   flag &= ( fp == NULL );
+   if( fp != NULL )
+   {
+      std::fclose( fp );
+      std::remove( NAME );
+   }
+
+   // The file cannot be created.
+   {
+      RealizationFile File( "no_such_directory/realizations.orz" );
+      In.Options.Sink = &File;
+      In.Options.Monitor = NULL;
+
+      bool failed = false;
+      try
+      {
+         Engine( In );
+      }
+      catch( Exception_SinkFailure& )
+      {
+         failed = true;
+      }
+      flag &= failed;
+   }
+
+   return flag;
+}
+
+
+} // namespace oneka
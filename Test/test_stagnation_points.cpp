@@ -0,0 +1,116 @@
+//=============================================================================
+// test_stagnation_points.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_stagnation_points.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "..\Engine\oneka_model.h"
+#include "..\Engine\stagnation_points.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestStagnationPoints
+//-----------------------------------------------------------------------------
+bool TestStagnationPoints()
+{
+   bool flag = true;
+
+   const double TWO_PI = 6.283185307179586476925287;
+
+   // A pumping well, an injection well, and a second pumping well.
+   double Xw[] = { 10.0, 400.0, -300.0 };
+   double Yw[] = { -20.0, 300.0, 250.0 };
+   double Qw[] = { 30.0, -5.0, 20.0 };
+
+   // Realization 0: a uniform flow of 0.8 at 30 degrees, and only the 
+   // first well, for which the answer is known.
+   const double theta = TWO_PI/12;
+   const double q0 = 0.8;
+   double a0[] = { 0.0, 0.0, 0.0, -q0*cos(theta), -q0*sin(theta), 1300.0 };
+
+   // Realizations 1 and 2: curved regional fields.
+   double a1[] = { -0.001, -0.002, 0.0005, -1.0, 0.5, 1300.0 };
+   double a2[] = {  0.0005, -0.0003, -0.0002, 0.3, -0.9, 1300.0 };
+
+   // Realization 3: no regional flow at all.
+   double a3[] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1300.0 };
+
+   double* a[] = { a0, a1, a2, a3 };
+
+   Matrix Xs, Ys, Ok;
+
+   // The single well case.
+   StagnationPoints( 1, Xw, Yw, Qw, 0.0, 0.0, 1, a, Xs, Ys, Ok );
+
+   const double s = Qw[0]/(TWO_PI*q0);
+   flag &= (Ok(0,0) == 1);
+   flag &= ApproxEqual( Xs(0,0), Xw[0] + s*cos(theta), 1e-8 );
+   flag &= ApproxEqual( Ys(0,0), Yw[0] + s*sin(theta), 1e-8 );
+
+   // All three wells, all four realizations.
+   StagnationPoints( 3, Xw, Yw, Qw, 5.0, -5.0, 4, a, Xs, Ys, Ok );
+
+   flag &= (Xs.nRows() == 4 && Xs.nCols() == 3);
+
+   for (int i=0; i<3; ++i)
+   {
+      for (int w=0; w<3; w+=2)
+      {
+         flag &= (Ok(i,w) == 1);
+
+         double Qx, Qy;
+         Discharge( a[i], Xs(i,w), Ys(i,w), 3, Xw, Yw, Qw, 5.0, -5.0, Qx, Qy );
+         flag &= ApproxEqual( Qx, 0.0, 1e-9 );
+         flag &= ApproxEqual( Qy, 0.0, 1e-9 );
+
+         // Near its own well.
+         double d = sqrt( (Xs(i,w)-Xw[w])*(Xs(i,w)-Xw[w]) + (Ys(i,w)-Yw[w])*(Ys(i,w)-Yw[w]) );
+         flag &= (d < 100.0);
+      }
+
+      // The injection well has no stagnation point.
+      flag &= (Ok(i,1) == 0);
+      flag &= (Xs(i,1) != Xs(i,1));
+   }
+
+   return flag;
+}
+
+} // namespace oneka
@@ -0,0 +1,141 @@
+//=============================================================================
+// test_synthetic_site.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_synthetic_site.h"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "..\Engine\synthetic_site.h"
+#include "utility.h"
+
+namespace{
+   void FreeRealizations( oneka::EngineReturn& S )
+   {
+      for( int i = 0; i < S.nSims; ++i )
+         delete [] S.a[i];
+      delete [] S.a;
+      S.a = NULL;
+   }
+}
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// The site is the requested size, reproducible, and its heads scatter 
+// about the true heads by the requested noise.
+//-----------------------------------------------------------------------------
+bool TestSyntheticSite()
+{
+   bool flag = true;
+
+   SyntheticSpec Spec;
+   Spec.W = 3;
+   Spec.P = 500;
+   Spec.Seed = 17;
+
+   EngineRequest Site, Again;
+   SyntheticSite( Spec, Site );
+   SyntheticSite( Spec, Again );
+
+   flag &= ( Site.Xw.size() == 3 && Site.Xp.size() == 500 && Site.Sp.size() == 500 );
+   flag &= ( Site.Xp == Again.Xp && Site.Yp == Again.Yp && Site.Ep == Again.Ep && Site.Xw == Again.Xw );
+   flag &= ( Site.nSims == Spec.nSims && Site.Seed == 17 );
+
+   double sum = 0, sum2 = 0;
+   for( int p = 0; p < Spec.P; ++p )
+   {
+      double r = Site.Ep[p] - SyntheticHead( Spec, Site, Site.Xp[p], Site.Yp[p] );
+      sum  += r;
+      sum2 += r*r;
+      flag &= ( Site.Xp[p]*Site.Xp[p] + Site.Yp[p]*Site.Yp[p] <= Spec.Radius*Spec.Radius );
+   }
+   double sd = sqrt( sum2/Spec.P );
+   flag &= ( fabs( sum/Spec.P ) < 0.2*Spec.Noise );
+   flag &= ( sd > 0.8*Spec.Noise && sd < 1.2*Spec.Noise );
+
+   // A different seed is a different site.
+   Spec.Seed = 18;
+   SyntheticSite( Spec, Again );
+   flag &= ( Site.Xp != Again.Xp );
+
+   // A site that is dry everywhere is refused, not sampled forever.
+   Spec.a[5] = -1e6;
+   bool thrown = false;
+   try
+   {
+      SyntheticSite( Spec, Again );
+   }
+   catch( std::runtime_error& e )
+   {
+      thrown = ( std::string( e.what() ).find( "Seed 18" ) != std::string::npos );
+   }
+   flag &= thrown;
+
+   return flag;
+}
+
+//-----------------------------------------------------------------------------
+// Engine recovers the true coefficients, to within its own uncertainty.
+//-----------------------------------------------------------------------------
+bool TestSyntheticRecovery()
+{
+   bool flag = true;
+
+   SyntheticSpec Spec;
+   Spec.W = 2;
+   Spec.P = 400;
+   Spec.nSims = 5000;
+
+   EngineRequest Site;
+   SyntheticSite( Spec, Site );
+   EngineReturn S = Engine( Site.Input() );
+
+   SyntheticAccuracy A = Accuracy( Spec, S );
+
+   // The 0.9999 quantile of chi-square(6) is 27.86.
+   flag &= ( A.Mahalanobis >= 0 && A.Mahalanobis < 27.86 );
+   flag &= ( A.MaxZ < 4.5 && A.SampleZ < 4.5 );
+   flag &= RelativeEqual( S.Mu[5], Spec.a[5], 1e-3 );
+
+   FreeRealizations( S );
+   return flag;
+}
+
+
+} // namespace oneka
@@ -0,0 +1,112 @@
+//=============================================================================
+// test_trace.cpp
+//
+// author:
+//    Dr. Randal J. Barnes
+//    Department of Civil Engineering
+//    University of Minnesota
+//
+// version:
+//    18 July 2011
+//=============================================================================
+
+//=============================================================================
+// Copyright 2011, Randal J. Barnes. 
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without 
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//   2. Redistributions in binary form must reproduce the above copyright 
+//      notice, this list of conditions and the following disclaimer in the 
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY RANDAL J BARNES ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+// EVENT SHALL RANDAL J BARNES OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+// INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "test_trace.h"
+
+#include <cassert>
+#include <sstream>
+#include <string>
+
+#include "..\Engine\now.h"
+#include "..\Engine\oneka_engine.h"
+#include "..\Engine\trace.h"
+#include "utility.h"
+
+namespace oneka{
+
+//-----------------------------------------------------------------------------
+// TestTrace
+//-----------------------------------------------------------------------------
+bool TestTrace()
+{
+   bool flag = true;
+
+   double Xw[] = { 0.0 };
+   double Yw[] = { 0.0 };
+   double Qw[] = { 30 };
+
+   double Xp[] = { 100, 100,   0, -100, -100, -100,    0,  100 };
+   double Yp[] = {   0, 100, 100,  100,    0, -100, -100, -100 };
+   double Ep[] = { 45.2103543000137, 45.4674132751695, 51.4397613593277, 53.2728566993506,
+                   53.4397613593277, 49.6717794118054, 47.3706252432113, 40.3396290257491 };
+   double Sp[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+   TraceClear();
+   {
+      ONEKA_TRACE_THREAD( "test \"main\"" );
+      ONEKA_TRACE_SCOPE( "TestTrace" );
+
+      EngineReturn S = Engine( 1, 50, 0, 1, Xw, Yw, Qw, 8, Xp, Yp, Ep, Sp, 0, 0, 100 );
+      for (int i=0; i<S.nSims; ++i) delete [] S.a[i];
+      delete [] S.a;
+   }
+
+   std::ostringstream os;
+   TraceWriteChrome( os );
+   const std::string trace = os.str();
+
+   flag &= ( trace.find( "{\"traceEvents\":[" ) == 0 );
+   flag &= ( trace.find( "\"displayTimeUnit\":\"ms\"}" ) != std::string::npos );
+
+#ifdef ONEKA_TRACING
+   flag &= ( trace.find( "\"name\":\"TestTrace\"" ) != std::string::npos );
+   flag &= ( trace.find( "\"name\":\"Engine\"" ) != std::string::npos );
+   flag &= ( trace.find( "\"name\":\"Engine solve\"" ) != std::string::npos );
+   flag &= ( trace.find( "\"name\":\"LeastSquaresSolve\"" ) != std::string::npos );
+   flag &= ( trace.find( "\"name\":\"GaussianRNG\"" ) != std::string::npos );
+   flag &= ( trace.find( "\"args\":{\"name\":\"test \\\"main\\\"\"}" ) != std::string::npos );
+
+   // No event begins before the trace.
+   flag &= ( trace.find( "\"ts\":-" ) == std::string::npos );
+
+   // The ring keeps the most recent events.
+   TraceClear();
+   for (int i=0; i<TRACE_BUFFER_EVENTS + 10; ++i)
+      TraceEvent( i < 10 ? "old" : "new", WallClock(), WallClock() );
+
+   std::ostringstream ring;
+   TraceWriteChrome( ring );
+   flag &= ( ring.str().find( "\"name\":\"old\"" ) == std::string::npos );
+   flag &= ( ring.str().find( "\"name\":\"new\"" ) != std::string::npos );
+#else
+   flag &= ( trace.find( "\"ph\":\"X\"" ) == std::string::npos );
+#endif
+
+   TraceClear();
+   return flag;
+}
+
+} // namespace oneka